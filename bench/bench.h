@@ -0,0 +1,110 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_BENCH_H
+#define VSP_BENCH_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "vsp.h"
+
+namespace bench {
+
+using namespace vsp;
+
+// returns the average wall time of fn in seconds
+template <typename FN>
+double measure(size_t iterations, FN&& fn) {
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++)
+        fn();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t1 - t0).count() / iterations;
+}
+
+inline string frame(const string& payload) {
+    string escaped;
+    u8 csum = 0;
+    for (char c : payload) {
+        if (c == '$' || c == '#' || c == '*' || c == '}')
+            escaped += { '}', char(c ^ 0x20) };
+        else
+            escaped += c;
+    }
+
+    for (char c : escaped)
+        csum += static_cast<u8>(c);
+
+    return "$" + escaped + mkstr("#%02x", csum);
+}
+
+// single client server that answers every packet using the given handler
+class server
+{
+private:
+    mwr::server_socket m_socket;
+    function<string(const string&)> m_handler;
+    std::atomic<bool> m_stop;
+    std::thread m_thread;
+
+    void serve() {
+        try {
+            while (m_socket.clients().empty()) {
+                if (m_stop)
+                    return;
+                m_socket.poll(10);
+            }
+
+            int client = m_socket.clients()[0];
+            while (true) {
+                string cmd;
+                char c;
+                while (m_socket.recv_char(client) != '$')
+                    ;
+                while ((c = m_socket.recv_char(client)) != '#')
+                    cmd += c;
+                m_socket.recv_char(client);
+                m_socket.recv_char(client);
+                m_socket.send(client, "+");
+
+                string resp = frame(m_handler(cmd));
+                m_socket.send(client, resp.data(), resp.size());
+                m_socket.recv_char(client);
+            }
+        } catch (mwr::report&) {
+            // client disconnected
+        }
+    }
+
+public:
+    const char* host() const { return m_socket.host(); }
+    u16 port() const { return m_socket.port(); }
+
+    server(function<string(const string&)> handler):
+        m_socket(1, 0),
+        m_handler(std::move(handler)),
+        m_stop(false),
+        m_thread() {
+        m_thread = std::thread(&server::serve, this);
+    }
+
+    // clients must disconnect before the server goes away
+    ~server() {
+        m_stop = true;
+        m_thread.join();
+    }
+};
+
+} // namespace bench
+
+#endif
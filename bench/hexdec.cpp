@@ -0,0 +1,73 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "bench.h"
+
+using namespace bench;
+
+// the original decode path: tokenize the payload, then convert each field
+static void legacy_decode(const string& payload, u8* out, size_t size) {
+    vector<string> fields = split(payload, ',');
+    MWR_REPORT_ON(fields.size() != size, "malformed payload");
+    for (size_t i = 0; i < size; i++)
+        out[i] = (u8)stoul(fields[i], nullptr, 16);
+}
+
+static string payload(size_t size) {
+    string s;
+    for (size_t i = 0; i < size; i++)
+        s += mkstr(i ? ",%02zx" : "%02zx", (i * 37) & 0xff);
+    return s;
+}
+
+int main(int argc, char** argv) {
+    const size_t sizes[] = { 64, 1024, 16 * 1024, 1024 * 1024 };
+    const struct {
+        const char* name;
+        hex_decoder impl;
+    } decoders[] = {
+        { "scalar", HEX_DECODER_SCALAR },
+        { "sse2", HEX_DECODER_SSE2 },
+        { "avx2", HEX_DECODER_AVX2 },
+    };
+
+    cout << "payload   decoder   time [us]     MB/s   speedup" << endl;
+    for (size_t size : sizes) {
+        string data = payload(size);
+        vector<u8> out(size);
+        size_t iterations = std::max<size_t>(8, (64 << 20) / data.size());
+
+        double legacy = measure(iterations / 8 + 1, [&]() {
+            legacy_decode(data, out.data(), size);
+        });
+
+        auto report = [&](const char* name, double t) {
+            cout << std::setw(6) << size << "B  " << std::left << std::setw(8)
+                 << name << std::right << std::fixed << std::setprecision(3)
+                 << std::setw(11) << t * 1e6 << std::setw(9)
+                 << std::setprecision(0) << size / t / 1e6 << std::setw(9)
+                 << std::setprecision(1) << legacy / t << "x" << endl;
+        };
+
+        report("legacy", legacy);
+        for (const auto& dec : decoders) {
+            if (!hex_decoder_supported(dec.impl))
+                continue;
+
+            double t = measure(iterations, [&]() {
+                MWR_REPORT_ON(!decode_hex(data, out.data(), size, dec.impl),
+                              "malformed payload");
+            });
+
+            report(dec.name, t);
+        }
+    }
+
+    return 0;
+}
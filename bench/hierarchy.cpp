@@ -0,0 +1,273 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "bench.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace bench;
+
+struct result {
+    double seconds;
+    size_t peak;
+    size_t modules;
+};
+
+enum mode {
+    BUFFERED,
+    STREAMED,
+    LAZY,
+    CACHED,
+};
+
+// the cluster starting at cpu i, with or without its cpus
+static string make_cluster(size_t n, size_t i, bool contents) {
+    string xml = mkstr("<object name=\"cluster%zu\" kind=\"cluster\"", i);
+    if (!contents)
+        return xml + " truncated=\"true\" />";
+
+    xml += ">";
+    for (size_t j = i; j < std::min(n, i + 1000); j++) {
+        xml += mkstr("<object name=\"cpu%zu\" kind=\"cpu\" "
+                     "version=\"1.0\">",
+                     j);
+        xml += "<attribute name=\"freq\" type=\"u64\" count=\"1\" />";
+        xml += "<command name=\"reset\" argc=\"0\" desc=\"resets\" />";
+        xml += "</object>";
+    }
+
+    return xml + "</object>";
+}
+
+// n cpus in clusters of up to a thousand, each with an attribute and a
+// command like most models have
+static string make_listing(size_t n, bool contents = true) {
+    string xml = "OK,<hierarchy><object name=\"system\" kind=\"soc\">";
+    for (size_t i = 0; i < n; i += 1000)
+        xml += make_cluster(n, i, contents);
+
+    xml += "</object></hierarchy>";
+    return xml;
+}
+
+// answers the subtree listings of lazy clients, which first ask for two
+// levels below the root and then for single clusters
+static string make_subtree(size_t n, const string& cmd) {
+    const string prefix = "list,xml,system.cluster";
+    if (cmd.compare(0, prefix.size(), prefix) != 0)
+        return make_listing(n, false);
+
+    size_t i = stoull(cmd.substr(prefix.size()));
+    return "OK,<hierarchy>" + make_cluster(n, i, true) + "</hierarchy>";
+}
+
+// resident memory of this process in bytes
+static size_t resident() {
+    ifstream statm("/proc/self/statm");
+    size_t size = 0, pages = 0;
+    statm >> size >> pages;
+    return pages * sysconf(_SC_PAGESIZE);
+}
+
+// Runs fn in a child process and measures its wall time and how far its
+// resident memory grew, so neither the server nor earlier runs count. The
+// kernel does not reliably keep a high water mark of short peaks, so it
+// gets sampled every millisecond instead.
+template <typename FN>
+static result isolated(FN&& fn) {
+    int fds[2];
+    MWR_REPORT_ON(pipe(fds) < 0, "cannot create pipe");
+
+    pid_t pid = fork();
+    MWR_REPORT_ON(pid < 0, "cannot fork");
+    if (pid == 0) {
+        close(fds[0]);
+        size_t base = resident();
+        std::atomic<size_t> peak(base);
+        std::atomic<bool> stop(false);
+        std::thread sampler([&peak, &stop]() {
+            while (!stop) {
+                peak = std::max<size_t>(peak, resident());
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        auto t0 = std::chrono::steady_clock::now();
+        result res;
+        res.modules = fn();
+        auto t1 = std::chrono::steady_clock::now();
+        stop = true;
+        sampler.join();
+
+        res.seconds = std::chrono::duration<double>(t1 - t0).count();
+        res.peak = std::max<size_t>(peak, resident()) - base;
+        ssize_t n = write(fds[1], &res, sizeof(res));
+        _exit(n == sizeof(res) ? 0 : 1);
+    }
+
+    close(fds[1]);
+    result res{};
+    ssize_t n = read(fds[0], &res, sizeof(res));
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    MWR_REPORT_ON(n != sizeof(res), "benchmark child failed");
+    return res;
+}
+
+// Serves the listing from a child process until done gets closed, the
+// listing and its framed copy never show up in the memory of the client.
+static pid_t start_server(size_t n, u16& port, int& done) {
+    int portfds[2], donefds[2];
+    MWR_REPORT_ON(pipe(portfds) < 0 || pipe(donefds) < 0,
+                  "cannot create pipe");
+
+    pid_t pid = fork();
+    MWR_REPORT_ON(pid < 0, "cannot fork");
+    if (pid == 0) {
+        close(portfds[0]);
+        close(donefds[1]);
+
+        string listing = make_listing(n);
+        {
+            server srv([&listing, n](const string& cmd) {
+                return cmd == "list,xml" ? listing : make_subtree(n, cmd);
+            });
+            u16 p = srv.port();
+            ssize_t w = write(portfds[1], &p, sizeof(p));
+            char c;
+            while (w == sizeof(p) && read(donefds[0], &c, 1) > 0)
+                ;
+        }
+
+        _exit(0);
+    }
+
+    close(portfds[1]);
+    close(donefds[0]);
+    ssize_t r = read(portfds[0], &port, sizeof(port));
+    close(portfds[0]);
+    MWR_REPORT_ON(r != sizeof(port), "benchmark server failed");
+    done = donefds[1];
+    return pid;
+}
+
+// stores the hierarchy of make_listing(n) like a first connect would
+static void prepare_cache(size_t n, const string& dir, const string& key) {
+    string listing = make_listing(n).substr(3);
+    connection conn;
+    hierarchy hier(conn);
+    hierarchy_reader reader(hier);
+    reader.feed(listing);
+    reader.finish();
+
+    u64 digest = fnv1a64((const u8*)listing.data(), listing.size());
+    hierarchy_cache(dir).store(key, digest, hier, {});
+}
+
+static result run(size_t n, mode m) {
+    u16 port = 0;
+    int done = -1;
+    pid_t server = start_server(n, port, done);
+
+    string dir = (fs::temp_directory_path() / "vsp_bench_cache").string();
+    string key = "bench";
+    if (m == CACHED)
+        prepare_cache(n, dir, key);
+
+    result res = isolated([port, m, &dir, &key]() {
+        connection conn("localhost", port);
+        hierarchy hier(conn);
+
+        // the listing is only hashed to confirm the image is up to date
+        if (m == CACHED) {
+            u64 digest = FNV1A64_INIT;
+            conn.request_stream("list,xml", [&digest](const char* data,
+                                                      size_t size) {
+                digest = fnv1a64((const u8*)data, size, digest);
+            });
+
+            vector<target_desc> targets;
+            MWR_REPORT_ON(!hierarchy_cache(dir).load(key, digest, hier,
+                                                     targets),
+                          "hierarchy not cached");
+            size_t modules = hier.num_modules();
+            conn.disconnect();
+            return modules;
+        }
+
+        // a one-shot script that looks at a single attribute
+        if (m == LAZY) {
+            hier.load(2);
+            module* root = hier.root();
+            MWR_REPORT_ON(!root->find_attribute("system.cluster0.cpu0.freq"),
+                          "attribute not found");
+            size_t modules = hier.num_modules();
+            conn.disconnect();
+            return modules;
+        }
+
+        hierarchy_reader reader(hier);
+
+        // a buffered listing stays around until the hierarchy is built
+        response resp;
+        if (m == STREAMED) {
+            conn.request_stream("list,xml", [&reader](const char* data,
+                                                      size_t size) {
+                reader.feed(data, size);
+            });
+        } else {
+            resp = conn.request("list,xml", 2);
+            reader.feed(resp.at(1));
+        }
+
+        reader.finish();
+        size_t modules = hier.num_modules();
+        conn.disconnect();
+        return modules;
+    });
+
+    close(done);
+    waitpid(server, nullptr, 0);
+    fs::remove_all(dir);
+    return res;
+}
+
+int main(int argc, char** argv) {
+    const size_t sizes[] = { 1000, 10000, 100000, 1000000 };
+    const double mib = 1024.0 * 1024.0;
+
+    cout << "  modules   listing      buffered [ms]  peak [MiB]"
+         << "      streamed [ms]  peak [MiB]"
+         << "          lazy [ms]  peak [MiB]"
+         << "        cached [ms]  peak [MiB]" << endl;
+    for (size_t n : sizes) {
+        result buffered = run(n, BUFFERED);
+        result streamed = run(n, STREAMED);
+        result lazy = run(n, LAZY);
+        result cached = run(n, CACHED);
+        MWR_REPORT_ON(buffered.modules != streamed.modules ||
+                          cached.modules != streamed.modules,
+                      "module count mismatch");
+
+        cout << std::setw(9) << streamed.modules << std::setw(8)
+             << std::fixed << std::setprecision(1)
+             << make_listing(n).size() / mib << " MiB" << std::setw(19)
+             << std::setprecision(2) << buffered.seconds * 1e3
+             << std::setw(12) << buffered.peak / mib << std::setw(19)
+             << streamed.seconds * 1e3 << std::setw(12)
+             << streamed.peak / mib << std::setw(19) << lazy.seconds * 1e3
+             << std::setw(12) << lazy.peak / mib << std::setw(19)
+             << cached.seconds * 1e3 << std::setw(12) << cached.peak / mib
+             << endl;
+    }
+
+    return 0;
+}
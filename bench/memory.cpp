@@ -0,0 +1,66 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "bench.h"
+#include "mockvp.h"
+
+using namespace bench;
+
+struct result {
+    double read;
+    double write;
+    size_t wire;
+};
+
+static result run(u32 caps, size_t size, size_t iterations) {
+    mockvp server(caps);
+    session sess(server.host(), server.port());
+    target* targ = sess.find_target(mockvp::TARGET);
+    MWR_REPORT_ON(!targ, "target not found");
+
+    vector<u8> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = (u8)(i * 7);
+
+    result res;
+    size_t wire = server.rx_bytes() + server.tx_bytes();
+    res.write = measure(iterations, [&]() { targ->write_pmem(0, data); });
+    res.read = measure(iterations, [&]() { targ->read_pmem(0, size); });
+    res.wire = (server.rx_bytes() + server.tx_bytes() - wire) / iterations;
+
+    sess.disconnect();
+    return res;
+}
+
+int main(int argc, char** argv) {
+    const size_t sizes[] = { 1024, 4 * 1024, 64 * 1024, 512 * 1024 };
+
+    cout << "payload  encoding   read [ms]   write [ms]   wire bytes/byte"
+         << endl;
+    for (size_t size : sizes) {
+        size_t iterations = std::max<size_t>(4, (4 << 20) / size);
+        result text = run(VSP_CAP_NONE, size, iterations);
+        result binary = run(VSP_CAP_BINARY_MEMORY, size, iterations);
+
+        for (auto [name, res] : { std::make_pair("text", text),
+                                  std::make_pair("binary", binary) }) {
+            cout << std::setw(6) << size / 1024 << "K " << std::setw(9)
+                 << name << std::fixed << std::setprecision(3)
+                 << std::setw(12) << res.read * 1e3 << std::setw(13)
+                 << res.write * 1e3 << std::setw(18) << std::setprecision(2)
+                 << (double)res.wire / (2 * size) << endl;
+        }
+
+        cout << "         speedup" << std::setprecision(1) << std::setw(11)
+             << text.read / binary.read << "x" << std::setw(12)
+             << text.write / binary.write << "x" << endl;
+    }
+
+    return 0;
+}
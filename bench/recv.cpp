@@ -0,0 +1,104 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "bench.h"
+
+using namespace bench;
+
+// the original receive path: one socket read per byte
+static string legacy_recv(mwr::socket& sock) {
+    string packet;
+    u8 checksum = 0;
+
+    while (sock.is_connected()) {
+        char r = sock.recv_char();
+        switch (r) {
+        case '$':
+            packet = "";
+            checksum = 0;
+            break;
+
+        case '#': {
+            u8 refsum = stoi(string({ static_cast<char>(sock.recv_char()),
+                                      static_cast<char>(sock.recv_char()) }),
+                             nullptr, 16);
+            MWR_REPORT_ON(checksum != refsum, "checksum error");
+            sock.send_char('+');
+            return packet;
+        }
+
+        case '}':
+            checksum += static_cast<u8>(r);
+            r = sock.recv_char();
+            checksum += static_cast<u8>(r);
+            packet += r ^ 0x20;
+            break;
+
+        default:
+            checksum += static_cast<u8>(r);
+            packet += r;
+        }
+    }
+
+    MWR_REPORT("disconnected");
+}
+
+static size_t legacy_command(mwr::socket& sock, const string& cmd) {
+    string req = frame(cmd);
+    sock.send(req.data(), req.size());
+    MWR_REPORT_ON(sock.recv_char() != '+', "nack");
+    return split(legacy_recv(sock), ',').size();
+}
+
+static string pread_response(size_t size) {
+    string resp = "OK";
+    for (size_t i = 0; i < size; i++)
+        resp += mkstr(",%02zx", i & 0xff);
+    return resp;
+}
+
+int main(int argc, char** argv) {
+    const size_t sizes[] = { 1024, 16 * 1024, 256 * 1024, 1024 * 1024 };
+
+    cout << "payload     legacy [ms]   buffered [ms]   speedup" << endl;
+    for (size_t size : sizes) {
+        string resp = pread_response(size);
+        size_t iterations = std::max<size_t>(4, (16 << 20) / resp.size());
+
+        double legacy, buffered;
+        {
+            server srv([&resp](const string&) { return resp; });
+            mwr::socket sock;
+            sock.connect(srv.host(), srv.port());
+            legacy = measure(iterations, [&]() {
+                MWR_REPORT_ON(legacy_command(sock, "pread") != size + 1,
+                              "malformed response");
+            });
+            sock.disconnect();
+        }
+
+        {
+            server srv([&resp](const string&) { return resp; });
+            connection conn(srv.host(), srv.port());
+            buffered = measure(iterations, [&]() {
+                MWR_REPORT_ON(conn.command("pread").size() != size + 1,
+                              "malformed response");
+            });
+            conn.disconnect();
+        }
+
+        cout << std::setw(7) << size / 1024 << "K " << std::fixed
+             << std::setprecision(3) << std::setw(13) << legacy * 1e3
+             << std::setw(16) << buffered * 1e3 << std::setw(9)
+             << std::setprecision(1) << legacy / buffered << "x" << endl;
+    }
+
+    return 0;
+}
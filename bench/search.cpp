@@ -0,0 +1,74 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "bench.h"
+
+#include <algorithm>
+
+using namespace bench;
+
+// every eighth byte equals the first byte of the pattern, which is what
+// byte-at-a-time scanners struggle with, e.g. searching for a pointer in
+// memory full of other pointers into the same region
+static vector<u8> memory(size_t size) {
+    vector<u8> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = (i % 8) ? (u8)((i * 37) % 251) : 0xde;
+    return data;
+}
+
+int main(int argc, char** argv) {
+    const size_t size = 256 * 1024;
+    const size_t iterations = 2000;
+    const vector<u8> data = memory(size);
+    const vector<u8> pattern{ 0xde, 0xad, 0xbe, 0xef, 0xfe, 0xed };
+    const struct {
+        const char* name;
+        pattern_matcher impl;
+    } matchers[] = {
+        { "scalar", PATTERN_MATCHER_SCALAR },
+        { "sse2", PATTERN_MATCHER_SSE2 },
+        { "avx2", PATTERN_MATCHER_AVX2 },
+    };
+
+    double naive = measure(iterations, [&]() {
+        auto it = std::search(data.begin(), data.end(), pattern.begin(),
+                              pattern.end());
+        MWR_REPORT_ON(it != data.end(), "unexpected match");
+    });
+
+    auto report = [&](const char* name, double t) {
+        cout << std::left << std::setw(10) << name << std::right
+             << std::fixed << std::setprecision(3) << std::setw(11)
+             << t * 1e6 << std::setw(9) << std::setprecision(0)
+             << size / t / 1e6 << std::setw(9) << std::setprecision(1)
+             << naive / t << "x" << endl;
+    };
+
+    cout << "matcher   time [us]     MB/s   speedup" << endl;
+    report("std", naive);
+
+    for (const auto& m : matchers) {
+        if (!pattern_matcher_supported(m.impl))
+            continue;
+
+        byte_pattern pat(pattern, {}, m.impl);
+        vector<u64> found;
+        double t = measure(iterations, [&]() {
+            found.clear();
+            pat.find(data.data(), data.size(), 0, found);
+            MWR_REPORT_ON(!found.empty(), "unexpected match");
+        });
+
+        report(m.name, t);
+    }
+
+    return 0;
+}
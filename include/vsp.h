@@ -12,12 +12,25 @@
 #define VSP_H
 
 #include "vsp/attribute.h"
+#include "vsp/cache.h"
+#include "vsp/checksum.h"
 #include "vsp/command.h"
 #include "vsp/connection.h"
 #include "vsp/cpureg.h"
 #include "vsp/element.h"
+#include "vsp/elf.h"
+#include "vsp/hexdec.h"
+#include "vsp/hierarchy.h"
+#include "vsp/mapfile.h"
 #include "vsp/module.h"
+#include "vsp/packet.h"
+#include "vsp/profiler.h"
+#include "vsp/response.h"
+#include "vsp/search.h"
 #include "vsp/session.h"
+#include "vsp/symbols.h"
 #include "vsp/target.h"
+#include "vsp/tracer.h"
+#include "vsp/xml.h"
 
 #endif
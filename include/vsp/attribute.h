@@ -19,20 +19,22 @@ namespace vsp {
 class module;
 class attribute : public element
 {
+    friend class hierarchy;
+
 private:
-    string m_type;
+    const char* m_type;
     size_t m_count;
 
+    attribute();
+
 public:
-    attribute(const string& name, connection& conn, module* parent,
-              const string& type, size_t count);
     virtual ~attribute() = default;
 
-    attribute() = delete;
     attribute(const attribute&) = delete;
     attribute& operator=(const attribute&) = delete;
 
-    const string& type() const;
+    // points into the hierarchy, use string(type()) to keep a copy
+    string_view type() const;
     size_t count() const;
 
     vector<string> get();
@@ -48,6 +50,8 @@ public:
 
     template <typename T>
     void set(const vector<T>& val);
+
+    static vector<vector<string>> get_all(const vector<attribute*>& attrs);
 };
 
 template <typename T>
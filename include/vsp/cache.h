@@ -0,0 +1,59 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_CACHE_H
+#define VSP_CACHE_H
+
+#include "vsp/common.h"
+#include "vsp/hierarchy.h"
+
+namespace vsp {
+
+// Keeps complete hierarchies of simulations in a directory, one image per
+// simulation holding its latest listing. Images are named after a key for
+// the simulation's versions and a digest of its listing. They hold all
+// elements as flat records next to a string table and get mapped rather
+// than read, so loading one neither parses nor copies any names.
+class hierarchy_cache
+{
+private:
+    string m_dir;
+
+public:
+    static constexpr u32 FORMAT = 1;
+
+    explicit hierarchy_cache(const string& dir);
+    virtual ~hierarchy_cache() = default;
+
+    const string& dir() const { return m_dir; }
+
+    // identifies a simulation by everything that may change its listing
+    static string key(string_view sysc_version, string_view vcml_version,
+                      int proto_version);
+
+    string path(const string& key, u64 digest) const;
+
+    // true if there are any images for key, whatever their digest
+    bool contains(const string& key) const;
+
+    // replaces the contents of hier with the image stored for key and
+    // digest, returns false if there is no such image or it is unusable
+    bool load(const string& key, u64 digest, hierarchy& hier,
+              vector<target_desc>& targets) const;
+    // stores an image for key and digest and removes those of earlier
+    // listings with the same key
+    void store(const string& key, u64 digest, const hierarchy& hier,
+               const vector<target_desc>& targets) const;
+};
+
+} // namespace vsp
+
+#endif
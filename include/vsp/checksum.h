@@ -0,0 +1,30 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_CHECKSUM_H
+#define VSP_CHECKSUM_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+// crc32 as used by zlib and ethernet, pass the result of a previous call
+// as crc to continue a checksum across several buffers
+u32 crc32(const u8* data, size_t size, u32 crc = 0);
+
+// 64 bit fnv-1a hash for telling large inputs apart, pass the result of a
+// previous call as hash to continue it across several buffers
+constexpr u64 FNV1A64_INIT = 0xcbf29ce484222325ull;
+u64 fnv1a64(const u8* data, size_t size, u64 hash = FNV1A64_INIT);
+
+} // namespace vsp
+
+#endif
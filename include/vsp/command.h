@@ -18,16 +18,17 @@ namespace vsp {
 
 class command : public element
 {
+    friend class hierarchy;
+
 private:
     size_t m_argc;
-    string m_desc;
+    const char* m_desc;
+
+    command();
 
 public:
-    command(const string& name, connection& conn, module* parent, size_t argc,
-            const string& desc);
     virtual ~command() = default;
 
-    command() = delete;
     command(const command&) = delete;
     command& operator=(const command&) = delete;
 
@@ -11,12 +11,18 @@
 #ifndef VSP_COMMON_H
 #define VSP_COMMON_H
 
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <fstream>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <filesystem>
 
@@ -41,6 +47,7 @@ using mwr::mkstr;
 
 using mwr::split;
 
+using std::deque;
 using std::list;
 using std::vector;
 using std::unordered_map;
@@ -52,6 +59,7 @@ using std::to_string;
 using std::ostream;
 using std::count;
 using std::ifstream;
+using std::ofstream;
 
 using std::stoi;
 using std::stoull;
@@ -63,6 +71,12 @@ using std::endl;
 
 using std::mutex;
 using std::lock_guard;
+using std::unique_lock;
+using std::condition_variable;
+using std::thread;
+
+using std::future;
+using std::promise;
 
 using std::optional;
 using std::nullopt;
@@ -12,11 +12,42 @@
 #define VSP_CONNECTION_H
 
 #include "vsp/common.h"
+#include "vsp/packet.h"
+#include "vsp/response.h"
+
+#include <atomic>
 
 namespace vsp {
 
+enum vsp_proto_version {
+    VSP_UNKNOWN = 0,
+    VSP_V1 = 1,
+    VSP_V2 = 2, // arch command
+};
+
+// Protocol extensions are not tied to a version. Servers that support
+// any list their names in response to "caps", servers that do not know
+// that command support none of them.
+enum vsp_capability : u32 {
+    VSP_CAP_NONE = 0,
+    VSP_CAP_BINARY_MEMORY = 1u << 0, // "binmem": bpread, bvread, ...
+    VSP_CAP_COUNTED_STEP = 1u << 1,  // "stepn": step,<target>,<count>
+    VSP_CAP_SUBTREE_LIST = 1u << 2,  // "listsub": list,xml,<mod>,<depth>
+    VSP_CAP_LIST_DIGEST = 1u << 3,   // "listdigest": list,digest
+    VSP_CAP_ALL = (1u << 4) - 1,
+};
+
+// name of a single capability as listed by servers, nullptr if unknown
+const char* vsp_capability_name(vsp_capability cap);
+// combines the capabilities listed in a caps response, names that are
+// not known to the client are skipped
+u32 parse_capabilities(const response& resp);
+
 class connection
 {
+public:
+    typedef function<void(const char* data, size_t size)> stream_sink;
+
 private:
     enum : char {
         ACK = '+',
@@ -25,19 +56,46 @@ private:
 
     mutex m_mtx;
     socket m_socket;
+    packet m_tx;
+
+    vector<char> m_rxbuf;
+    size_t m_rxpos;
+    size_t m_rxlen;
+
+    int m_protover;
+    u32 m_caps;
+    std::atomic<u64> m_epoch;
+
+    mutex m_queue_mtx;
+    condition_variable m_queue_cv;
+    deque<pair<string, promise<vector<string>>>> m_queue;
+    bool m_stop;
+    thread m_worker;
+
+    connection& stop_worker();
+    void work();
 
-    string recv();
-    void send(const string& data);
+    // disconnect for callers that already hold m_mtx
+    void close() noexcept;
 
-    static u8 checksum(const string& s);
-    static string escape(const string& s);
-    static vector<string> decompose(const string& s);
+    void fill();
+    char recv_char();
+
+    template <typename SINK>
+    void recv(SINK& sink, bool ack);
+    void recv(string& packet, bool ack);
+    void receive(response& resp, size_t max_fields, bool ack = true);
+    void transmit();
+
+    static void check(const response& resp);
 
 public:
+    static constexpr size_t PIPELINE_DEPTH = 32;
+
     connection();
     connection(const string& host, u16 port);
     connection(connection&& other) noexcept;
-    virtual ~connection() = default;
+    virtual ~connection();
 
     connection(const connection&) = delete;
     connection& operator=(const connection&) = delete;
@@ -48,12 +106,62 @@ public:
 
     bool is_connected() const { return m_socket.is_connected(); }
 
+    int proto_version() const { return m_protover; }
+    void set_proto_version(int version) { m_protover = version; }
+
+    u32 capabilities() const { return m_caps; }
+    bool has_capability(vsp_capability cap) const { return m_caps & cap; }
+    void set_capabilities(u32 caps) { m_caps = caps; }
+
+    // advanced whenever the simulation may have changed target state,
+    // cached target data is only valid within the same epoch; the event
+    // poller advances it from its own thread
+    u64 epoch() const { return m_epoch; }
+    void advance_epoch() { m_epoch++; }
+
     void connect(const string& host, u16 port);
     void disconnect() noexcept;
 
+    response request(const string& cmd,
+                     size_t max_fields = response::ALL_FIELDS);
+
+    // formats cmd and args straight into the output buffer of this
+    // connection and reuses the buffers of resp, so repeated requests do
+    // not allocate once the buffers have grown large enough
+    template <typename... ARGS>
+    void request(response& resp, size_t max_fields, string_view cmd,
+                 const ARGS&... args);
+
+    // Sends cmd and hands the second field of its response to sink while
+    // the response is still arriving, with all escapes already resolved,
+    // so large responses never have to be held in memory as a whole.
+    // Error responses are reported once they have been received.
+    void request_stream(const string& cmd, const stream_sink& sink);
+
     vector<string> command(const string& cmd);
+    vector<vector<string>> command_batch(const vector<string>& cmds);
+    future<vector<string>> command_async(const string& cmd);
+
+    void pipeline(size_t count,
+                  const function<void(size_t, packet&)>& request,
+                  const function<void(size_t, response&)>& handler,
+                  size_t depth = PIPELINE_DEPTH,
+                  size_t max_fields = response::ALL_FIELDS);
 };
 
+template <typename... ARGS>
+void connection::request(response& resp, size_t max_fields, string_view cmd,
+                         const ARGS&... args) {
+    lock_guard lk(m_mtx);
+    m_tx.clear();
+    m_tx.begin(cmd);
+    (m_tx.field(args), ...);
+    m_tx.finish();
+    transmit();
+    receive(resp, max_fields);
+    check(resp);
+}
+
 } // namespace vsp
 
 #endif
@@ -25,6 +25,7 @@ private:
     string m_name;
     size_t m_size;
     target& m_parent;
+    response m_resp;
 
     void update_size();
 
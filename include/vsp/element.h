@@ -17,24 +17,56 @@
 namespace vsp {
 
 class module;
+class hierarchy;
 
+// contiguous run of element pointers within a hierarchy, stays valid for
+// as long as the hierarchy it was taken from
+template <typename T>
+class element_range
+{
+private:
+    T* const* m_begin;
+    size_t m_size;
+
+public:
+    typedef T* const* iterator;
+
+    element_range(): m_begin(nullptr), m_size(0) {}
+    element_range(T* const* begin, size_t size):
+        m_begin(begin), m_size(size) {}
+
+    iterator begin() const { return m_begin; }
+    iterator end() const { return m_begin + m_size; }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    T* operator[](size_t i) const { return m_begin[i]; }
+
+    operator vector<T*>() const { return vector<T*>(begin(), end()); }
+};
+
+// elements are views into the hierarchy that created them, their names
+// are interned there and they never get copied or moved
 class element
 {
+    friend class hierarchy;
+
 protected:
-    connection& m_conn;
+    connection* m_conn;
     module* m_parent;
-    string m_name;
+    const char* m_name;
+
+    element(): m_conn(nullptr), m_parent(nullptr), m_name("") {}
 
 public:
-    element(const string& name, connection& conn, module* parent = nullptr);
     virtual ~element() = default;
 
-    element() = delete;
     element(const element&) = delete;
     element& operator=(const element&) = delete;
 
     module* parent() const { return m_parent; };
-    const char* name() const { return m_name.c_str(); }
+    const char* name() const { return m_name; }
     string hierarchy_name() const;
 };
 
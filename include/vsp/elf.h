@@ -0,0 +1,89 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_ELF_H
+#define VSP_ELF_H
+
+#include "vsp/common.h"
+#include "vsp/mapfile.h"
+
+namespace vsp {
+
+struct elf_segment {
+    u32 type;
+    u32 flags;
+    u64 offset;
+    u64 vaddr;
+    u64 paddr;
+    u64 filesz;
+    u64 memsz;
+};
+
+struct elf_section {
+    string_view name;
+    u32 type;
+    u32 link;
+    u64 addr;
+    u64 offset;
+    u64 size;
+    u64 entsize;
+};
+
+// minimal reader for 32 and 64 bit ELF files of either byte order, the
+// file stays mapped for as long as this object lives and section names
+// point right into it
+class elf_file
+{
+private:
+    mapped_file m_file;
+    bool m_64bit;
+    bool m_big_endian;
+    u16 m_machine;
+    u64 m_entry;
+    vector<elf_segment> m_segments;
+    vector<elf_section> m_sections;
+
+    void parse();
+
+public:
+    static constexpr u32 SEGMENT_LOAD = 1;
+    static constexpr u32 SECTION_SYMTAB = 2;
+    static constexpr u32 SECTION_DYNSYM = 11;
+    static constexpr u16 MACHINE_ARM = 40;
+
+    explicit elf_file(const string& path);
+    explicit elf_file(mapped_file&& file);
+    elf_file(elf_file&& other) noexcept = default;
+    virtual ~elf_file() = default;
+
+    elf_file(const elf_file&) = delete;
+    elf_file& operator=(const elf_file&) = delete;
+
+    static bool is_elf(const u8* data, size_t size);
+
+    const u8* data() const { return m_file.data(); }
+    size_t size() const { return m_file.size(); }
+
+    bool is_64bit() const { return m_64bit; }
+    bool is_big_endian() const { return m_big_endian; }
+    u16 machine() const { return m_machine; }
+    u64 entry() const { return m_entry; }
+
+    const vector<elf_segment>& segments() const { return m_segments; }
+    const vector<elf_section>& sections() const { return m_sections; }
+    const elf_section* find_section(u32 type) const;
+
+    // reads an integer of 1, 2, 4 or 8 bytes in the byte order of the file
+    u64 read(u64 offset, size_t size) const;
+};
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,35 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_HEXDEC_H
+#define VSP_HEXDEC_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+enum hex_decoder {
+    HEX_DECODER_AUTO = 0,
+    HEX_DECODER_SCALAR,
+    HEX_DECODER_SSE2,
+    HEX_DECODER_AVX2,
+};
+
+bool hex_decoder_supported(hex_decoder impl);
+
+// Decodes a comma separated list of hex bytes, e.g. "de,ad,be,ef", into
+// exactly count bytes at out. Returns false if the input is malformed or
+// does not hold exactly count bytes.
+bool decode_hex(string_view in, u8* out, size_t count,
+                hex_decoder impl = HEX_DECODER_AUTO);
+
+} // namespace vsp
+
+#endif
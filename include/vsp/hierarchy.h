@@ -0,0 +1,289 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_HIERARCHY_H
+#define VSP_HIERARCHY_H
+
+#include "vsp/common.h"
+#include "vsp/attribute.h"
+#include "vsp/command.h"
+#include "vsp/mapfile.h"
+#include "vsp/module.h"
+#include "vsp/xml.h"
+
+namespace vsp {
+
+// Interns strings into large blocks, each distinct string is stored once
+// and keeps its address until the pool gets cleared. Hierarchies repeat
+// the same few names, kinds and types over and over.
+class string_pool
+{
+private:
+    vector<unique_ptr<char[]>> m_blocks;
+    size_t m_used;
+    size_t m_capacity;
+    size_t m_bytes;
+    unordered_map<string_view, const char*> m_strings;
+
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    string_pool();
+    virtual ~string_pool() = default;
+
+    string_pool(const string_pool&) = delete;
+    string_pool& operator=(const string_pool&) = delete;
+
+    size_t size() const { return m_strings.size(); }
+    size_t bytes() const { return m_bytes; }
+
+    // returns a terminated copy of str owned by the pool
+    const char* intern(string_view str);
+    // same as intern, but always makes a new copy and does not remember
+    // it, for strings that are known to be unique
+    const char* store(string_view str);
+    void clear();
+};
+
+// Maps the full hierarchy names of all modules, attributes and commands
+// below a root module to their elements. Every module with contents
+// stores its path once in pool blocks, the keys of its children pair that
+// path with their own names, so lookups neither allocate nor walk the
+// hierarchy. Modules whose contents are loaded later get added to the
+// index once they are.
+class hierarchy_index
+{
+private:
+    // a full name split after the path of its parent, the name of a
+    // lookup is all prefix
+    struct key {
+        string_view prefix;
+        string_view name;
+        size_t size() const { return prefix.size() + name.size(); }
+    };
+
+    struct key_hash {
+        size_t operator()(const key& k) const;
+    };
+
+    struct key_equal {
+        bool operator()(const key& a, const key& b) const;
+    };
+
+    template <typename T>
+    using key_map = unordered_map<key, T*, key_hash, key_equal>;
+
+    string_pool m_names;
+    key_map<module> m_mods;
+    key_map<attribute> m_attrs;
+    key_map<command> m_cmds;
+
+public:
+    hierarchy_index();
+    virtual ~hierarchy_index() = default;
+
+    hierarchy_index(const hierarchy_index&) = delete;
+    hierarchy_index& operator=(const hierarchy_index&) = delete;
+
+    size_t size() const;
+    bool empty() const { return size() == 0; }
+    // memory taken by the stored paths
+    size_t bytes() const { return m_names.bytes(); }
+
+    void reserve(size_t mods, size_t attrs, size_t cmds);
+    void build(module* root);
+    void add(module* mod);
+    void clear();
+
+    module* find_module(string_view name) const;
+    attribute* find_attribute(string_view name) const;
+    command* find_command(string_view name) const;
+};
+
+struct target_desc {
+    string name;
+    string arch;
+    string group;
+};
+
+// Owns all modules, attributes and commands of a session. Elements are
+// added depth first between begin_module and end_module calls and only
+// become visible once finish() places them in bulk allocated arrays,
+// with the children of every module in one contiguous run.
+//
+// Listings can stop at a given depth, the modules at that depth are then
+// incomplete and list their contents once anything asks for them. Those
+// contents are attached to the existing module in a segment of their own.
+class hierarchy
+{
+    friend class hierarchy_cache;
+
+private:
+    struct module_info {
+        const char* name;
+        const char* kind;
+        const char* version;
+        size_t parent;
+        bool complete;
+        module* existing;
+    };
+
+    struct attribute_info {
+        const char* name;
+        const char* type;
+        size_t count;
+        size_t parent;
+    };
+
+    struct command_info {
+        const char* name;
+        const char* desc;
+        size_t argc;
+        size_t parent;
+    };
+
+    // everything added between two calls to finish
+    struct segment {
+        unique_ptr<module[]> mods;
+        unique_ptr<attribute[]> attrs;
+        unique_ptr<command[]> cmds;
+        unique_ptr<module*[]> mod_ptrs;
+        unique_ptr<attribute*[]> attr_ptrs;
+        unique_ptr<command*[]> cmd_ptrs;
+    };
+
+    connection& m_conn;
+    string_pool m_strings;
+    vector<segment> m_segments;
+    module* m_root;
+    size_t m_num_mods;
+    size_t m_num_attrs;
+    size_t m_num_cmds;
+    std::atomic<size_t> m_num_unloaded;
+    size_t m_depth;
+    u64 m_digest;
+    hierarchy_index m_index;
+
+    // modules may be listed from any thread that uses them first, this
+    // serializes the listings and guards the index while there are any
+    mutable mutex m_mtx;
+
+    // cached hierarchies whose strings are used in place
+    vector<mapped_file> m_images;
+
+    vector<module_info> m_new_mods;
+    vector<attribute_info> m_new_attrs;
+    vector<command_info> m_new_cmds;
+    vector<size_t> m_stack;
+
+    template <typename T, typename INFO>
+    static unique_ptr<T*[]> group(T* elems, const vector<INFO>& infos,
+                                  size_t nparents, vector<size_t>& offsets);
+
+    vector<target_desc> fetch(module* mod);
+    void discard();
+
+public:
+    static constexpr size_t NO_PARENT = ~(size_t)0;
+
+    explicit hierarchy(connection& conn);
+    virtual ~hierarchy() = default;
+
+    hierarchy(const hierarchy&) = delete;
+    hierarchy& operator=(const hierarchy&) = delete;
+
+    module* root() const { return m_root; }
+    // only safe to use while no other thread lists modules, use the
+    // find_* functions below otherwise
+    const hierarchy_index& index() const { return m_index; }
+    const string_pool& strings() const { return m_strings; }
+
+    size_t num_modules() const { return m_num_mods; }
+    size_t num_attributes() const { return m_num_attrs; }
+    size_t num_commands() const { return m_num_cmds; }
+    size_t num_unloaded() const { return m_num_unloaded; }
+
+    // fnv1a64 of the last full listing received, zero if there was none
+    u64 digest() const { return m_digest; }
+    bool from_cache() const { return !m_images.empty(); }
+
+    // replaces the hierarchy with the listing of the simulation, which
+    // stops depth levels below the root unless depth is zero; requires
+    // VSP_CAP_SUBTREE_LIST for a depth other than zero
+    vector<target_desc> load(size_t depth = 0);
+    // replaces the hierarchy with a full listing received earlier, digest
+    // is the fnv1a64 of its text
+    vector<target_desc> load(string_view listing, u64 digest);
+    // lists the contents of a module that load left out
+    void expand(const module& mod);
+
+    // index lookups that are safe while other threads expand modules,
+    // load and clear must not run concurrently with anything
+    module* find_module(string_view name) const;
+    attribute* find_attribute(string_view name) const;
+    command* find_command(string_view name) const;
+
+    void begin_module(string_view name, string_view kind,
+                      string_view version, bool complete = true);
+    // continues the listing below the existing module mod, which must be
+    // the first thing added after finish
+    void begin_subtree(module& mod);
+    void end_module();
+    void add_attribute(string_view name, string_view type, size_t count);
+    void add_command(string_view name, size_t argc, string_view desc);
+
+    // makes the elements added so far part of the hierarchy, the first
+    // module ever added becomes its root
+    void finish();
+    void clear();
+};
+
+// Builds a hierarchy from the xml listing of a simulation while it is
+// still being received. The targets listed next to the modules are only
+// collected, creating them is up to the session. Subtree listings hold
+// the listed module as the first object of the hierarchy, its contents
+// get attached to the existing module given as subtree.
+class hierarchy_reader : public xml_reader
+{
+private:
+    enum element_kind : u8 {
+        ELEM_IGNORED = 0,
+        ELEM_ROOT,
+        ELEM_MODULE,
+        ELEM_LEAF,
+        ELEM_TARGET,
+        ELEM_WRAPPER,
+    };
+
+    hierarchy& m_hier;
+    module* m_subtree;
+    vector<target_desc> m_targets;
+    vector<element_kind> m_kinds;
+    bool m_has_root;
+    bool m_has_name;
+
+protected:
+    virtual void begin_element(string_view name,
+                               const xml_attrs& attrs) override;
+    virtual void end_element(string_view name) override;
+    virtual void text(string_view text) override;
+    virtual void end_document() override;
+
+public:
+    explicit hierarchy_reader(hierarchy& hier, module* subtree = nullptr);
+    virtual ~hierarchy_reader() = default;
+
+    const vector<target_desc>& targets() const { return m_targets; }
+};
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,47 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_MAPFILE_H
+#define VSP_MAPFILE_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+// read-only memory mapping of a whole file, pages are only loaded once
+// they are touched, which keeps opening large images cheap
+class mapped_file
+{
+private:
+    const u8* m_data;
+    size_t m_size;
+    bool m_open;
+
+public:
+    mapped_file();
+    explicit mapped_file(const string& path);
+    mapped_file(mapped_file&& other) noexcept;
+    mapped_file& operator=(mapped_file&& other) noexcept;
+    virtual ~mapped_file();
+
+    mapped_file(const mapped_file&) = delete;
+    mapped_file& operator=(const mapped_file&) = delete;
+
+    bool is_open() const { return m_open; }
+    const u8* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+    void open(const string& path);
+    void close() noexcept;
+};
+
+} // namespace vsp
+
+#endif
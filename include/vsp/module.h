@@ -14,46 +14,73 @@
 #include "vsp/common.h"
 #include "vsp/element.h"
 
+#include <atomic>
+
 namespace vsp {
 
 class attribute;
 class command;
+class hierarchy;
 
 class module : public element
 {
+    friend class hierarchy;
+    friend class hierarchy_index;
+
 private:
-    string m_kind;
-    string m_version;
-    vector<module*> m_mods;
-    vector<attribute*> m_attrs;
-    vector<command*> m_cmds;
+    const char* m_kind;
+    const char* m_version;
+    element_range<module> m_mods;
+    element_range<attribute> m_attrs;
+    element_range<command> m_cmds;
+
+    // set while the contents of this module have not been listed yet,
+    // cleared only after they have been attached
+    std::atomic<hierarchy*> m_loader;
+
+    module();
+
+    void load() const;
+    void ensure_loaded() const {
+        if (m_loader)
+            load();
+    }
 
 public:
-    module(const string& name, connection& conn, module* parent,
-           const string& kind, const string& version);
-    virtual ~module();
-    module() = delete;
+    virtual ~module() = default;
     module(const module&) = delete;
     module& operator=(const module&) = delete;
 
     const char* kind() const;
     const char* version() const;
 
+    // false until the contents of the module have been listed, which
+    // happens the first time any of them are asked for; concurrent first
+    // uses wait for the same listing
+    bool is_loaded() const { return m_loader == nullptr; }
+
     friend ostream& operator<<(ostream& os, const module& mod);
 
-    module* find_module(const string& mod);
-    attribute* find_attribute(const string& name);
-    command* find_command(const string& name);
+    // lookups relative to this module, session::find_* is faster for
+    // full hierarchy names
+    module* find_module(string_view mod);
+    attribute* find_attribute(string_view name);
+    command* find_command(string_view name);
+
+    const element_range<module>& children() const {
+        ensure_loaded();
+        return m_mods;
+    }
 
-    void add_module(module* mod);
-    void add_attribute(attribute* attr);
-    void add_attribute(const string& name, const string& type, size_t count);
-    void add_command(command* c);
-    void add_command(const string& name, size_t argc, const string& desc);
+    const element_range<attribute>& attributes() const {
+        ensure_loaded();
+        return m_attrs;
+    }
 
-    const vector<module*>& children() const { return m_mods; }
-    const vector<attribute*>& attributes() const { return m_attrs; }
-    const vector<command*>& commands() const { return m_cmds; }
+    const element_range<command>& commands() const {
+        ensure_loaded();
+        return m_cmds;
+    }
 };
 
 } // namespace vsp
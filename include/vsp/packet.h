@@ -0,0 +1,81 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_PACKET_H
+#define VSP_PACKET_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+// memory contents sent as one field of raw bytes, commas and backslashes
+// within get escaped with a backslash like in any other field
+struct binary_data {
+    const u8* data;
+    size_t size;
+};
+
+// memory contents sent as one decimal field per byte
+struct decimal_data {
+    const u8* data;
+    size_t size;
+};
+
+// Builds framed packets "$<payload>#<checksum>" in place. Framing
+// characters are escaped and summed up while fields are appended, so no
+// intermediate strings are needed. The buffer keeps its capacity across
+// clear(), and several frames can be queued before sending them at once.
+class packet
+{
+private:
+    string m_data;
+    u8 m_checksum;
+
+    void put(char c);
+    void put(string_view s);
+
+public:
+    packet();
+    virtual ~packet() = default;
+
+    const string& str() const { return m_data; }
+    size_t size() const { return m_data.size(); }
+    bool empty() const { return m_data.empty(); }
+
+    void clear();
+
+    packet& begin(string_view cmd);
+    packet& finish();
+
+    packet& field(string_view s);
+    packet& field(const binary_data& bin);
+    packet& field(const decimal_data& dec);
+
+    template <typename T,
+              typename = std::enable_if_t<std::is_integral_v<T> &&
+                                          !std::is_same_v<T, bool>>>
+    packet& field(T val);
+
+    // appends a character outside of any frame, e.g. an acknowledgement
+    packet& append(char c);
+};
+
+template <typename T, typename>
+packet& packet::field(T val) {
+    char buf[24];
+    auto res = std::to_chars(buf, buf + sizeof(buf), val);
+    put(',');
+    put(string_view(buf, res.ptr - buf));
+    return *this;
+}
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,113 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_PROFILER_H
+#define VSP_PROFILER_H
+
+#include "vsp/common.h"
+#include "vsp/session.h"
+
+#include <atomic>
+
+namespace vsp {
+
+// fixed size open addressing table of sample counts, samples can be added
+// and read from different threads without locking, once it is full any
+// new program counter is only counted as dropped
+class pc_histogram
+{
+private:
+    struct slot {
+        std::atomic<u64> key; // pc + 1, zero marks a free slot
+        std::atomic<u64> count;
+    };
+
+    std::unique_ptr<slot[]> m_slots;
+    size_t m_mask;
+    std::atomic<u64> m_total;
+    std::atomic<u64> m_dropped;
+
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16 * 1024;
+
+    explicit pc_histogram(size_t capacity = DEFAULT_CAPACITY);
+    virtual ~pc_histogram() = default;
+
+    pc_histogram(const pc_histogram&) = delete;
+    pc_histogram& operator=(const pc_histogram&) = delete;
+
+    size_t capacity() const { return m_mask + 1; }
+    u64 total() const { return m_total; }
+    u64 dropped() const { return m_dropped; }
+
+    void add(u64 pc, u64 n = 1);
+    u64 count(u64 pc) const;
+    void clear();
+
+    // pairs of pc and count, most frequent first
+    vector<pair<u64, u64>> entries() const;
+};
+
+enum profile_clock {
+    PROFILE_WALL_CLOCK = 0,
+    PROFILE_SIM_TIME,
+};
+
+class profiler
+{
+public:
+    typedef function<string(const target&, u64)> symbolizer;
+
+private:
+    session& m_session;
+    vector<target*> m_targets;
+    vector<std::unique_ptr<pc_histogram>> m_hists;
+    std::atomic<bool> m_cancel;
+
+    string symbol(const symbolizer& sym, size_t i, u64 pc) const;
+
+public:
+    profiler(session& sess,
+             size_t capacity = pc_histogram::DEFAULT_CAPACITY);
+    virtual ~profiler() = default;
+
+    profiler(const profiler&) = delete;
+    profiler& operator=(const profiler&) = delete;
+
+    const vector<target*>& targets() const { return m_targets; }
+    const pc_histogram& histogram(size_t i) const { return *m_hists[i]; }
+    const pc_histogram* find_histogram(const target& t) const;
+
+    // takes one sample of every target, the simulation must be stopped
+    void sample();
+
+    // Alternates between letting the simulation run for interval and
+    // taking a sample, interval is in microseconds of wall clock time or
+    // in nanoseconds of simulation time. Returns the number of samples
+    // taken, which falls short of samples if the simulation stopped for
+    // any other reason or cancel() was called from another thread.
+    size_t run(profile_clock clock, u64 interval, size_t samples);
+    void cancel() { m_cancel = true; }
+
+    void clear();
+
+    // Without a symbolizer, locations are resolved through the symbols of
+    // their target and fall back to plain addresses. The flat profile has
+    // one table per target listing samples per pc, most frequent first.
+    void export_flat(ostream& os, const symbolizer& sym = nullptr) const;
+
+    // "target;symbol count" lines as expected by flamegraph tools
+    void export_collapsed(ostream& os,
+                          const symbolizer& sym = nullptr) const;
+};
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,69 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_RESPONSE_H
+#define VSP_RESPONSE_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+class response
+{
+private:
+    struct field {
+        u32 offset;
+        u32 length;
+    };
+
+    string m_buffer;
+    vector<field> m_fields;
+
+    void tokenize(size_t max_fields);
+
+public:
+    static constexpr size_t ALL_FIELDS = SIZE_MAX;
+
+    response();
+    explicit response(string&& packet, size_t max_fields = ALL_FIELDS);
+    virtual ~response() = default;
+
+    response(response&&) noexcept = default;
+    response& operator=(response&&) noexcept = default;
+
+    response(const response&) = default;
+    response& operator=(const response&) = default;
+
+    void assign(string&& packet, size_t max_fields = ALL_FIELDS);
+
+    // hands out the buffer for reuse, leaving the response empty
+    string release();
+
+    size_t size() const { return m_fields.size(); }
+    bool empty() const { return m_fields.empty(); }
+
+    string_view operator[](size_t i) const;
+    string_view at(size_t i) const;
+    u64 to_u64(size_t i, int base = 10) const;
+
+    bool ok() const;
+    string_view error() const;
+
+    vector<string> to_vector() const;
+};
+
+inline string_view response::operator[](size_t i) const {
+    return string_view(m_buffer.data() + m_fields[i].offset,
+                       m_fields[i].length);
+}
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,59 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_SEARCH_H
+#define VSP_SEARCH_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+enum pattern_matcher {
+    PATTERN_MATCHER_AUTO = 0,
+    PATTERN_MATCHER_SCALAR,
+    PATTERN_MATCHER_SSE2,
+    PATTERN_MATCHER_AVX2,
+};
+
+bool pattern_matcher_supported(pattern_matcher impl);
+
+// Byte pattern with an optional mask of the same size, only bits set in
+// the mask take part in the comparison. Searches first look for the first
+// and last compared byte of the pattern, 16 or 32 positions at a time
+// with vector instructions, and only check the full pattern where both
+// of them fit.
+class byte_pattern
+{
+private:
+    vector<u8> m_bytes;
+    vector<u8> m_mask;
+    bool m_masked;
+    size_t m_first;
+    size_t m_last;
+    pattern_matcher m_impl;
+
+public:
+    byte_pattern(const vector<u8>& bytes, const vector<u8>& mask = {},
+                 pattern_matcher impl = PATTERN_MATCHER_AUTO);
+    virtual ~byte_pattern() = default;
+
+    size_t size() const { return m_bytes.size(); }
+
+    bool matches(const u8* data) const;
+
+    // appends base plus the offset of every match that lies entirely
+    // within data to out
+    void find(const u8* data, size_t size, u64 base, vector<u64>& out) const;
+};
+
+} // namespace vsp
+
+#endif
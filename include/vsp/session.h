@@ -13,18 +13,15 @@
 
 #include "vsp/common.h"
 #include "vsp/attribute.h"
+#include "vsp/cache.h"
 #include "vsp/command.h"
 #include "vsp/connection.h"
+#include "vsp/hierarchy.h"
 #include "vsp/module.h"
 #include "vsp/target.h"
 
 namespace vsp {
 
-enum vsp_proto_version {
-    VSP_UNKNOWN = 0,
-    VSP_V1 = 1,
-};
-
 enum vsp_stop_mode {
     VSP_STOP_MODE_SOFT = 0,
     VSP_STOP_MODE_HARD,
@@ -71,6 +68,22 @@ struct stop_reason {
 string_view stop_reason_str(const stop_reason& reason);
 ostream& operator<<(ostream& out, const stop_reason& reason);
 
+// waiting for a stop first polls the status back to back, then yields
+// between polls and finally sleeps, doubling the sleep time from
+// sleep_min_us up to sleep_max_us, which bounds both the stop latency
+// and the load on the simulation
+struct wait_policy {
+    size_t spin_polls = 2;
+    size_t yield_polls = 8;
+    u64 sleep_min_us = 100;
+    u64 sleep_max_us = 10000;
+};
+
+struct wait_result {
+    bool stopped;
+    size_t round_trips;
+};
+
 struct session_info {
     string host;
     u16 port;
@@ -83,21 +96,68 @@ private:
     connection m_conn;
     string m_sysc_version;
     string m_vcml_version;
-    int m_protover;
     bool m_running;
     stop_reason m_reason;
     u64 m_time_ns;
     u64 m_cycle;
-    module* m_mods;
+    hierarchy m_hier;
     vector<target*> m_targets;
     unordered_map<string, target_group> m_target_groups;
 
+    // servers that cannot list subtrees send the whole hierarchy, in lazy
+    // mode it is received in the background until the first lookup
+    bool m_lazy;
+    mutable mutex m_load_mtx;
+    mutable condition_variable m_load_cv;
+    thread m_loader;
+    bool m_loading;
+    std::exception_ptr m_load_error;
+
+    // complete hierarchies are cached here unless it is empty, under the
+    // digest the server gave for its listing if it did
+    string m_cache_dir;
+    optional<u64> m_list_digest;
+
+    response m_resp;
+
+    // the protocol has no stop notifications, so one poller thread watches
+    // the status on behalf of all waiters and only runs while there are any
+    mutex m_event_mtx;
+    condition_variable m_event_cv;
+    thread m_poller;
+    bool m_poller_exit;
+    bool m_poller_kick;
+    wait_policy m_policy;
+    size_t m_waiters;
+    u64 m_poll_seq;
+    u64 m_event_seq;
+    bool m_event_running;
+    string m_event_reason;
+    string m_event_error;
+    u64 m_event_time_ns;
+    u64 m_event_cycle;
+
+    void poll_events();
+    void stop_poller() noexcept;
+
     void update_version();
+    void update_version(const response& resp);
     void update_status();
+    void update_status(const response& resp);
     void update_modules();
-    void update_reason(const string& reason);
+    void create_targets(const vector<target_desc>& targets);
+    bool load_cached_modules();
+    void store_cached_modules(const vector<target_desc>& targets) noexcept;
+    string cache_key() const;
+    void start_loader();
+    void stop_loader() noexcept;
+    void wait_for_modules() const;
+    void update_reason(string_view reason);
 
 public:
+    static constexpr u64 WAIT_FOREVER = ~0ull;
+    static constexpr size_t LAZY_DEPTH = 2;
+
     session();
     session(const session_info& info);
     session(const string& host, u16 port);
@@ -110,6 +170,7 @@ public:
     const char* sysc_version() const;
     const char* vcml_version() const;
     int proto_version() const;
+    u32 capabilities() const { return m_conn.capabilities(); }
 
     u64 get_time_ns();
     u64 get_cycle_count();
@@ -122,6 +183,23 @@ public:
     u16 port() const { return m_conn.port(); }
 
     bool is_connected() const;
+
+    // lazy sessions only list the top LAZY_DEPTH levels of the hierarchy
+    // when connecting and everything below once it gets used, servers
+    // without subtree listings send everything in the background instead;
+    // takes effect on the next connect
+    bool is_lazy() const { return m_lazy; }
+    void set_lazy(bool lazy) { m_lazy = lazy; }
+
+    // with a cache directory, connecting to a simulation whose listing
+    // has been seen before maps the hierarchy from there instead of
+    // parsing it; takes effect on the next connect. Cached hierarchies are
+    // always complete and take precedence over lazy listings, which only
+    // apply when there is no image for the simulation. Servers without
+    // list digests send their full listing to check an existing image.
+    const string& cache_dir() const { return m_cache_dir; }
+    void set_cache_dir(const string& dir) { m_cache_dir = dir; }
+
     void connect(const session_info& info);
     void connect(const string& host, u16 port);
     void disconnect() noexcept;
@@ -133,6 +211,11 @@ public:
     void run();
     bool check_running();
     void stop();
+    bool wait_for_stop(u64 timeout_ms = WAIT_FOREVER);
+    wait_result wait_until_stopped(
+        std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::time_point::max(),
+        const wait_policy& policy = wait_policy());
     void set_stop_mode(vsp_stop_mode mode);
     const stop_reason& reason() const { return m_reason; }
 
@@ -140,13 +223,17 @@ public:
 
     void dump(ostream& os = std::cout);
 
-    module* find_module(const string& name = "");
-    attribute* find_attribute(const string& name);
-    command* find_command(const string& name);
+    // lookups by full hierarchy name, e.g. "system.cpu.arch"
+    module* find_module(string_view name = "") const;
+    attribute* find_attribute(string_view name) const;
+    command* find_command(string_view name) const;
     target* find_target(const string& name);
 
-    const vector<target*>& targets() const { return m_targets; }
-    const vector<module*>& modules() const;
+    const vector<target*>& targets() const;
+    const hierarchy& modules_hierarchy() const;
+    // the top level modules, ranges convert to vectors for code that
+    // still expects those
+    const element_range<module>& modules() const;
 
     const unordered_map<string, target_group>& target_groups() const;
     const target_group* find_target_group(const string& name) const;
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_SYMBOLS_H
+#define VSP_SYMBOLS_H
+
+#include "vsp/common.h"
+#include "vsp/elf.h"
+
+namespace vsp {
+
+struct symbol {
+    string_view name;
+    u64 addr;
+    u64 size;
+};
+
+// Function and object symbols of an ELF image, sorted by address into
+// flat arrays for binary search. Names point into the mapped file and
+// are only indexed on the first lookup by name.
+class symbol_index
+{
+private:
+    elf_file m_elf;
+    vector<u64> m_addrs;
+    vector<u64> m_sizes;
+    vector<string_view> m_names;
+
+    mutable std::once_flag m_name_once;
+    mutable vector<u32> m_by_name;
+
+    void load();
+    void index_names() const;
+
+public:
+    explicit symbol_index(const string& path);
+    virtual ~symbol_index() = default;
+
+    symbol_index(const symbol_index&) = delete;
+    symbol_index& operator=(const symbol_index&) = delete;
+
+    const elf_file& elf() const { return m_elf; }
+
+    size_t size() const { return m_addrs.size(); }
+    symbol at(size_t i) const { return { m_names[i], m_addrs[i], m_sizes[i] }; }
+
+    // the symbol covering addr, symbols without a size only cover the
+    // address they point to
+    optional<symbol> lookup(u64 addr) const;
+
+    // "name+0x10" for addresses covered by a symbol, empty otherwise
+    string describe(u64 addr) const;
+
+    optional<symbol> find(string_view name) const;
+};
+
+} // namespace vsp
+
+#endif
@@ -35,7 +35,47 @@ struct watchpoint {
     watchpoint_type type;
 };
 
+// register values of one target, value i is stored in
+// data[offsets[i], offsets[i + 1])
+struct reg_snapshot {
+    vector<const char*> names;
+    vector<size_t> offsets;
+    vector<u8> data;
+
+    size_t size() const { return names.size(); }
+    const u8* value(size_t i) const { return data.data() + offsets[i]; }
+    size_t value_size(size_t i) const { return offsets[i + 1] - offsets[i]; }
+    const u8* find(const string& name) const;
+};
+
+// virtually and physically contiguous part of a translated range
+struct phys_extent {
+    u64 vaddr;
+    u64 paddr;
+    u64 size;
+};
+
+// outcome of target::load_image, the checksum is the crc32 of all bytes
+// written in load order, including zero filled uninitialized data; it is
+// not checked against the target, callers can compare it with a checksum
+// of their own
+struct load_stats {
+    u64 entry;
+    size_t segments;
+    size_t bytes;
+    u32 checksum;
+    bool verified;
+    double seconds;
+
+    // bytes per second
+    double throughput() const { return seconds > 0.0 ? bytes / seconds : 0.0; }
+};
+
 class target;
+class session;
+class symbol_index;
+class byte_pattern;
+struct stop_reason;
 
 struct target_group {
     string name;
@@ -47,18 +87,79 @@ class target
 {
 private:
     connection& m_conn;
+    session& m_session;
     string m_name;
     string m_arch;
     target_group& m_group;
     vector<cpureg*> m_regs;
+    size_t m_chunk_size;
+    size_t m_depth;
+
+    size_t m_page_size;
+    u64 m_cache_epoch;
+    u64 m_cache_hits;
+    u64 m_cache_misses;
+    unordered_map<u64, vector<u8>> m_ppages;
+    unordered_map<u64, vector<u8>> m_vpages;
+
+    size_t m_tlb_page_size;
+    u64 m_tlb_epoch;
+    u64 m_tlb_hits;
+    u64 m_tlb_misses;
+    unordered_map<u64, u64> m_tlb;
+
+    reg_snapshot m_snapshot;
+    u64 m_snapshot_epoch;
+
+    std::shared_ptr<const symbol_index> m_symbols;
+
+    response m_resp;
 
     void update_regs();
+    // reads regs in one pipelined batch, values go to out at offsets
+    void fetch_regs(const vector<cpureg*>& regs, const vector<size_t>& offsets,
+                    u8* out);
+
+    void translate_pages(const vector<u64>& pages, vector<u64>& result,
+                         string* err = nullptr);
 
     void fetch_arch();
+    int proto_version();
+
+    size_t fetch_mem(const char* cmd, u64 addr, u8* buf, size_t size,
+                     string* err = nullptr);
+    size_t read_cached(const char* cmd, unordered_map<u64, vector<u8>>& pages,
+                       u64 addr, u8* buf, size_t size, string* err);
+    size_t read_mem(const char* cmd, u64 addr, u8* buf, size_t size,
+                    string* err = nullptr);
+    size_t write_mem(const char* cmd, u64 addr, const u8* data, size_t size,
+                     string* err = nullptr);
+    typedef function<void(size_t off, const u8* data, size_t len)> mem_sink;
+
+    size_t stream_mem(const char* cmd, u64 addr, size_t size,
+                      const mem_sink& sink, string* err = nullptr);
+    size_t dump_mem(const char* cmd, u64 addr, size_t size, ostream& os,
+                    bool sparse);
+    size_t dump_mem(const char* cmd, u64 addr, size_t size,
+                    const string& path, bool sparse);
+    vector<u64> search_mem(const char* cmd, u64 addr, size_t size,
+                           const byte_pattern& pattern);
 
 public:
-    target(connection& conn, const string& name, const string& arch,
-           target_group& group);
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 16 * 1024;
+    static constexpr size_t DEFAULT_PAGE_SIZE = 4096;
+    static constexpr size_t MAX_CACHED_PAGES = 4096;
+    // no target maps pages smaller than this, translations of that size
+    // are valid on any target
+    static constexpr size_t MIN_PAGE_SIZE = 1024;
+    static constexpr size_t MAX_TLB_ENTRIES = 64 * 1024;
+    static constexpr u64 NO_TRANSLATION = ~0ull;
+    static constexpr size_t LOAD_BLOCK_SIZE = 1024 * 1024;
+
+    typedef function<void(size_t done, size_t total)> load_progress;
+
+    target(connection& conn, session& sess, const string& name,
+           const string& arch, target_group& group);
     virtual ~target();
 
     target() = delete;
@@ -72,11 +173,63 @@ public:
     const char* group_name() const { return m_group.name.c_str(); }
 
     void step();
-    void step(size_t steps);
+
+    // steps this target steps times and waits for the simulation to stop
+    // again, servers without counted steps receive one step at a time
+    const stop_reason& step(size_t steps);
+
+    // steps once and reads regs within the same pipelined batch, so a step
+    // costs one round trip while the server completes it right away, the
+    // values are stored back to back in out
+    void step_and_read(const vector<cpureg*>& regs, u8* out);
 
     u64 virt_to_phys(u64 va);
 
+    // translates a virtual range page by page with all lookups pipelined,
+    // pages without a translation are left out of the extents; without
+    // the tlb, the range is looked up in steps of the given size, which
+    // must not be larger than the smallest page the target maps
+    vector<phys_extent> virt_to_phys(u64 va, size_t size,
+                                     size_t step = MIN_PAGE_SIZE);
+
+    // Translations are cached per page while the tlb is enabled, including
+    // addresses the server reports to have none, but not other errors
+    // such as an unknown target. The page size must not be larger than the
+    // smallest page the target maps. Like the page cache, the tlb is
+    // flushed whenever the simulation advances or anything gets written.
+    bool tlb_enabled() const { return m_tlb_page_size > 0; }
+    size_t tlb_page_size() const { return m_tlb_page_size; }
+    void enable_tlb(size_t page_size = DEFAULT_PAGE_SIZE);
+    void disable_tlb();
+    void flush_tlb();
+
+    u64 tlb_hits() const { return m_tlb_hits; }
+    u64 tlb_misses() const { return m_tlb_misses; }
+
+    size_t chunk_size() const { return m_chunk_size; }
+    void set_chunk_size(size_t size);
+
+    size_t transfer_depth() const { return m_depth; }
+    void set_transfer_depth(size_t depth);
+
+    // memory reads go through a page cache while it is enabled, it is
+    // flushed on any write and whenever the simulation advances
+    bool cache_enabled() const { return m_page_size > 0; }
+    size_t cache_page_size() const { return m_page_size; }
+    void enable_cache(size_t page_size = DEFAULT_PAGE_SIZE);
+    void disable_cache();
+    void flush_cache();
+
+    u64 cache_hits() const { return m_cache_hits; }
+    u64 cache_misses() const { return m_cache_misses; }
+
+    // symbols of the software running on this target, several targets of
+    // one group usually share them
+    const symbol_index* symbols() const { return m_symbols.get(); }
+    void set_symbols(std::shared_ptr<const symbol_index> symbols);
+
     breakpoint insert_breakpoint(u64 addr);
+    breakpoint insert_breakpoint(const string& symbol);
     void remove_breakpoint(const breakpoint& bp);
 
     watchpoint insert_watchpoint(u64 base, u64 size, watchpoint_type type);
@@ -88,10 +241,57 @@ public:
     vector<u8> read_pmem(u64 paddr, size_t size);
     size_t write_pmem(u64 paddr, const vector<u8>& data);
 
+    // transfer in chunks of chunk_size() with up to transfer_depth() chunks
+    // in flight, returns the number of bytes transferred before the first
+    // chunk that failed, later chunks of a write may still have been written
+    size_t read_vmem(u64 vaddr, u8* buf, size_t size);
+    size_t write_vmem(u64 vaddr, const u8* data, size_t size);
+
+    size_t read_pmem(u64 paddr, u8* buf, size_t size);
+    size_t write_pmem(u64 paddr, const u8* data, size_t size);
+
+    // Streams memory to os as it arrives, using a single chunk sized
+    // buffer no matter how large the range is. With sparse, pages that are
+    // all zeros are skipped by seeking past them, which leaves holes on
+    // file systems that support it. Returns the number of bytes dumped
+    // before the first chunk that failed.
+    size_t dump_vmem(u64 vaddr, size_t size, ostream& os, bool sparse = false);
+    size_t dump_pmem(u64 paddr, size_t size, ostream& os, bool sparse = false);
+
+    // dumps to a file, which gets created or truncated
+    size_t dump_vmem(u64 vaddr, size_t size, const string& path,
+                     bool sparse = false);
+    size_t dump_pmem(u64 paddr, size_t size, const string& path,
+                     bool sparse = false);
+
+    // Scans memory for pattern while streaming it like the dumps do, bits
+    // cleared in mask are ignored. Returns the addresses of all matches in
+    // ascending order, overlapping matches included.
+    vector<u64> search_vmem(u64 vaddr, size_t size, const vector<u8>& pattern,
+                            const vector<u8>& mask = {});
+    vector<u64> search_pmem(u64 paddr, size_t size, const vector<u8>& pattern,
+                            const vector<u8>& mask = {});
+
+    // Writes a raw binary to physical address base, or the loadable
+    // segments of an ELF file to their physical addresses offset by base.
+    // The file is mapped and sent in blocks of LOAD_BLOCK_SIZE, each one
+    // as pipelined chunks. The protocol cannot checksum memory on the
+    // target, so verify reads every block back in full, which doubles the
+    // transfer, and reports the first mismatching address. progress is
+    // called after each block with the number of bytes loaded so far and
+    // in total.
+    load_stats load_image(const string& path, u64 base = 0,
+                          bool verify = false,
+                          const load_progress& progress = nullptr);
+
     u64 get_pc();
 
     const vector<cpureg*>& regs() { return m_regs; }
     cpureg* find_reg(const string& name);
+
+    // fetches all registers at once, the snapshot stays valid until the
+    // simulation advances or a register or memory location gets written
+    const reg_snapshot& read_all_regs();
 };
 
 } // namespace vsp
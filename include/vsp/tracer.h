@@ -0,0 +1,114 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_TRACER_H
+#define VSP_TRACER_H
+
+#include "vsp/common.h"
+#include "vsp/target.h"
+
+namespace vsp {
+
+// a traced target and its traced registers, register i is stored in
+// regs[offsets[i], offsets[i + 1]) of each of its trace records
+struct trace_target {
+    string name;
+    vector<string> regs;
+    vector<size_t> offsets;
+};
+
+// state of the stepped target after one step
+struct trace_record {
+    size_t target;
+    u64 pc;
+    vector<u8> regs;
+};
+
+// Traces start with a header naming the targets and their registers,
+// followed by the records and an index. Records store the pc as a delta
+// to the previous record of the same target and only those registers
+// that changed since then. Every index_interval records the deltas start
+// over from zero and the index keeps the file offset of that record, so
+// readers can seek without decoding everything that comes before.
+class tracer
+{
+private:
+    struct traced {
+        target* tgt;
+        vector<cpureg*> regs; // the pc comes first
+        size_t pc_size;
+        trace_target info;
+    };
+
+    vector<traced> m_targets;
+    size_t m_interval;
+
+    void add_target(target& t, const vector<string>& regs);
+    size_t run(const string& path, size_t steps,
+               const function<bool(u64)>& inside);
+
+public:
+    static constexpr size_t INDEX_INTERVAL = 1024;
+
+    tracer(target& t, const vector<string>& regs = {});
+    tracer(const target_group& group, const vector<string>& regs = {});
+    virtual ~tracer() = default;
+
+    tracer(const tracer&) = delete;
+    tracer& operator=(const tracer&) = delete;
+
+    size_t index_interval() const { return m_interval; }
+    void set_index_interval(size_t interval);
+
+    // group members are stepped in turn, both return the number of records
+    size_t trace(const string& path, size_t steps);
+
+    // stops after the first record with a pc outside of [lo, hi)
+    size_t trace_range(const string& path, u64 lo, u64 hi,
+                       size_t max_steps = SIZE_MAX);
+};
+
+class trace_reader
+{
+private:
+    ifstream m_file;
+    vector<trace_target> m_targets;
+    vector<u64> m_index;
+    u64 m_count;
+    u64 m_interval;
+    u64 m_pos;
+
+    vector<u64> m_pcs;
+    vector<vector<u8>> m_regs;
+    vector<u8> m_mask;
+
+    void read(void* data, size_t size);
+    u64 read_uint(size_t size);
+    u64 read_varint();
+    string read_str();
+
+    void restart(u64 pos);
+
+public:
+    explicit trace_reader(const string& path);
+    virtual ~trace_reader() = default;
+
+    const vector<trace_target>& targets() const { return m_targets; }
+
+    size_t size() const { return m_count; }
+    size_t position() const { return m_pos; }
+
+    void seek(size_t pos);
+    bool next(trace_record& rec);
+};
+
+} // namespace vsp
+
+#endif
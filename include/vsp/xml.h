@@ -0,0 +1,111 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_XML_H
+#define VSP_XML_H
+
+#include "vsp/common.h"
+
+namespace vsp {
+
+// attributes of one start tag, only valid while its element is reported
+class xml_attrs
+{
+    friend class xml_reader;
+
+private:
+    vector<pair<string_view, string_view>> m_attrs;
+
+public:
+    size_t size() const { return m_attrs.size(); }
+    bool empty() const { return m_attrs.empty(); }
+
+    // empty if the attribute is missing
+    string_view get(string_view name) const;
+
+    // zero if the attribute is missing or not a number
+    u64 get_u64(string_view name) const;
+};
+
+// Incremental XML parser that takes its input in chunks of any size and
+// reports every element as soon as its tag is complete, so documents
+// never have to be kept in memory. It understands elements, attributes,
+// text, predefined and numeric entities, comments, CDATA sections,
+// processing instructions and declarations without internal subsets.
+// Input after the first error is ignored, finish() reports the error.
+class xml_reader
+{
+private:
+    enum markup_kind {
+        MARKUP_NONE = 0,
+        MARKUP_UNKNOWN,
+        MARKUP_TAG,
+        MARKUP_COMMENT,
+        MARKUP_CDATA,
+        MARKUP_PI,
+        MARKUP_DECL,
+    };
+
+    markup_kind m_markup;
+    char m_quote;
+    string m_buf;
+    string m_text;
+    string m_decoded;
+    string m_names;
+    vector<size_t> m_open;
+    xml_attrs m_attrs;
+    bool m_root_seen;
+    u64 m_offset;
+    u64 m_markup_pos;
+    string m_error;
+
+    void fail(const string& msg);
+
+    const char* find_markup_end(const char* p, const char* end);
+    bool has_suffix(const char* p, const char* gt, string_view suffix,
+                    size_t prefix) const;
+
+    void flush_text();
+    void markup(string_view str);
+    void start_tag(string_view str);
+    void end_tag(string_view str);
+
+    string_view decode(string_view str);
+
+protected:
+    virtual void begin_element(string_view name, const xml_attrs& attrs);
+    virtual void end_element(string_view name);
+    virtual void text(string_view text);
+    virtual void end_document();
+
+public:
+    xml_reader();
+    virtual ~xml_reader() = default;
+
+    xml_reader(const xml_reader&) = delete;
+    xml_reader& operator=(const xml_reader&) = delete;
+
+    size_t depth() const { return m_open.size(); }
+    bool failed() const { return !m_error.empty(); }
+    const string& error() const { return m_error; }
+
+    void feed(const char* data, size_t size);
+    void feed(string_view str) { feed(str.data(), str.size()); }
+
+    // reports errors and documents that end early, the reader can take
+    // another document afterwards
+    void finish();
+    void reset();
+};
+
+} // namespace vsp
+
+#endif
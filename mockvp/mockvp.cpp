@@ -0,0 +1,422 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "mockvp.h"
+
+namespace vsp {
+
+static string frame(const string& payload) {
+    string escaped;
+    escaped.reserve(payload.size() + 4);
+
+    u8 csum = 0;
+    for (char c : payload) {
+        if (c == '$' || c == '#' || c == '*' || c == '}') {
+            escaped += '}';
+            c ^= 0x20;
+        }
+
+        escaped += c;
+    }
+
+    for (char c : escaped)
+        csum += static_cast<u8>(c);
+
+    return "$" + escaped + mkstr("#%02x", csum);
+}
+
+static string hexbytes(const u8* data, size_t size) {
+    string s;
+    s.reserve(size * 3);
+    for (size_t i = 0; i < size; i++)
+        s += mkstr(",%02x", data[i]);
+    return s;
+}
+
+mockvp::mockvp(u32 caps):
+    m_caps(caps),
+    m_socket(1, 0),
+    m_mtx(),
+    m_commands(),
+    m_counts(),
+    m_mem(MEMSIZE),
+    m_regs(),
+    m_arch("mock"),
+    m_running(false),
+    m_async_steps(false),
+    m_instant_runs(false),
+    m_step_pending(false),
+    m_reason("user"),
+    m_time_ns(0),
+    m_cycle(0),
+    m_breakpoints(),
+    m_next_bp(1),
+    m_rxbytes(0),
+    m_txbytes(0),
+    m_stop(false),
+    m_thread() {
+    m_regs.emplace_back("pc", vector<u8>(8));
+    m_regs.emplace_back("sp", vector<u8>(8));
+    for (size_t i = 0; i < 8; i++)
+        m_regs.emplace_back(mkstr("r%zu", i), vector<u8>(4));
+
+    register_commands();
+    m_thread = thread(&mockvp::serve, this);
+}
+
+mockvp::~mockvp() {
+    m_stop = true;
+    m_thread.join();
+}
+
+void mockvp::serve() {
+    while (!m_stop) {
+        if (m_socket.clients().empty()) {
+            m_socket.poll(10);
+            continue;
+        }
+
+        int client = m_socket.clients().front();
+        try {
+            string packet = receive(client);
+            string resp = dispatch(packet);
+            if (!resp.empty())
+                reply(client, resp);
+            if (packet == "quit")
+                m_socket.disconnect(client);
+        } catch (mwr::report&) {
+            // client disconnected
+        }
+    }
+}
+
+string mockvp::receive(int client) {
+    string packet;
+    char c;
+
+    // skips acknowledgements of earlier responses
+    while (m_socket.recv_char(client) != '$')
+        m_rxbytes++;
+
+    while ((c = m_socket.recv_char(client)) != '#') {
+        if (c == '}') {
+            m_rxbytes++;
+            c = m_socket.recv_char(client) ^ 0x20;
+        }
+
+        packet += c;
+        m_rxbytes++;
+    }
+
+    m_socket.recv_char(client);
+    m_socket.recv_char(client);
+    m_rxbytes += 4;
+
+    m_socket.send(client, "+");
+    return packet;
+}
+
+void mockvp::reply(int client, const string& resp) {
+    string data = frame(resp);
+    m_txbytes += data.size() + 1;
+    m_socket.send(client, data.data(), data.size());
+}
+
+string mockvp::dispatch(const string& packet) {
+    string name = packet.substr(0, packet.find(','));
+
+    lock_guard lk(m_mtx);
+    m_counts[name]++;
+
+    auto it = m_commands.find(name);
+    if (it == m_commands.end())
+        return "ERROR,unknown command " + name;
+
+    try {
+        response req(string(packet), it->second.max_fields);
+        return it->second.fn(req);
+    } catch (std::exception& ex) {
+        return mkstr("ERROR,%s", ex.what());
+    }
+}
+
+void mockvp::check_target(const response& req, size_t idx) const {
+    MWR_REPORT_ON(req.at(idx) != TARGET, "unknown target");
+}
+
+void mockvp::check_range(u64 addr, size_t size) const {
+    MWR_REPORT_ON(addr > m_mem.size() || size > m_mem.size() - addr,
+                  "address out of range");
+}
+
+void mockvp::advance_reg(const string& name, u64 delta) {
+    for (auto& [regname, val] : m_regs) {
+        if (regname != name)
+            continue;
+
+        for (u8& byte : val) {
+            u64 sum = byte + (delta & 0xff);
+            byte = (u8)sum;
+            delta = (delta >> 8) + (sum >> 8);
+        }
+    }
+}
+
+vector<u8>& mockvp::find_reg(const response& req, size_t idx) {
+    for (auto& [name, val] : m_regs) {
+        if (req.at(idx) == name)
+            return val;
+    }
+
+    MWR_REPORT("unknown register");
+}
+
+// text encoding: <cmd>,<target>,<addr>,<size> -> OK,xx,xx,...
+// binary encoding: b<cmd>,<target>,<addr>,<size> -> OK,<escaped bytes>
+string mockvp::read_mem(const response& req, bool binary) {
+    check_target(req, 1);
+    u64 addr = req.to_u64(2);
+    u64 size = req.to_u64(3);
+    check_range(addr, size);
+
+    const u8* data = m_mem.data() + addr;
+    if (binary)
+        return "OK," + mwr::escape(string((const char*)data, size), ",");
+
+    return "OK" + hexbytes(data, size);
+}
+
+// text encoding: <cmd>,<target>,<addr>,<byte>,<byte>,...
+// binary encoding: b<cmd>,<target>,<addr>,<escaped bytes>
+string mockvp::write_mem(const response& req, bool binary) {
+    check_target(req, 1);
+    u64 addr = req.to_u64(2);
+    MWR_REPORT_ON(binary && req.size() != 4, "malformed binary data");
+
+    size_t size = binary ? req.at(3).size() : req.size() - 3;
+    check_range(addr, size);
+
+    u8* data = m_mem.data() + addr;
+    if (binary)
+        memcpy(data, req[3].data(), size);
+    else {
+        for (size_t i = 0; i < size; i++)
+            data[i] = (u8)req.to_u64(3 + i);
+    }
+
+    return mkstr("OK,%zu bytes written", size);
+}
+
+void mockvp::register_commands() {
+    handle("version", [this](const response&) {
+        return mkstr("OK,2.3.4,vcml-2025.01.01,%d", VSP_V2);
+    });
+
+    if (m_caps != VSP_CAP_NONE) {
+        handle("caps", [this](const response&) {
+            string resp = "OK";
+            for (u32 cap = 1; cap & VSP_CAP_ALL; cap <<= 1) {
+                if (m_caps & cap)
+                    resp += "," + string(vsp_capability_name(
+                                      (vsp_capability)cap));
+            }
+
+            return resp;
+        });
+    }
+
+    handle("status", [this](const response&) {
+        string state = m_running ? "running" : "stopped:" + m_reason;
+        if (m_step_pending)
+            m_running = m_step_pending = false;
+
+        return mkstr("OK,%s,%llu,%llu", state.c_str(),
+                     (unsigned long long)m_time_ns,
+                     (unsigned long long)m_cycle);
+    });
+
+    handle("resume", [this](const response& req) {
+        if (req.size() < 2 || !m_instant_runs) {
+            m_running = true;
+            return string("OK");
+        }
+
+        string_view duration = req[1];
+        MWR_REPORT_ON(duration.size() < 3 ||
+                          duration.substr(duration.size() - 2) != "ns",
+                      "invalid duration");
+        m_time_ns += stoull(string(duration.substr(0, duration.size() - 2)));
+        m_reason = "step";
+        return string("OK");
+    });
+
+    handle("step", [this](const response& req) {
+        check_target(req, 1);
+        MWR_REPORT_ON(m_running, "simulation running");
+        u64 steps = 1;
+        if (req.size() > 2) {
+            MWR_REPORT_ON(!has_capability(VSP_CAP_COUNTED_STEP),
+                          "too many arguments");
+            steps = req.to_u64(2);
+        }
+
+        // every instruction is four bytes long and counts up r0
+        advance_reg("pc", 4 * steps);
+        advance_reg("r0", steps);
+
+        m_reason = mkstr("target:%s:%llu", TARGET,
+                         (unsigned long long)m_time_ns);
+        m_cycle += steps;
+        m_running = m_step_pending = m_async_steps;
+        return string("OK");
+    });
+
+    handle("stop", [this](const response&) {
+        m_running = m_step_pending = false;
+        m_reason = "user";
+        return string("OK");
+    });
+
+    handle("quit", [](const response&) { return string("OK"); });
+
+    handle("list", [this](const response& req) {
+        string xml = mkstr(
+            "<hierarchy>"
+            "<object name=\"system\" kind=\"mock_system\" version=\"v1.0\">"
+            "<object name=\"cpu\" kind=\"mock_cpu\" version=\"v1.0\">"
+            "<attribute name=\"arch\" type=\"string\" count=\"1\" />"
+            "</object></object>"
+            "<target arch=\"%s\" group=\"cpus\">%s</target>"
+            "</hierarchy>",
+            m_arch.c_str(), TARGET);
+
+        if (req.size() > 1 && req[1] == "digest") {
+            MWR_REPORT_ON(!has_capability(VSP_CAP_LIST_DIGEST),
+                          "unknown listing format");
+            u64 digest = fnv1a64((const u8*)xml.data(), xml.size());
+            return mkstr("OK,%016llx", (unsigned long long)digest);
+        }
+
+        return "OK," + xml;
+    });
+
+    handle("geta", [this](const response& req) {
+        MWR_REPORT_ON(req.at(1) != "system.cpu.arch", "unknown attribute");
+        return "OK," + m_arch;
+    });
+
+    handle("seta", [this](const response& req) {
+        MWR_REPORT_ON(req.at(1) != "system.cpu.arch", "unknown attribute");
+        m_arch = req.at(2);
+        return string("OK");
+    });
+
+    handle("arch", [this](const response& req) {
+        check_target(req, 1);
+        return "OK," + m_arch;
+    });
+
+    handle("lreg", [this](const response& req) {
+        check_target(req, 1);
+        string resp = "OK";
+        for (auto& [name, val] : m_regs)
+            resp += mkstr(",%s:%zu", name.c_str(), val.size());
+        return resp;
+    });
+
+    handle("getr", [this](const response& req) {
+        check_target(req, 1);
+        auto& val = find_reg(req, 2);
+        return "OK" + hexbytes(val.data(), val.size());
+    });
+
+    handle("setr", [this](const response& req) {
+        check_target(req, 1);
+        auto& val = find_reg(req, 2);
+        MWR_REPORT_ON(req.size() != val.size() + 3, "invalid value");
+        for (size_t i = 0; i < val.size(); i++)
+            val[i] = (u8)req.to_u64(3 + i);
+        return string("OK");
+    });
+
+    handle("mkbp", [this](const response& req) {
+        check_target(req, 1);
+        u64 id = m_next_bp++;
+        m_breakpoints[id] = req.to_u64(2);
+        return mkstr("OK,inserted breakpoint %llu", (unsigned long long)id);
+    });
+
+    handle("rmbp", [this](const response& req) {
+        MWR_REPORT_ON(!m_breakpoints.erase(req.to_u64(1)),
+                      "invalid breakpoint");
+        return string("OK");
+    });
+
+    handle("vapa", [this](const response& req) {
+        check_target(req, 1);
+        return mkstr("OK,%llx", (unsigned long long)req.to_u64(2));
+    });
+
+    for (const char* cmd : { "pread", "vread" }) {
+        handle(cmd, [this](const response& req) {
+            return read_mem(req, false);
+        });
+    }
+
+    for (const char* cmd : { "pwrite", "vwrite" }) {
+        handle(cmd, [this](const response& req) {
+            return write_mem(req, false);
+        });
+    }
+
+    if (!has_capability(VSP_CAP_BINARY_MEMORY))
+        return;
+
+    for (const char* cmd : { "bpread", "bvread" }) {
+        handle(cmd, [this](const response& req) {
+            return read_mem(req, true);
+        });
+    }
+
+    for (const char* cmd : { "bpwrite", "bvwrite" }) {
+        handle(cmd, [this](const response& req) {
+            return write_mem(req, true);
+        });
+    }
+}
+
+size_t mockvp::count(const string& cmd) const {
+    lock_guard lk(m_mtx);
+    auto it = m_counts.find(cmd);
+    return it != m_counts.end() ? it->second : 0;
+}
+
+void mockvp::halt(const string& reason) {
+    lock_guard lk(m_mtx);
+    m_running = m_step_pending = false;
+    m_reason = reason;
+}
+
+void mockvp::set_async_steps(bool async) {
+    lock_guard lk(m_mtx);
+    m_async_steps = async;
+}
+
+void mockvp::set_instant_runs(bool instant) {
+    lock_guard lk(m_mtx);
+    m_instant_runs = instant;
+}
+
+void mockvp::handle(const string& cmd, handler fn, size_t max_fields) {
+    lock_guard lk(m_mtx);
+    m_commands[cmd] = { std::move(fn), max_fields };
+}
+
+} // namespace vsp
@@ -0,0 +1,120 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#ifndef VSP_MOCKVP_H
+#define VSP_MOCKVP_H
+
+#include <atomic>
+
+#include "vsp.h"
+
+namespace vsp {
+
+// in-process VSP server for tests and benchmarks that do not need a full
+// VCML simulation, it serves one client at a time and models a single
+// target with a flat, identity mapped memory
+class mockvp
+{
+public:
+    typedef function<string(const response& req)> handler;
+
+    static constexpr const char* TARGET = "system.cpu";
+    static constexpr size_t MEMSIZE = 1024 * 1024;
+    static constexpr u32 DEFAULT_CAPS = VSP_CAP_BINARY_MEMORY |
+                                        VSP_CAP_COUNTED_STEP;
+
+private:
+    struct command_info {
+        handler fn;
+        size_t max_fields;
+    };
+
+    u32 m_caps;
+    mwr::server_socket m_socket;
+
+    mutable mutex m_mtx;
+    unordered_map<string, command_info> m_commands;
+    unordered_map<string, size_t> m_counts;
+
+    vector<u8> m_mem;
+    vector<pair<string, vector<u8>>> m_regs;
+    string m_arch;
+    bool m_running;
+    bool m_async_steps;
+    bool m_instant_runs;
+    bool m_step_pending;
+    string m_reason;
+    u64 m_time_ns;
+    u64 m_cycle;
+    unordered_map<u64, u64> m_breakpoints;
+    u64 m_next_bp;
+
+    std::atomic<size_t> m_rxbytes;
+    std::atomic<size_t> m_txbytes;
+    std::atomic<bool> m_stop;
+    thread m_thread;
+
+    void serve();
+    string receive(int client);
+    void reply(int client, const string& resp);
+    string dispatch(const string& packet);
+
+    void check_target(const response& req, size_t idx) const;
+    void check_range(u64 addr, size_t size) const;
+    vector<u8>& find_reg(const response& req, size_t idx);
+    void advance_reg(const string& name, u64 delta);
+
+    string read_mem(const response& req, bool binary);
+    string write_mem(const response& req, bool binary);
+
+    void register_commands();
+
+public:
+    const char* host() const { return m_socket.host(); }
+    u16 port() const { return m_socket.port(); }
+
+    u32 capabilities() const { return m_caps; }
+    bool has_capability(vsp_capability cap) const { return m_caps & cap; }
+
+    // memory must only be accessed while no request is in flight
+    u8* memory() { return m_mem.data(); }
+
+    size_t count(const string& cmd) const;
+
+    // stops a running simulation as if something inside it hit a break
+    void halt(const string& reason = "user");
+
+    // steps keep the simulation running until the next status request,
+    // like a real simulation that takes a while to complete them
+    void set_async_steps(bool async);
+    // timed resumes complete right away instead of running until halt,
+    // as if the simulation was very fast
+    void set_instant_runs(bool instant);
+    size_t rx_bytes() const { return m_rxbytes; }
+    size_t tx_bytes() const { return m_txbytes; }
+
+    // without any capabilities, the server does not know the caps command
+    // at all, like servers that predate it
+    mockvp(u32 caps = DEFAULT_CAPS);
+    // clients must disconnect before the server goes away
+    virtual ~mockvp();
+
+    mockvp(const mockvp&) = delete;
+    mockvp& operator=(const mockvp&) = delete;
+
+    // handlers that return an empty string leave the request unanswered,
+    // like a simulation that hangs
+    void handle(const string& cmd, handler fn,
+                size_t max_fields = response::ALL_FIELDS);
+};
+
+} // namespace vsp
+
+#endif
@@ -149,8 +149,7 @@ bool session::handle_stop(const string& args) {
     }
 
     m_session->stop();
-    while (m_session->check_running())
-        ;
+    m_session->wait_for_stop();
     cout << "stopped by " << m_session->reason() << endl;
     return true;
 }
@@ -12,12 +12,10 @@
 
 namespace vsp {
 
-attribute::attribute(const string& name, connection& conn, module* parent,
-                     const string& type, size_t count):
-    element(name, conn, parent), m_type(type), m_count(count) {
+attribute::attribute(): element(), m_type(""), m_count(0) {
 }
 
-const string& attribute::type() const {
+string_view attribute::type() const {
     return m_type;
 }
 
@@ -29,12 +27,41 @@ vector<string> attribute::get() {
     if (m_count == 0)
         return vector<string>();
 
-    auto resp = m_conn.command("geta," + hierarchy_name());
+    auto resp = m_conn->command("geta," + hierarchy_name());
     MWR_REPORT_ON(resp.size() != 2, "%s: malformed response", __func__);
     resp.erase(resp.begin());
     return resp;
 }
 
+vector<vector<string>> attribute::get_all(const vector<attribute*>& attrs) {
+    vector<vector<string>> values(attrs.size());
+
+    vector<string> cmds;
+    vector<size_t> index;
+    for (size_t i = 0; i < attrs.size(); ++i) {
+        MWR_REPORT_ON(attrs[i]->m_conn != attrs[0]->m_conn,
+                      "attributes belong to different sessions");
+        if (attrs[i]->m_count == 0)
+            continue;
+
+        cmds.push_back("geta," + attrs[i]->hierarchy_name());
+        index.push_back(i);
+    }
+
+    if (cmds.empty())
+        return values;
+
+    auto resps = attrs[0]->m_conn->command_batch(cmds);
+    for (size_t i = 0; i < resps.size(); ++i) {
+        MWR_REPORT_ON(resps[i].size() != 2, "%s: malformed response",
+                      __func__);
+        resps[i].erase(resps[i].begin());
+        values[index[i]] = std::move(resps[i]);
+    }
+
+    return values;
+}
+
 string attribute::get_str() {
     try {
         auto val = get();
@@ -54,7 +81,7 @@ string attribute::get_str() {
 }
 
 void attribute::set_escaped(const string& val) {
-    m_conn.command("seta," + hierarchy_name() + "," + val);
+    m_conn->command("seta," + hierarchy_name() + "," + val);
 }
 
 void attribute::set(const char* val) {
@@ -0,0 +1,327 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/cache.h"
+#include "vsp/checksum.h"
+
+#include <random>
+
+namespace vsp {
+
+// An image is a header followed by the records of all modules, attributes,
+// commands and targets and finally the string table the records refer to
+// by offset. Modules are stored depth first, so every parent comes before
+// its children. Everything is in host byte order and every section starts
+// eight byte aligned, so the records can be used right from the mapping.
+
+struct image_header {
+    char magic[4];
+    u32 format;
+    u64 digest;
+    u32 num_mods;
+    u32 num_attrs;
+    u32 num_cmds;
+    u32 num_targets;
+    u64 strings_size;
+};
+
+struct image_module {
+    u32 name;
+    u32 kind;
+    u32 version;
+    u32 parent;
+};
+
+struct image_attribute {
+    u32 name;
+    u32 type;
+    u32 parent;
+    u32 reserved;
+    u64 count;
+};
+
+struct image_command {
+    u32 name;
+    u32 desc;
+    u32 parent;
+    u32 argc;
+};
+
+struct image_target {
+    u32 name;
+    u32 arch;
+    u32 group;
+    u32 reserved;
+};
+
+static const char IMAGE_MAGIC[4] = { 'V', 'S', 'P', 'H' };
+static constexpr u32 NO_INDEX = ~0u;
+
+static_assert(sizeof(image_header) % 8 == 0, "unaligned image header");
+static_assert(sizeof(image_module) % 8 == 0, "unaligned module record");
+static_assert(sizeof(image_attribute) % 8 == 0, "unaligned attr record");
+static_assert(sizeof(image_command) % 8 == 0, "unaligned command record");
+static_assert(sizeof(image_target) % 8 == 0, "unaligned target record");
+
+hierarchy_cache::hierarchy_cache(const string& dir): m_dir(dir) {
+    // nothing to do
+}
+
+string hierarchy_cache::key(string_view sysc_version, string_view vcml_version,
+                            int proto_version) {
+    string id = mkstr("%.*s\n%.*s\n%d", (int)sysc_version.size(),
+                      sysc_version.data(), (int)vcml_version.size(),
+                      vcml_version.data(), proto_version);
+    return mkstr("%016llx", (unsigned long long)fnv1a64(
+                                (const u8*)id.data(), id.size()));
+}
+
+string hierarchy_cache::path(const string& key, u64 digest) const {
+    fs::path file = mkstr("%s-%016llx.vsph", key.c_str(),
+                          (unsigned long long)digest);
+    return (fs::path(m_dir) / file).string();
+}
+
+bool hierarchy_cache::contains(const string& key) const {
+    std::error_code ec;
+    string prefix = key + "-";
+    for (const auto& entry : fs::directory_iterator(m_dir, ec)) {
+        if (entry.path().filename().string().compare(0, prefix.size(),
+                                                     prefix) == 0)
+            return true;
+    }
+
+    return false;
+}
+
+bool hierarchy_cache::load(const string& key, u64 digest, hierarchy& hier,
+                           vector<target_desc>& targets) const {
+    std::error_code ec;
+    string file = path(key, digest);
+    if (!fs::exists(file, ec))
+        return false;
+
+    mapped_file image;
+    try {
+        image.open(file);
+    } catch (mwr::report& r) {
+        log_warn("cannot open cached hierarchy: %s", r.what());
+        return false;
+    }
+
+    // images are checked as a whole before anything gets taken from them,
+    // a damaged one is as good as none
+    const u8* data = image.data();
+    size_t size = image.size();
+    if (size < sizeof(image_header))
+        return false;
+
+    const image_header* hdr = (const image_header*)data;
+    if (memcmp(hdr->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 ||
+        hdr->format != FORMAT || hdr->digest != digest || !hdr->num_mods ||
+        !hdr->strings_size) {
+        return false;
+    }
+
+    size_t records = hdr->num_mods * sizeof(image_module) +
+                     hdr->num_attrs * sizeof(image_attribute) +
+                     hdr->num_cmds * sizeof(image_command) +
+                     hdr->num_targets * sizeof(image_target);
+    if (hdr->strings_size > size ||
+        sizeof(image_header) + records != size - hdr->strings_size ||
+        data[size - 1] != '\0') {
+        return false;
+    }
+
+    const u8* ptr = data + sizeof(image_header);
+    const image_module* mods = (const image_module*)ptr;
+    ptr += hdr->num_mods * sizeof(image_module);
+    const image_attribute* attrs = (const image_attribute*)ptr;
+    ptr += hdr->num_attrs * sizeof(image_attribute);
+    const image_command* cmds = (const image_command*)ptr;
+    ptr += hdr->num_cmds * sizeof(image_command);
+    const image_target* tgts = (const image_target*)ptr;
+    ptr += hdr->num_targets * sizeof(image_target);
+    const char* strings = (const char*)ptr;
+
+    auto valid = [hdr](u32 str) { return str < hdr->strings_size; };
+    for (u32 i = 0; i < hdr->num_mods; i++) {
+        const image_module& mod = mods[i];
+        bool root = mod.parent == NO_INDEX;
+        if ((i == 0) != root || (!root && mod.parent >= i) ||
+            !valid(mod.name) || !valid(mod.kind) || !valid(mod.version))
+            return false;
+    }
+
+    for (u32 i = 0; i < hdr->num_attrs; i++) {
+        const image_attribute& attr = attrs[i];
+        if (attr.parent >= hdr->num_mods || !valid(attr.name) ||
+            !valid(attr.type))
+            return false;
+    }
+
+    for (u32 i = 0; i < hdr->num_cmds; i++) {
+        const image_command& cmd = cmds[i];
+        if (cmd.parent >= hdr->num_mods || !valid(cmd.name) ||
+            !valid(cmd.desc))
+            return false;
+    }
+
+    for (u32 i = 0; i < hdr->num_targets; i++) {
+        const image_target& tgt = tgts[i];
+        if (!valid(tgt.name) || !valid(tgt.arch) || !valid(tgt.group))
+            return false;
+    }
+
+    hier.clear();
+    hier.m_new_mods.reserve(hdr->num_mods);
+    for (u32 i = 0; i < hdr->num_mods; i++) {
+        const image_module& mod = mods[i];
+        size_t parent = i ? mod.parent : hierarchy::NO_PARENT;
+        hier.m_new_mods.push_back({ strings + mod.name, strings + mod.kind,
+                                    strings + mod.version, parent, true,
+                                    nullptr });
+    }
+
+    hier.m_new_attrs.reserve(hdr->num_attrs);
+    for (u32 i = 0; i < hdr->num_attrs; i++) {
+        const image_attribute& attr = attrs[i];
+        hier.m_new_attrs.push_back({ strings + attr.name, strings + attr.type,
+                                     (size_t)attr.count, attr.parent });
+    }
+
+    hier.m_new_cmds.reserve(hdr->num_cmds);
+    for (u32 i = 0; i < hdr->num_cmds; i++) {
+        const image_command& cmd = cmds[i];
+        hier.m_new_cmds.push_back({ strings + cmd.name, strings + cmd.desc,
+                                    cmd.argc, cmd.parent });
+    }
+
+    targets.clear();
+    for (u32 i = 0; i < hdr->num_targets; i++) {
+        const image_target& tgt = tgts[i];
+        targets.push_back({ strings + tgt.name, strings + tgt.arch,
+                            strings + tgt.group });
+    }
+
+    hier.finish();
+    hier.m_depth = 0;
+    hier.m_digest = digest;
+    hier.m_images.push_back(std::move(image));
+    return true;
+}
+
+void hierarchy_cache::store(const string& key, u64 digest,
+                            const hierarchy& hier,
+                            const vector<target_desc>& targets) const {
+    MWR_REPORT_ON(!hier.root(), "cannot cache an empty hierarchy");
+    MWR_REPORT_ON(hier.num_unloaded(), "cannot cache a partial hierarchy");
+
+    string strings;
+    unordered_map<string_view, u32> offsets;
+    auto add = [&strings, &offsets](string_view str) -> u32 {
+        auto it = offsets.find(str);
+        if (it != offsets.end())
+            return it->second;
+
+        MWR_REPORT_ON(strings.size() + str.size() >= NO_INDEX,
+                      "hierarchy too large to cache");
+        u32 offset = (u32)strings.size();
+        strings.append(str).push_back('\0');
+        offsets.emplace(str, offset);
+        return offset;
+    };
+
+    vector<image_module> mods;
+    vector<image_attribute> attrs;
+    vector<image_command> cmds;
+    vector<image_target> tgts;
+
+    // the keys of offsets point into the hierarchy, not into strings,
+    // which moves around while it grows
+    function<void(const module*, u32)> walk = [&](const module* mod,
+                                                  u32 parent) {
+        u32 idx = (u32)mods.size();
+        mods.push_back({ add(mod->name()), add(mod->kind()),
+                         add(mod->version()), parent });
+        for (const attribute* attr : mod->attributes()) {
+            attrs.push_back({ add(attr->name()), add(attr->type()), idx, 0,
+                              (u64)attr->count() });
+        }
+
+        for (const command* cmd : mod->commands()) {
+            cmds.push_back({ add(cmd->name()), add(cmd->desc()), idx,
+                             (u32)cmd->argc() });
+        }
+
+        for (const module* child : mod->children())
+            walk(child, idx);
+    };
+
+    walk(hier.root(), NO_INDEX);
+
+    for (const target_desc& t : targets)
+        tgts.push_back({ add(t.name), add(t.arch), add(t.group), 0 });
+
+    image_header hdr;
+    memcpy(hdr.magic, IMAGE_MAGIC, sizeof(hdr.magic));
+    hdr.format = FORMAT;
+    hdr.digest = digest;
+    hdr.num_mods = (u32)mods.size();
+    hdr.num_attrs = (u32)attrs.size();
+    hdr.num_cmds = (u32)cmds.size();
+    hdr.num_targets = (u32)tgts.size();
+    hdr.strings_size = strings.size();
+
+    // images are written under a name of their own first and then moved
+    // into place, so that concurrent clients never map a partial one
+    std::error_code ec;
+    fs::create_directories(m_dir, ec);
+    string file = path(key, digest);
+    string temp = mkstr("%s.%08x.tmp", file.c_str(), std::random_device()());
+
+    ofstream os(temp, std::ios::binary | std::ios::trunc);
+    MWR_REPORT_ON(!os, "cannot create %s", temp.c_str());
+    os.write((const char*)&hdr, sizeof(hdr));
+    os.write((const char*)mods.data(), mods.size() * sizeof(image_module));
+    os.write((const char*)attrs.data(), attrs.size() * sizeof(image_attribute));
+    os.write((const char*)cmds.data(), cmds.size() * sizeof(image_command));
+    os.write((const char*)tgts.data(), tgts.size() * sizeof(image_target));
+    os.write(strings.data(), strings.size());
+    os.close();
+
+    if (!os) {
+        fs::remove(temp, ec);
+        MWR_REPORT("cannot write %s", temp.c_str());
+    }
+
+    fs::rename(temp, file, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        MWR_REPORT("cannot store %s", file.c_str());
+    }
+
+    // only the latest listing of a simulation is worth keeping, clients
+    // that still map an older image keep it until they unmap it
+    string prefix = key + "-";
+    vector<fs::path> stale;
+    for (const auto& entry : fs::directory_iterator(m_dir, ec)) {
+        const fs::path& image = entry.path();
+        if (image.extension() == ".vsph" && image != fs::path(file) &&
+            image.filename().string().compare(0, prefix.size(), prefix) == 0)
+            stale.push_back(image);
+    }
+
+    for (const fs::path& image : stale)
+        fs::remove(image, ec);
+}
+
+} // namespace vsp
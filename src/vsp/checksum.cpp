@@ -0,0 +1,65 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/checksum.h"
+
+namespace vsp {
+
+// eight tables let the inner loop consume one 64 bit word per iteration
+struct crc32_tables {
+    u32 t[8][256];
+
+    crc32_tables() {
+        for (u32 i = 0; i < 256; i++) {
+            u32 c = i;
+            for (int k = 0; k < 8; k++)
+                c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            t[0][i] = c;
+        }
+
+        for (u32 i = 0; i < 256; i++) {
+            for (int k = 1; k < 8; k++)
+                t[k][i] = t[0][t[k - 1][i] & 0xff] ^ (t[k - 1][i] >> 8);
+        }
+    }
+};
+
+u32 crc32(const u8* data, size_t size, u32 crc) {
+    static const crc32_tables tables;
+    const auto& t = tables.t;
+
+    crc = ~crc;
+    while (size >= 8) {
+        u32 lo = (u32)data[0] | (u32)data[1] << 8 | (u32)data[2] << 16 |
+                 (u32)data[3] << 24;
+        u32 hi = (u32)data[4] | (u32)data[5] << 8 | (u32)data[6] << 16 |
+                 (u32)data[7] << 24;
+        lo ^= crc;
+        crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^
+              t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^ t[3][hi & 0xff] ^
+              t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+        data += 8;
+        size -= 8;
+    }
+
+    while (size--)
+        crc = t[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+u64 fnv1a64(const u8* data, size_t size, u64 hash) {
+    while (size--)
+        hash = (hash ^ *data++) * 0x100000001b3ull;
+    return hash;
+}
+
+} // namespace vsp
@@ -14,9 +14,7 @@
 
 namespace vsp {
 
-command::command(const string& name, connection& conn, module* parent,
-                 size_t argc, const string& desc):
-    element(name, conn, parent), m_argc(argc), m_desc(desc) {
+command::command(): element(), m_argc(0), m_desc("") {
 }
 
 string command::execute(const vector<string>& args) {
@@ -28,7 +26,7 @@ string command::execute(const vector<string>& args) {
 }
 
 string command::execute(const string& args) {
-    auto resp = m_conn.command("exec," + m_parent->hierarchy_name() + "," +
+    auto resp = m_conn->command("exec," + m_parent->hierarchy_name() + "," +
                                name() + (args.empty() ? "" : "," + args));
 
     stringstream ss;
@@ -42,7 +40,7 @@ string command::execute(const string& args) {
 }
 
 const char* command::desc() const {
-    return m_desc.c_str();
+    return m_desc;
 }
 
 size_t command::argc() const {
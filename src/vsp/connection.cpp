@@ -13,8 +13,133 @@
 namespace vsp {
 
 static const int MAX_RETRIES = 5;
+static const size_t RXBUF_SIZE = 64 * 1024;
+static const size_t MIN_PACKET_SIZE = 128;
 
-connection::connection(): m_mtx(), m_socket() {
+static const pair<vsp_capability, const char*> CAPABILITIES[] = {
+    { VSP_CAP_BINARY_MEMORY, "binmem" },
+    { VSP_CAP_COUNTED_STEP, "stepn" },
+    { VSP_CAP_SUBTREE_LIST, "listsub" },
+    { VSP_CAP_LIST_DIGEST, "listdigest" },
+};
+
+const char* vsp_capability_name(vsp_capability cap) {
+    for (const auto& [c, name] : CAPABILITIES) {
+        if (c == cap)
+            return name;
+    }
+
+    return nullptr;
+}
+
+u32 parse_capabilities(const response& resp) {
+    u32 caps = VSP_CAP_NONE;
+    for (size_t i = 1; i < resp.size(); i++) {
+        for (const auto& [cap, name] : CAPABILITIES) {
+            if (resp[i] == name)
+                caps |= cap;
+        }
+    }
+
+    return caps;
+}
+
+// collects a packet into a string, starting over whenever the peer does
+struct packet_sink {
+    string& packet;
+
+    void append(const char* data, size_t size) { packet.append(data, size); }
+    void restart() { packet.clear(); }
+};
+
+// Splits a packet into fields while it arrives, the same way the response
+// class does it. The first field tells success from failure, the second
+// one goes to the stream sink or becomes the error message and all further
+// fields are dropped. Once the sink has seen data, a packet that gets
+// resent after a checksum error cannot be taken back anymore.
+struct field_sink {
+    const connection::stream_sink& sink;
+    string status;
+    string error;
+    size_t field;
+    bool escaped;
+    bool streamed;
+
+    explicit field_sink(const connection::stream_sink& s):
+        sink(s), status(), error(), field(0), escaped(false), streamed(false) {
+        // nothing to do
+    }
+
+    void emit(const char* data, size_t size) {
+        if (size == 0 || field > 1)
+            return;
+
+        if (field == 0) {
+            status.append(data, size);
+        } else if (status == "OK") {
+            sink(data, size);
+            streamed = true;
+        } else {
+            error.append(data, size);
+        }
+    }
+
+    void append(const char* data, size_t size) {
+        const char* end = data + size;
+        while (data != end) {
+            if (escaped) {
+                emit(data++, 1);
+                escaped = false;
+                continue;
+            }
+
+            const char* it = data;
+            while (it != end && *it != '\\' && *it != ',')
+                it++;
+
+            emit(data, it - data);
+            if (it == end)
+                break;
+
+            if (*it == '\\')
+                escaped = true;
+            else
+                field++;
+            data = it + 1;
+        }
+    }
+
+    void restart() {
+        MWR_REPORT_ON(streamed, "checksum error in streamed response");
+        status.clear();
+        error.clear();
+        field = 0;
+        escaped = false;
+    }
+
+    // a backslash at the very end of a packet escapes nothing
+    void finish() {
+        if (escaped)
+            emit("\\", 1);
+        escaped = false;
+    }
+};
+
+connection::connection():
+    m_mtx(),
+    m_socket(),
+    m_tx(),
+    m_rxbuf(),
+    m_rxpos(0),
+    m_rxlen(0),
+    m_protover(VSP_UNKNOWN),
+    m_caps(VSP_CAP_NONE),
+    m_epoch(0),
+    m_queue_mtx(),
+    m_queue_cv(),
+    m_queue(),
+    m_stop(false),
+    m_worker() {
     // nothing to do
 }
 
@@ -22,84 +147,192 @@ connection::connection(const string& host, u16 port): connection() {
     connect(host, port);
 }
 
+// the worker of other must be gone before any of its members are moved
 connection::connection(connection&& other) noexcept:
-    m_mtx(), m_socket(std::move(other.m_socket)) {
+    m_mtx(),
+    m_socket(std::move(other.stop_worker().m_socket)),
+    m_tx(),
+    m_rxbuf(std::move(other.m_rxbuf)),
+    m_rxpos(other.m_rxpos),
+    m_rxlen(other.m_rxlen),
+    m_protover(other.m_protover),
+    m_caps(other.m_caps),
+    m_epoch(other.m_epoch.load()),
+    m_queue_mtx(),
+    m_queue_cv(),
+    m_queue(std::move(other.m_queue)),
+    m_stop(false),
+    m_worker() {
+    other.m_rxpos = other.m_rxlen = 0;
+    other.m_queue.clear();
+    other.m_stop = false;
+
+    // commands that were still queued get sent from here instead
+    if (!m_queue.empty())
+        m_worker = thread(&connection::work, this);
+}
+
+connection::~connection() {
+    {
+        lock_guard lk(m_queue_mtx);
+        m_stop = true;
+    }
+
+    m_queue_cv.notify_all();
+
+    // a worker blocked on an unresponsive peer only wakes up once the
+    // socket is gone
+    if (m_worker.joinable()) {
+        disconnect();
+        m_worker.join();
+    }
+
+    for (auto& [cmd, resp] : m_queue) {
+        auto err = std::make_exception_ptr(mwr::report("connection closed"));
+        resp.set_exception(err);
+    }
+}
+
+connection& connection::stop_worker() {
+    {
+        lock_guard lk(m_queue_mtx);
+        m_stop = true;
+    }
+
+    m_queue_cv.notify_all();
+    if (m_worker.joinable())
+        m_worker.join();
+
+    return *this;
+}
+
+void connection::work() {
+    while (true) {
+        deque<pair<string, promise<vector<string>>>> jobs;
+
+        {
+            unique_lock lk(m_queue_mtx);
+            m_queue_cv.wait(lk, [this]() { return m_stop || !m_queue.empty(); });
+            if (m_stop)
+                return;
+            jobs.swap(m_queue);
+        }
+
+        // whatever queued up while the last batch was in flight goes out
+        // as one pipelined batch, responses are matched in FIFO order
+        size_t done = 0;
+        try {
+            pipeline(
+                jobs.size(),
+                [&jobs](size_t i, packet& pkt) { pkt.begin(jobs[i].first); },
+                [&jobs, &done](size_t i, response& resp) {
+                    try {
+                        check(resp);
+                        jobs[i].second.set_value(resp.to_vector());
+                    } catch (...) {
+                        jobs[i].second.set_exception(
+                            std::current_exception());
+                    }
+
+                    done = i + 1;
+                });
+        } catch (...) {
+            for (size_t i = done; i < jobs.size(); i++)
+                jobs[i].second.set_exception(std::current_exception());
+        }
+    }
 }
 
 void connection::connect(const string& host, u16 port) {
+    lock_guard lk(m_mtx);
+    m_rxpos = m_rxlen = 0;
+    m_protover = VSP_UNKNOWN;
+    m_caps = VSP_CAP_NONE;
+    m_epoch++;
     m_socket.connect(host, port);
 }
 
+// does not take m_mtx, so that other threads can unblock a request that
+// waits for an unresponsive peer; the receive buffer gets reset by the
+// request that fails or by the next connect
 void connection::disconnect() noexcept {
     m_socket.disconnect();
 }
 
-u8 connection::checksum(const string& s) {
-    u8 result = 0;
-    for (const char& c : s)
-        result += static_cast<u8>(c);
-    return result;
+void connection::close() noexcept {
+    m_socket.disconnect();
+    m_rxpos = m_rxlen = 0;
 }
 
-string connection::escape(const string& s) {
-    string result;
+void connection::fill() {
+    if (m_rxbuf.size() < RXBUF_SIZE)
+        m_rxbuf.resize(RXBUF_SIZE);
 
-    for (char ch : s) {
-        if (ch == '$' || ch == '#' || ch == '*' || ch == '}')
-            result += { '}', char(ch ^ 0x20) };
-        else
-            result += ch;
-    }
-    return result;
+    // block for at least one byte, then take everything that has arrived
+    size_t avail = std::max<size_t>(m_socket.peek(), 1);
+    m_rxlen = std::min(avail, m_rxbuf.size());
+    m_rxpos = 0;
+
+    m_socket.recv(m_rxbuf.data(), m_rxlen);
 }
 
-vector<string> connection::decompose(const string& s) {
-    vector<string> l;
-    string b;
-    size_t i = 0;
+char connection::recv_char() {
+    if (m_rxpos == m_rxlen)
+        fill();
+    return m_rxbuf[m_rxpos++];
+}
 
-    while (i < s.size()) {
-        if (s[i] == '\\' && i < s.size() - 1) {
-            b += s[i + 1];
-            i += 2;
-        } else if (s[i] == ',') {
-            l.push_back(std::move(b));
-            b = string();
-            ++i;
-        } else {
-            b += s[i];
-            i += 1;
-        }
+void connection::check(const response& resp) {
+    if (resp.empty())
+        MWR_REPORT("server sent empty response");
+    if (!resp.ok()) {
+        string errmsg(resp.error());
+        MWR_REPORT("%s", errmsg.c_str());
     }
-    l.push_back(std::move(b));
-
-    return l;
 }
 
-string connection::recv() {
-    string packet;
+template <typename SINK>
+void connection::recv(SINK& sink, bool ack) {
     u8 checksum = 0;
     int repeat = MAX_RETRIES;
 
     while (m_socket.is_connected()) {
-        char r = m_socket.recv_char();
+        if (m_rxpos == m_rxlen)
+            fill();
+
+        // consume payload up to the next framing character in one go
+        const char* head = m_rxbuf.data() + m_rxpos;
+        const char* tail = m_rxbuf.data() + m_rxlen;
+        const char* it = head;
+        while (it != tail && *it != '$' && *it != '#' && *it != '}')
+            checksum += static_cast<u8>(*it++);
+
+        sink.append(head, it - head);
+        m_rxpos += it - head;
+        if (it == tail)
+            continue;
+
+        char r = recv_char();
 
         switch (r) {
         case '$':
-            packet = "";
+            sink.restart();
             checksum = 0;
             break;
 
         case '#': {
-            u8 refsum = stoi(
-                string({ static_cast<char>(m_socket.recv_char()),
-                         static_cast<char>(m_socket.recv_char()) }),
-                nullptr, 16);
+            char hi = recv_char();
+            char lo = recv_char();
+            u8 refsum = stoi(string({ hi, lo }), nullptr, 16);
             if (checksum == refsum) {
-                m_socket.send_char(ACK);
-                return packet;
+                if (ack)
+                    m_socket.send_char(ACK);
+                return;
             }
 
+            // pipelined responses have been acknowledged in advance
+            MWR_REPORT_ON(!ack, "checksum error in pipelined response");
+
             m_socket.send_char(NACK);
             if (--repeat == 0)
                 MWR_REPORT("server nack while receiving");
@@ -108,58 +341,170 @@ string connection::recv() {
 
         case '}':
             checksum += static_cast<u8>(r);
-            r = m_socket.recv_char();
+            r = recv_char();
             checksum += static_cast<u8>(r);
-            packet += r ^ 0x20;
+            r ^= 0x20;
+            sink.append(&r, 1);
             break;
-
-        default:
-            checksum += static_cast<u8>(r);
-            packet += r;
         }
     }
 
     MWR_REPORT("server response too long");
 }
 
-void connection::send(const string& data) {
-    if (!m_socket.is_connected())
-        MWR_REPORT("not connected");
+void connection::recv(string& packet, bool ack) {
+    // short responses such as status fit right away, so reused buffers
+    // do not regrow when the numbers in them gain another digit
+    packet.clear();
+    if (packet.capacity() < MIN_PACKET_SIZE)
+        packet.reserve(MIN_PACKET_SIZE);
+
+    packet_sink sink{ packet };
+    recv(sink, ack);
+}
 
-    string escaped_data = escape(data);
-    stringstream ss;
+void connection::receive(response& resp, size_t max_fields, bool ack) {
+    string buffer = resp.release();
+    recv(buffer, ack);
+    resp.assign(std::move(buffer), max_fields);
+}
 
-    ss << '$' << escaped_data << '#' << std::hex << std::setw(2)
-       << std::setfill('0') << static_cast<int>(checksum(escaped_data));
+void connection::transmit() {
+    if (!m_socket.is_connected())
+        MWR_REPORT("not connected");
 
     try {
         for (int i = 0; i < MAX_RETRIES; i++) {
-            m_socket.send(ss.str());
-            if (m_socket.recv_char() == ACK)
+            m_socket.send(m_tx.str());
+            if (recv_char() == ACK)
                 return;
         }
 
         MWR_REPORT("server nack while sending");
     } catch (mwr::report&) {
-        disconnect();
+        close();
+        throw;
+    }
+}
+
+response connection::request(const string& cmd, size_t max_fields) {
+    response resp;
+    request(resp, max_fields, cmd);
+    return resp;
+}
+
+void connection::request_stream(const string& cmd, const stream_sink& sink) {
+    lock_guard lk(m_mtx);
+    m_tx.clear();
+    m_tx.begin(cmd);
+    m_tx.finish();
+    transmit();
+
+    field_sink fields(sink);
+    try {
+        recv(fields, true);
+    } catch (...) {
+        // the rest of the response is still on its way, so the stream is
+        // out of sync no matter whether the sink or the transport failed
+        close();
         throw;
     }
+
+    fields.finish();
+    if (fields.status != "OK") {
+        MWR_REPORT("%s", fields.field > 0 ? fields.error.c_str()
+                                          : "unknown error");
+    }
 }
 
 vector<string> connection::command(const string& cmd) {
+    return request(cmd).to_vector();
+}
+
+vector<vector<string>> connection::command_batch(const vector<string>& cmds) {
+    vector<response> resps(cmds.size());
+    pipeline(
+        cmds.size(), [&cmds](size_t i, packet& pkt) { pkt.begin(cmds[i]); },
+        [&resps](size_t i, response& resp) { resps[i] = std::move(resp); });
+
+    vector<vector<string>> result;
+    result.reserve(resps.size());
+    for (const auto& resp : resps) {
+        check(resp);
+        result.push_back(resp.to_vector());
+    }
+
+    return result;
+}
+
+future<vector<string>> connection::command_async(const string& cmd) {
+    lock_guard lk(m_queue_mtx);
+    if (!m_worker.joinable())
+        m_worker = thread(&connection::work, this);
+
+    m_queue.emplace_back(cmd, promise<vector<string>>());
+    auto result = m_queue.back().second.get_future();
+    m_queue_cv.notify_one();
+    return result;
+}
+
+void connection::pipeline(
+    size_t count, const function<void(size_t, packet&)>& request,
+    const function<void(size_t, response&)>& handler, size_t depth,
+    size_t max_fields) {
+    if (count == 0)
+        return;
+
     lock_guard lk(m_mtx);
-    send(cmd);
-    auto resp = decompose(recv());
-    if (resp.empty())
-        MWR_REPORT("server sent empty response");
-    if (resp.at(0) != "OK") {
-        string errmsg = "unknown error";
-        if (resp.size() > 1)
-            errmsg = resp.at(1);
-        MWR_REPORT("%s", errmsg.c_str());
+    if (!m_socket.is_connected())
+        MWR_REPORT("not connected");
+
+    // Every request is immediately followed by the ACK for its response,
+    // so the server finds that ACK right after sending the response and
+    // can move on to the next request without waiting for us. The flip
+    // side is that NACKs cannot be recovered from: the stream is out of
+    // sync at that point, so the connection gets dropped instead.
+    std::exception_ptr error;
+    depth = std::max<size_t>(depth, 1);
+
+    try {
+        size_t sent = 0;
+        m_tx.clear();
+        for (; sent < std::min(count, depth); sent++) {
+            request(sent, m_tx);
+            m_tx.finish().append(ACK);
+        }
+
+        m_socket.send(m_tx.str());
+
+        response resp;
+        for (size_t i = 0; i < count; i++) {
+            if (recv_char() != ACK)
+                MWR_REPORT("server nack while pipelining");
+
+            receive(resp, max_fields, false);
+
+            if (sent < count) {
+                m_tx.clear();
+                request(sent++, m_tx);
+                m_tx.finish().append(ACK);
+                m_socket.send(m_tx.str());
+            }
+
+            try {
+                handler(i, resp);
+            } catch (...) {
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    } catch (mwr::report&) {
+        close();
+        throw;
     }
 
-    return resp;
+    if (error)
+        std::rethrow_exception(error);
 }
 
 } // namespace vsp
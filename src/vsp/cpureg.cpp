@@ -10,12 +10,13 @@
 
 #include "vsp/cpureg.h"
 #include "vsp/target.h"
+#include "vsp/hexdec.h"
 
 namespace vsp {
 
 cpureg::cpureg(connection& conn, const string& name, target& parent,
                size_t size):
-    m_conn(conn), m_name(name), m_size(size), m_parent(parent) {
+    m_conn(conn), m_name(name), m_size(size), m_parent(parent), m_resp() {
     if (m_size == 0)
         update_size();
 }
@@ -31,27 +32,20 @@ size_t cpureg::size() const {
 }
 
 void cpureg::get_value(vector<u8>& ret) {
-    ret.clear();
-    auto resp = m_conn.command("getr," + string(m_parent.name()) + "," +
-                               m_name);
-    if (resp.size() != m_size + 1)
+    ret.resize(m_size);
+    m_conn.request(m_resp, 2, "getr", m_parent.name(), m_name);
+    string_view data = m_resp.size() > 1 ? m_resp[1] : "";
+    if (!decode_hex(data, ret.data(), m_size))
         MWR_REPORT("%s: malformed response", __func__);
-
-    ret.reserve(resp.size() - 1);
-    for (size_t i = 1; i < resp.size(); ++i)
-        ret.emplace_back((u8)(stoul(resp.at(i), nullptr, 16)));
 }
 
 void cpureg::set_value(const vector<u8>& val) {
     if (val.size() != m_size)
         MWR_REPORT("%s: invalid initializer", __func__);
 
-    stringstream ss;
-    ss << "setr," << m_parent.name() << ',' << m_name;
-    for (auto& v : val)
-        ss << ',' << static_cast<u32>(v);
-
-    m_conn.command(ss.str());
+    m_conn.request(m_resp, response::ALL_FIELDS, "setr", m_parent.name(),
+                   m_name, decimal_data{ val.data(), val.size() });
+    m_conn.advance_epoch();
 }
 
 const char* cpureg::name() const {
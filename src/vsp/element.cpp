@@ -14,10 +14,6 @@
 
 namespace vsp {
 
-element::element(const string& name, connection& conn, module* parent):
-    m_conn(conn), m_parent(parent), m_name(name) {
-}
-
 string element::hierarchy_name() const {
     if (!m_parent)
         return "";
@@ -0,0 +1,154 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/elf.h"
+
+namespace vsp {
+
+static constexpr size_t EI_NIDENT = 16;
+static constexpr u8 ELFCLASS32 = 1;
+static constexpr u8 ELFCLASS64 = 2;
+static constexpr u8 ELFDATA2LSB = 1;
+static constexpr u8 ELFDATA2MSB = 2;
+
+elf_file::elf_file(const string& path): elf_file(mapped_file(path)) {
+    // nothing to do
+}
+
+elf_file::elf_file(mapped_file&& file):
+    m_file(std::move(file)),
+    m_64bit(),
+    m_big_endian(),
+    m_machine(),
+    m_entry(),
+    m_segments(),
+    m_sections() {
+    parse();
+}
+
+bool elf_file::is_elf(const u8* data, size_t size) {
+    return size >= EI_NIDENT && memcmp(data, "\x7f" "ELF", 4) == 0;
+}
+
+u64 elf_file::read(u64 offset, size_t size) const {
+    MWR_REPORT_ON(offset > m_file.size() || size > m_file.size() - offset,
+                  "truncated elf file");
+
+    const u8* p = m_file.data() + offset;
+    u64 val = 0;
+    for (size_t i = 0; i < size; i++) {
+        size_t idx = m_big_endian ? i : size - 1 - i;
+        val = (val << 8) | p[idx];
+    }
+
+    return val;
+}
+
+void elf_file::parse() {
+    const u8* data = m_file.data();
+    MWR_REPORT_ON(!is_elf(data, m_file.size()), "not an elf file");
+    MWR_REPORT_ON(data[4] != ELFCLASS32 && data[4] != ELFCLASS64,
+                  "invalid elf class %u", (unsigned)data[4]);
+    MWR_REPORT_ON(data[5] != ELFDATA2LSB && data[5] != ELFDATA2MSB,
+                  "invalid elf data encoding %u", (unsigned)data[5]);
+
+    m_64bit = data[4] == ELFCLASS64;
+    m_big_endian = data[5] == ELFDATA2MSB;
+
+    // field offsets and sizes differ between the two classes, but the
+    // order of the fields is the same except for the program headers
+    const size_t word = m_64bit ? 8 : 4;
+    m_machine = (u16)read(18, 2);
+    m_entry = read(24, word);
+    u64 phoff = read(24 + word, word);
+    u64 shoff = read(24 + 2 * word, word);
+    size_t hdr = 24 + 3 * word + 4 + 2;
+    u64 phentsize = read(hdr, 2);
+    u64 phnum = read(hdr + 2, 2);
+    u64 shentsize = read(hdr + 4, 2);
+    u64 shnum = read(hdr + 6, 2);
+    u64 shstrndx = read(hdr + 8, 2);
+
+    // header tables are checked as a whole, so that the offset of an entry
+    // cannot wrap around; entry sizes and counts are 16 bit wide each
+    MWR_REPORT_ON(phnum && (phoff > m_file.size() ||
+                            phnum * phentsize > m_file.size() - phoff),
+                  "elf program headers exceed file");
+    MWR_REPORT_ON(shnum && (shoff > m_file.size() ||
+                            shnum * shentsize > m_file.size() - shoff),
+                  "elf section headers exceed file");
+
+    for (u64 i = 0; i < phnum; i++) {
+        u64 ph = phoff + i * phentsize;
+        elf_segment seg;
+        seg.type = (u32)read(ph, 4);
+        if (m_64bit) {
+            seg.flags = (u32)read(ph + 4, 4);
+            seg.offset = read(ph + 8, 8);
+            seg.vaddr = read(ph + 16, 8);
+            seg.paddr = read(ph + 24, 8);
+            seg.filesz = read(ph + 32, 8);
+            seg.memsz = read(ph + 40, 8);
+        } else {
+            seg.offset = read(ph + 4, 4);
+            seg.vaddr = read(ph + 8, 4);
+            seg.paddr = read(ph + 12, 4);
+            seg.filesz = read(ph + 16, 4);
+            seg.memsz = read(ph + 20, 4);
+            seg.flags = (u32)read(ph + 24, 4);
+        }
+
+        MWR_REPORT_ON(seg.offset > m_file.size() ||
+                          seg.filesz > m_file.size() - seg.offset,
+                      "elf segment %llu exceeds file", (unsigned long long)i);
+        m_segments.push_back(seg);
+    }
+
+    vector<u32> names;
+    for (u64 i = 0; i < shnum; i++) {
+        u64 sh = shoff + i * shentsize;
+        elf_section sec;
+        names.push_back((u32)read(sh, 4));
+        sec.type = (u32)read(sh + 4, 4);
+        sec.addr = read(sh + 8 + word, word);
+        sec.offset = read(sh + 8 + 2 * word, word);
+        sec.size = read(sh + 8 + 3 * word, word);
+        sec.link = (u32)read(sh + 8 + 4 * word, 4);
+        sec.entsize = read(sh + 16 + 5 * word, word);
+        m_sections.push_back(sec);
+    }
+
+    if (shstrndx >= m_sections.size())
+        return;
+
+    const elf_section& strtab = m_sections[shstrndx];
+    if (strtab.offset > size() || strtab.size > size() - strtab.offset)
+        return;
+
+    for (size_t i = 0; i < m_sections.size(); i++) {
+        if (names[i] >= strtab.size)
+            continue;
+
+        const char* s = (const char*)data + strtab.offset + names[i];
+        size_t max = strtab.size - names[i];
+        m_sections[i].name = string_view(s, strnlen(s, max));
+    }
+}
+
+const elf_section* elf_file::find_section(u32 type) const {
+    for (const elf_section& sec : m_sections) {
+        if (sec.type == type)
+            return &sec;
+    }
+
+    return nullptr;
+}
+
+} // namespace vsp
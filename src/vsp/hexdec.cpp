@@ -0,0 +1,262 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/hexdec.h"
+#include "vsp/simd.h"
+
+#include <array>
+
+namespace vsp {
+
+static constexpr u8 NOHEX = 0xff;
+
+static constexpr std::array<u8, 256> make_hexlut() {
+    std::array<u8, 256> lut{};
+    for (size_t i = 0; i < lut.size(); i++)
+        lut[i] = NOHEX;
+    for (u8 i = 0; i < 10; i++)
+        lut['0' + i] = i;
+    for (u8 i = 0; i < 6; i++)
+        lut['a' + i] = lut['A' + i] = 10 + i;
+    return lut;
+}
+
+static constexpr std::array<u8, 256> HEXLUT = make_hexlut();
+
+// handles one or two digits per field, picks up wherever a vector kernel
+// had to stop or bailed out because the input did not have the expected
+// fixed two-digits-and-a-comma layout
+static bool decode_scalar(const char* s, const char* end, u8* out,
+                          size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (s == end)
+            return false;
+
+        u8 val = HEXLUT[(u8)*s++];
+        if (val == NOHEX)
+            return false;
+
+        if (s != end && *s != ',') {
+            u8 lo = HEXLUT[(u8)*s++];
+            if (lo == NOHEX)
+                return false;
+            val = val << 4 | lo;
+        }
+
+        out[i] = val;
+
+        if (i + 1 < count && (s == end || *s++ != ','))
+            return false;
+    }
+
+    return s == end;
+}
+
+#ifdef VSP_HAVE_SSE2
+
+// converts 16 characters to their nibble values, hex and comma report
+// which lanes held hex digits and commas
+static inline __m128i nibbles_sse2(__m128i x, int& hex, int& comma) {
+    __m128i dig = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    __m128i isdig = _mm_cmpeq_epi8(_mm_min_epu8(dig, _mm_set1_epi8(9)), dig);
+    __m128i alp = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)),
+                               _mm_set1_epi8('a'));
+    __m128i isalp = _mm_cmpeq_epi8(_mm_min_epu8(alp, _mm_set1_epi8(5)), alp);
+
+    hex = _mm_movemask_epi8(_mm_or_si128(isdig, isalp));
+    comma = _mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(',')));
+
+    return _mm_or_si128(
+        _mm_and_si128(isdig, dig),
+        _mm_and_si128(isalp, _mm_add_epi8(alp, _mm_set1_epi8(10))));
+}
+
+// decodes 48 characters "xx,xx,...,xx," into 16 bytes
+static inline bool block_sse2(const char* s, u8* out) {
+    static constexpr int COMMAS[3] = { 0x4924, 0x2492, 0x9249 };
+
+    __m128i n[3];
+    for (int i = 0; i < 3; i++) {
+        int hex, comma;
+        __m128i x = _mm_loadu_si128((const __m128i*)(s + 16 * i));
+        n[i] = nibbles_sse2(x, hex, comma);
+        if (comma != COMMAS[i] || hex != (~COMMAS[i] & 0xffff))
+            return false;
+    }
+
+    // nibbles are below 16, so a 16bit shift acts like a per-byte shift
+    alignas(16) u8 comb[48];
+    for (int i = 0; i < 3; i++) {
+        __m128i next = _mm_srli_si128(n[i], 1);
+        if (i < 2)
+            next = _mm_or_si128(next, _mm_slli_si128(n[i + 1], 15));
+        __m128i hi = _mm_slli_epi16(n[i], 4);
+        _mm_store_si128((__m128i*)(comb + 16 * i), _mm_or_si128(hi, next));
+    }
+
+    for (int k = 0; k < 16; k++)
+        out[k] = comb[3 * k];
+
+    return true;
+}
+
+static bool decode_sse2(const char* s, const char* end, u8* out,
+                        size_t count) {
+    while (count > 16 && end - s >= 48 && block_sse2(s, out)) {
+        s += 48;
+        out += 16;
+        count -= 16;
+    }
+
+    return decode_scalar(s, end, out, count);
+}
+
+#endif
+
+#ifdef VSP_HAVE_AVX2
+
+VSP_TARGET_AVX2
+static inline __m256i nibbles_avx2(__m256i x, u32& hex, u32& comma) {
+    __m256i dig = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+    __m256i isdig = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(dig, _mm256_set1_epi8(9)), dig);
+    __m256i alp = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)),
+                                  _mm256_set1_epi8('a'));
+    __m256i isalp = _mm256_cmpeq_epi8(
+        _mm256_min_epu8(alp, _mm256_set1_epi8(5)), alp);
+
+    hex = (u32)_mm256_movemask_epi8(_mm256_or_si256(isdig, isalp));
+    comma = (u32)_mm256_movemask_epi8(
+        _mm256_cmpeq_epi8(x, _mm256_set1_epi8(',')));
+
+    return _mm256_or_si256(
+        _mm256_and_si256(isdig, dig),
+        _mm256_and_si256(isalp, _mm256_add_epi8(alp, _mm256_set1_epi8(10))));
+}
+
+// collects every third byte of 48 bytes into 16 bytes
+VSP_TARGET_AVX2
+static inline __m128i gather_avx2(__m128i a, __m128i b, __m128i c) {
+    const __m128i ma = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1,
+                                     -1, -1, -1, -1, -1);
+    const __m128i mb = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14,
+                                     -1, -1, -1, -1, -1);
+    const __m128i mc = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                     -1, 1, 4, 7, 10, 13);
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, ma),
+                                     _mm_shuffle_epi8(b, mb)),
+                        _mm_shuffle_epi8(c, mc));
+}
+
+// decodes 96 characters "xx,xx,...,xx," into 32 bytes, looks at one
+// character beyond the block, which callers must guarantee to exist
+VSP_TARGET_AVX2
+static inline bool block_avx2(const char* s, u8* out) {
+    static constexpr u32 COMMAS[3] = { 0x24924924, 0x49249249, 0x92492492 };
+
+    __m256i comb[3];
+    for (int i = 0; i < 3; i++) {
+        u32 hex, comma, nhex, ncomma;
+        __m256i x = _mm256_loadu_si256((const __m256i*)(s + 32 * i));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(s + 32 * i + 1));
+        __m256i hi = nibbles_avx2(x, hex, comma);
+        __m256i lo = nibbles_avx2(y, nhex, ncomma);
+        if (comma != COMMAS[i] || hex != ~COMMAS[i])
+            return false;
+
+        // nibbles are below 16, so a 16bit shift acts like a per-byte shift
+        comb[i] = _mm256_or_si256(_mm256_slli_epi16(hi, 4), lo);
+    }
+
+    __m128i lo = gather_avx2(_mm256_castsi256_si128(comb[0]),
+                             _mm256_extracti128_si256(comb[0], 1),
+                             _mm256_castsi256_si128(comb[1]));
+    __m128i hi = gather_avx2(_mm256_extracti128_si256(comb[1], 1),
+                             _mm256_castsi256_si128(comb[2]),
+                             _mm256_extracti128_si256(comb[2], 1));
+
+    _mm_storeu_si128((__m128i*)out, lo);
+    _mm_storeu_si128((__m128i*)(out + 16), hi);
+    return true;
+}
+
+VSP_TARGET_AVX2
+static bool decode_avx2(const char* s, const char* end, u8* out,
+                        size_t count) {
+    while (count > 32 && end - s > 96 && block_avx2(s, out)) {
+        s += 96;
+        out += 32;
+        count -= 32;
+    }
+
+    return decode_sse2(s, end, out, count);
+}
+
+#endif
+
+bool hex_decoder_supported(hex_decoder impl) {
+    switch (impl) {
+    case HEX_DECODER_AUTO:
+    case HEX_DECODER_SCALAR:
+        return true;
+    case HEX_DECODER_SSE2:
+        return simd_support() >= SIMD_SSE2;
+    case HEX_DECODER_AVX2:
+        return simd_support() >= SIMD_AVX2;
+
+    default:
+        return false;
+    }
+}
+
+static hex_decoder best_decoder() {
+    switch (simd_support()) {
+    case SIMD_AVX2:
+        return HEX_DECODER_AVX2;
+    case SIMD_SSE2:
+        return HEX_DECODER_SSE2;
+    default:
+        return HEX_DECODER_SCALAR;
+    }
+}
+
+bool decode_hex(string_view in, u8* out, size_t count, hex_decoder impl) {
+    const char* s = in.data();
+    const char* end = s + in.size();
+
+    if (impl == HEX_DECODER_AUTO) {
+        static const hex_decoder best = best_decoder();
+        impl = best;
+    } else {
+        MWR_REPORT_ON(!hex_decoder_supported(impl),
+                      "hex decoder %d not supported", (int)impl);
+    }
+
+    switch (impl) {
+#ifdef VSP_HAVE_AVX2
+    case HEX_DECODER_AVX2:
+        return decode_avx2(s, end, out, count);
+#endif
+
+#ifdef VSP_HAVE_SSE2
+    case HEX_DECODER_SSE2:
+        return decode_sse2(s, end, out, count);
+#endif
+
+    case HEX_DECODER_SCALAR:
+        return decode_scalar(s, end, out, count);
+
+    default:
+        MWR_ERROR("hex decoder %d not supported", (int)impl);
+        return false;
+    }
+}
+
+} // namespace vsp
@@ -0,0 +1,580 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/hierarchy.h"
+#include "vsp/checksum.h"
+
+namespace vsp {
+
+string_pool::string_pool():
+    m_blocks(), m_used(0), m_capacity(0), m_bytes(0), m_strings() {
+    // nothing to do
+}
+
+const char* string_pool::intern(string_view str) {
+    auto it = m_strings.find(str);
+    if (it != m_strings.end())
+        return it->second;
+
+    const char* dest = store(str);
+    m_strings.emplace(string_view(dest, str.size()), dest);
+    return dest;
+}
+
+const char* string_pool::store(string_view str) {
+    // large strings get a block of their own, so that the space left in
+    // the current block is not wasted
+    size_t size = str.size() + 1;
+    char* dest;
+    if (size > BLOCK_SIZE / 4) {
+        unique_ptr<char[]> block(new char[size]);
+        dest = block.get();
+        auto pos = m_capacity ? m_blocks.end() - 1 : m_blocks.end();
+        m_blocks.insert(pos, std::move(block));
+    } else {
+        if (m_used + size > m_capacity) {
+            m_blocks.emplace_back(new char[BLOCK_SIZE]);
+            m_used = 0;
+            m_capacity = BLOCK_SIZE;
+        }
+
+        dest = m_blocks.back().get() + m_used;
+        m_used += size;
+    }
+
+    memcpy(dest, str.data(), str.size());
+    dest[str.size()] = '\0';
+    m_bytes += size;
+    return dest;
+}
+
+void string_pool::clear() {
+    m_strings.clear();
+    m_blocks.clear();
+    m_used = 0;
+    m_capacity = 0;
+    m_bytes = 0;
+}
+
+hierarchy_index::hierarchy_index(): m_names(), m_mods(), m_attrs(), m_cmds() {
+    // nothing to do
+}
+
+size_t hierarchy_index::size() const {
+    return m_mods.size() + m_attrs.size() + m_cmds.size();
+}
+
+void hierarchy_index::reserve(size_t mods, size_t attrs, size_t cmds) {
+    m_mods.reserve(mods);
+    m_attrs.reserve(attrs);
+    m_cmds.reserve(cmds);
+}
+
+void hierarchy_index::build(module* root) {
+    clear();
+    if (root)
+        add(root);
+}
+
+size_t hierarchy_index::key_hash::operator()(const key& k) const {
+    u64 hash = fnv1a64((const u8*)k.prefix.data(), k.prefix.size());
+    return (size_t)fnv1a64((const u8*)k.name.data(), k.name.size(), hash);
+}
+
+bool hierarchy_index::key_equal::operator()(const key& a,
+                                            const key& b) const {
+    if (a.size() != b.size())
+        return false;
+
+    // compares runs in which neither key moves from prefix to name
+    auto rest = [](const key& k, size_t pos) {
+        return pos < k.prefix.size() ? k.prefix.substr(pos)
+                                     : k.name.substr(pos - k.prefix.size());
+    };
+
+    for (size_t pos = 0; pos < a.size();) {
+        string_view x = rest(a, pos);
+        string_view y = rest(b, pos);
+        size_t len = std::min(x.size(), y.size());
+        if (memcmp(x.data(), y.data(), len) != 0)
+            return false;
+        pos += len;
+    }
+
+    return true;
+}
+
+// Adds mod and everything listed below it so far. The index only looks
+// at the contents modules already have, so that building it never lists
+// anything from the simulation. Modules without contents store no path,
+// lazily listed ones store theirs once they get added.
+void hierarchy_index::add(module* mod) {
+    string path = mod->hierarchy_name();
+    size_t len = path.size();
+    string_view prefix;
+    if (len > 0) {
+        path += '.';
+        prefix = string_view(m_names.store(path), path.size());
+    }
+
+    // subtrees were added without their contents before
+    if (!find_module(prefix.substr(0, len)))
+        m_mods.emplace(key{ prefix.substr(0, len), {} }, mod);
+
+    // the first of several elements with the same name wins, as it did
+    // when searching the children of each module in order
+    function<void(module*, string_view)> walk = [&](module* m,
+                                                    string_view base) {
+        for (attribute* attr : m->m_attrs)
+            m_attrs.emplace(key{ base, attr->name() }, attr);
+        for (command* cmd : m->m_cmds)
+            m_cmds.emplace(key{ base, cmd->name() }, cmd);
+
+        for (module* child : m->m_mods) {
+            m_mods.emplace(key{ base, child->name() }, child);
+            if (child->m_mods.empty() && child->m_attrs.empty() &&
+                child->m_cmds.empty())
+                continue;
+
+            path.assign(base).append(child->name()).push_back('.');
+            walk(child, string_view(m_names.store(path), path.size()));
+        }
+    };
+
+    walk(mod, prefix);
+}
+
+void hierarchy_index::clear() {
+    m_mods.clear();
+    m_attrs.clear();
+    m_cmds.clear();
+    m_names.clear();
+}
+
+module* hierarchy_index::find_module(string_view name) const {
+    auto it = m_mods.find(key{ name, {} });
+    return it != m_mods.end() ? it->second : nullptr;
+}
+
+attribute* hierarchy_index::find_attribute(string_view name) const {
+    auto it = m_attrs.find(key{ name, {} });
+    return it != m_attrs.end() ? it->second : nullptr;
+}
+
+command* hierarchy_index::find_command(string_view name) const {
+    auto it = m_cmds.find(key{ name, {} });
+    return it != m_cmds.end() ? it->second : nullptr;
+}
+
+hierarchy::hierarchy(connection& conn):
+    m_conn(conn),
+    m_strings(),
+    m_segments(),
+    m_root(nullptr),
+    m_num_mods(0),
+    m_num_attrs(0),
+    m_num_cmds(0),
+    m_num_unloaded(0),
+    m_depth(0),
+    m_digest(0),
+    m_index(),
+    m_mtx(),
+    m_images(),
+    m_new_mods(),
+    m_new_attrs(),
+    m_new_cmds(),
+    m_stack() {
+    // nothing to do
+}
+
+vector<target_desc> hierarchy::fetch(module* mod) {
+    string cmd = "list,xml";
+    if (m_depth > 0) {
+        string name = mod ? mod->hierarchy_name() : "";
+        cmd += mkstr(",%s,%zu", mwr::escape(name, ",").c_str(), m_depth);
+    }
+
+    // full listings are hashed on the way, so they can be cached
+    bool full = !mod && m_depth == 0;
+    u64 digest = FNV1A64_INIT;
+
+    hierarchy_reader reader(*this, mod);
+    try {
+        m_conn.request_stream(cmd, [&](const char* data, size_t size) {
+            if (full)
+                digest = fnv1a64((const u8*)data, size, digest);
+            reader.feed(data, size);
+        });
+        reader.finish();
+    } catch (...) {
+        discard();
+        throw;
+    }
+
+    if (full)
+        m_digest = digest;
+
+    return reader.targets();
+}
+
+void hierarchy::discard() {
+    m_new_mods.clear();
+    m_new_attrs.clear();
+    m_new_cmds.clear();
+    m_stack.clear();
+}
+
+vector<target_desc> hierarchy::load(size_t depth) {
+    clear();
+    m_depth = depth;
+
+    try {
+        return fetch(nullptr);
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+vector<target_desc> hierarchy::load(string_view listing, u64 digest) {
+    clear();
+    m_depth = 0;
+
+    try {
+        hierarchy_reader reader(*this);
+        reader.feed(listing);
+        reader.finish();
+        m_digest = digest;
+        return reader.targets();
+    } catch (...) {
+        clear();
+        throw;
+    }
+}
+
+void hierarchy::expand(const module& mod) {
+    // the hierarchy owns all of its modules, it only hands out const
+    // references to those it still needs to fill in
+    module& target = const_cast<module&>(mod);
+
+    // another thread may have listed the module while this one waited
+    lock_guard lk(m_mtx);
+    if (!target.m_loader)
+        return;
+
+    MWR_ERROR_ON(target.m_loader != this, "module %s cannot be loaded",
+                 mod.hierarchy_name().c_str());
+
+    fetch(&target);
+
+    // the listing may have lacked the module, it then stays empty rather
+    // than being asked for over and over again
+    if (target.m_loader) {
+        target.m_loader = nullptr;
+        m_num_unloaded--;
+    }
+}
+
+module* hierarchy::find_module(string_view name) const {
+    if (!m_num_unloaded)
+        return m_index.find_module(name);
+
+    lock_guard lk(m_mtx);
+    return m_index.find_module(name);
+}
+
+attribute* hierarchy::find_attribute(string_view name) const {
+    if (!m_num_unloaded)
+        return m_index.find_attribute(name);
+
+    lock_guard lk(m_mtx);
+    return m_index.find_attribute(name);
+}
+
+command* hierarchy::find_command(string_view name) const {
+    if (!m_num_unloaded)
+        return m_index.find_command(name);
+
+    lock_guard lk(m_mtx);
+    return m_index.find_command(name);
+}
+
+void hierarchy::begin_module(string_view name, string_view kind,
+                             string_view version, bool complete) {
+    size_t parent = m_stack.empty() ? NO_PARENT : m_stack.back();
+    MWR_ERROR_ON(parent == NO_PARENT && (m_root || !m_new_mods.empty()),
+                 "hierarchy already has a root module");
+
+    m_new_mods.push_back({ m_strings.intern(name), m_strings.intern(kind),
+                           m_strings.intern(version), parent, complete,
+                           nullptr });
+    m_stack.push_back(m_new_mods.size() - 1);
+}
+
+void hierarchy::begin_subtree(module& mod) {
+    MWR_ERROR_ON(!m_new_mods.empty(), "subtree must be added first");
+    m_new_mods.push_back({ mod.m_name, mod.m_kind, mod.m_version, NO_PARENT,
+                           true, &mod });
+    m_stack.push_back(0);
+}
+
+void hierarchy::end_module() {
+    MWR_ERROR_ON(m_stack.empty(), "no module to end");
+    m_stack.pop_back();
+}
+
+void hierarchy::add_attribute(string_view name, string_view type,
+                              size_t count) {
+    MWR_ERROR_ON(m_stack.empty(), "attribute %.*s outside of any module",
+                 (int)name.size(), name.data());
+    m_new_attrs.push_back({ m_strings.intern(name), m_strings.intern(type),
+                            count, m_stack.back() });
+}
+
+void hierarchy::add_command(string_view name, size_t argc,
+                            string_view desc) {
+    MWR_ERROR_ON(m_stack.empty(), "command %.*s outside of any module",
+                 (int)name.size(), name.data());
+    m_new_cmds.push_back({ m_strings.intern(name), m_strings.intern(desc),
+                           argc, m_stack.back() });
+}
+
+// sorts pointers to elems by the module they belong to, keeping their
+// order within each module; the run of module i starts at offsets[i]
+template <typename T, typename INFO>
+unique_ptr<T*[]> hierarchy::group(T* elems, const vector<INFO>& infos,
+                                  size_t nparents, vector<size_t>& offsets) {
+    offsets.assign(nparents + 1, 0);
+    for (const INFO& info : infos) {
+        if (info.parent != NO_PARENT)
+            offsets[info.parent + 1]++;
+    }
+
+    for (size_t i = 0; i < nparents; i++)
+        offsets[i + 1] += offsets[i];
+
+    unique_ptr<T*[]> ptrs(new T*[offsets[nparents]]);
+    vector<size_t> next(offsets.begin(), offsets.end() - 1);
+    for (size_t i = 0; i < infos.size(); i++) {
+        if (infos[i].parent != NO_PARENT)
+            ptrs[next[infos[i].parent]++] = elems + i;
+    }
+
+    return ptrs;
+}
+
+void hierarchy::finish() {
+    MWR_ERROR_ON(!m_stack.empty(), "module %s not ended",
+                 m_new_mods[m_stack.back()].name);
+    if (m_new_mods.empty())
+        return;
+
+    const size_t nmods = m_new_mods.size();
+    const size_t nattrs = m_new_attrs.size();
+    const size_t ncmds = m_new_cmds.size();
+
+    segment seg;
+    seg.mods.reset(new module[nmods]);
+    seg.attrs.reset(new attribute[nattrs]);
+    seg.cmds.reset(new command[ncmds]);
+
+    // the contents of a subtree belong to the module it was listed for,
+    // which takes the place of the first module of this segment
+    module* subtree = m_new_mods[0].existing;
+    module* mods = seg.mods.get();
+    auto parent = [subtree, mods](size_t idx) {
+        return idx == 0 && subtree ? subtree : mods + idx;
+    };
+
+    for (size_t i = 0; i < nmods; i++) {
+        const module_info& info = m_new_mods[i];
+        mods[i].m_conn = &m_conn;
+        mods[i].m_name = info.name;
+        mods[i].m_kind = info.kind;
+        mods[i].m_version = info.version;
+        if (info.parent != NO_PARENT)
+            mods[i].m_parent = parent(info.parent);
+        if (!info.complete) {
+            mods[i].m_loader = this;
+            m_num_unloaded++;
+        }
+    }
+
+    for (size_t i = 0; i < nattrs; i++) {
+        const attribute_info& info = m_new_attrs[i];
+        attribute& attr = seg.attrs[i];
+        attr.m_conn = &m_conn;
+        attr.m_name = info.name;
+        attr.m_type = info.type;
+        attr.m_count = info.count;
+        attr.m_parent = parent(info.parent);
+    }
+
+    for (size_t i = 0; i < ncmds; i++) {
+        const command_info& info = m_new_cmds[i];
+        command& cmd = seg.cmds[i];
+        cmd.m_conn = &m_conn;
+        cmd.m_name = info.name;
+        cmd.m_desc = info.desc;
+        cmd.m_argc = info.argc;
+        cmd.m_parent = parent(info.parent);
+    }
+
+    vector<size_t> offsets;
+    seg.mod_ptrs = group(mods, m_new_mods, nmods, offsets);
+    for (size_t i = 0; i < nmods; i++) {
+        mods[i].m_mods = element_range<module>(seg.mod_ptrs.get() + offsets[i],
+                                               offsets[i + 1] - offsets[i]);
+    }
+
+    seg.attr_ptrs = group(seg.attrs.get(), m_new_attrs, nmods, offsets);
+    for (size_t i = 0; i < nmods; i++) {
+        mods[i].m_attrs = element_range<attribute>(
+            seg.attr_ptrs.get() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    seg.cmd_ptrs = group(seg.cmds.get(), m_new_cmds, nmods, offsets);
+    for (size_t i = 0; i < nmods; i++) {
+        mods[i].m_cmds = element_range<command>(
+            seg.cmd_ptrs.get() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    if (subtree) {
+        subtree->m_mods = mods[0].m_mods;
+        subtree->m_attrs = mods[0].m_attrs;
+        subtree->m_cmds = mods[0].m_cmds;
+    }
+
+    if (!m_root)
+        m_root = mods;
+
+    m_num_mods += subtree ? nmods - 1 : nmods;
+    m_num_attrs += nattrs;
+    m_num_cmds += ncmds;
+    m_segments.push_back(std::move(seg));
+
+    // the staging buffers can be as large as the hierarchy itself
+    vector<module_info>().swap(m_new_mods);
+    vector<attribute_info>().swap(m_new_attrs);
+    vector<command_info>().swap(m_new_cmds);
+
+    // the subtree only counts as loaded once it can be found, lookups
+    // that see no unloaded modules left do not lock
+    if (subtree) {
+        m_index.add(subtree);
+        if (subtree->m_loader) {
+            subtree->m_loader = nullptr;
+            m_num_unloaded--;
+        }
+    } else {
+        m_index.reserve(m_num_mods, m_num_attrs, m_num_cmds);
+        m_index.build(m_root);
+    }
+}
+
+void hierarchy::clear() {
+    m_index.clear();
+    m_root = nullptr;
+    m_segments.clear();
+    m_num_mods = 0;
+    m_num_attrs = 0;
+    m_num_cmds = 0;
+    m_num_unloaded = 0;
+    m_digest = 0;
+    discard();
+    m_strings.clear();
+    m_images.clear();
+}
+
+hierarchy_reader::hierarchy_reader(hierarchy& hier, module* subtree):
+    xml_reader(),
+    m_hier(hier),
+    m_subtree(subtree),
+    m_targets(),
+    m_kinds(),
+    m_has_root(false),
+    m_has_name(false) {
+    // nothing to do
+}
+
+// Only the first <hierarchy> element is looked at. Modules, attributes
+// and commands count where a module may hold them, targets only right
+// below the hierarchy, everything else is skipped with all its contents.
+void hierarchy_reader::begin_element(string_view name,
+                                     const xml_attrs& attrs) {
+    element_kind parent = m_kinds.empty() ? ELEM_IGNORED : m_kinds.back();
+    element_kind kind = ELEM_IGNORED;
+
+    bool complete = attrs.get("truncated") != "true";
+
+    if (m_kinds.empty() && name == "hierarchy" && !m_has_root) {
+        if (m_subtree) {
+            kind = ELEM_WRAPPER;
+        } else {
+            m_hier.begin_module(attrs.get("name"), attrs.get("kind"),
+                                attrs.get("version"), complete);
+            m_has_root = true;
+            kind = ELEM_ROOT;
+        }
+    } else if (parent == ELEM_WRAPPER && name == "object" && !m_has_root) {
+        m_hier.begin_subtree(*m_subtree);
+        m_has_root = true;
+        kind = ELEM_ROOT;
+    } else if (parent == ELEM_ROOT || parent == ELEM_MODULE) {
+        if (name == "object") {
+            m_hier.begin_module(attrs.get("name"), attrs.get("kind"),
+                                attrs.get("version"), complete);
+            kind = ELEM_MODULE;
+        } else if (name == "attribute") {
+            m_hier.add_attribute(attrs.get("name"), attrs.get("type"),
+                                 attrs.get_u64("count"));
+            kind = ELEM_LEAF;
+        } else if (name == "command") {
+            m_hier.add_command(attrs.get("name"), attrs.get_u64("argc"),
+                               attrs.get("desc"));
+            kind = ELEM_LEAF;
+        } else if (name == "target" && parent == ELEM_ROOT && !m_subtree) {
+            m_targets.push_back({ "", string(attrs.get("arch")),
+                                  string(attrs.get("group")) });
+            m_has_name = false;
+            kind = ELEM_TARGET;
+        }
+    }
+
+    m_kinds.push_back(kind);
+}
+
+void hierarchy_reader::end_element(string_view) {
+    element_kind kind = m_kinds.back();
+    m_kinds.pop_back();
+    if (kind == ELEM_ROOT || kind == ELEM_MODULE)
+        m_hier.end_module();
+}
+
+void hierarchy_reader::text(string_view text) {
+    // the name of a target is the first text inside of it
+    if (!m_kinds.empty() && m_kinds.back() == ELEM_TARGET && !m_has_name) {
+        m_targets.back().name = text;
+        m_has_name = true;
+    }
+}
+
+void hierarchy_reader::end_document() {
+    // listings without a hierarchy still get an empty root module
+    if (!m_has_root && !m_subtree) {
+        m_hier.begin_module("", "", "");
+        m_hier.end_module();
+    }
+
+    m_hier.finish();
+}
+
+} // namespace vsp
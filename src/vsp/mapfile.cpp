@@ -0,0 +1,142 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/mapfile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vsp {
+
+mapped_file::mapped_file(): m_data(nullptr), m_size(0), m_open(false) {
+    // nothing to do
+}
+
+mapped_file::mapped_file(const string& path): mapped_file() {
+    open(path);
+}
+
+mapped_file::mapped_file(mapped_file&& other) noexcept:
+    m_data(other.m_data), m_size(other.m_size), m_open(other.m_open) {
+    other.m_data = nullptr;
+    other.m_size = 0;
+    other.m_open = false;
+}
+
+mapped_file& mapped_file::operator=(mapped_file&& other) noexcept {
+    if (this != &other) {
+        close();
+        std::swap(m_data, other.m_data);
+        std::swap(m_size, other.m_size);
+        std::swap(m_open, other.m_open);
+    }
+
+    return *this;
+}
+
+mapped_file::~mapped_file() {
+    close();
+}
+
+#ifdef _WIN32
+
+void mapped_file::open(const string& path) {
+    close();
+
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                              nullptr);
+    MWR_REPORT_ON(file == INVALID_HANDLE_VALUE, "cannot open %s",
+                  path.c_str());
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        MWR_REPORT("cannot read size of %s", path.c_str());
+    }
+
+    // empty files cannot be mapped, but are perfectly fine to read
+    if (size.QuadPart > 0) {
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0,
+                                            0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)
+                             : nullptr;
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        MWR_REPORT_ON(!view, "cannot map %s", path.c_str());
+        m_data = (const u8*)view;
+    } else {
+        CloseHandle(file);
+    }
+
+    m_size = (size_t)size.QuadPart;
+    m_open = true;
+}
+
+void mapped_file::close() noexcept {
+    if (m_data)
+        UnmapViewOfFile(m_data);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#else
+
+void mapped_file::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    MWR_REPORT_ON(fd < 0, "cannot open %s: %s", path.c_str(),
+                  strerror(errno));
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        ::close(fd);
+        MWR_REPORT("cannot read size of %s", path.c_str());
+    }
+
+    // empty files cannot be mapped, but are perfectly fine to read
+    if (st.st_size > 0) {
+        void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        MWR_REPORT_ON(addr == MAP_FAILED, "cannot map %s: %s", path.c_str(),
+                      strerror(errno));
+        m_data = (const u8*)addr;
+    } else {
+        ::close(fd);
+    }
+
+    m_size = st.st_size;
+    m_open = true;
+}
+
+void mapped_file::close() noexcept {
+    if (m_data)
+        munmap((void*)m_data, m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_open = false;
+}
+
+#endif
+
+} // namespace vsp
@@ -12,60 +12,64 @@
 
 #include "vsp/attribute.h"
 #include "vsp/command.h"
+#include "vsp/hierarchy.h"
 
 namespace vsp {
 
-module::module(const string& name, connection& conn, module* parent,
-               const string& kind,
-               const string& version) :element(name, conn, parent),
-    m_kind(kind), m_version(version) {
+module::module():
+    element(),
+    m_kind(""),
+    m_version(""),
+    m_mods(),
+    m_attrs(),
+    m_cmds(),
+    m_loader(nullptr) {
 }
 
-module::~module() {
-    for (auto* mod : m_mods)
-        delete mod;
-    for (auto* attr : m_attrs)
-        delete attr;
-    for (auto* cmd : m_cmds)
-        delete cmd;
+void module::load() const {
+    hierarchy* loader = m_loader;
+    if (loader)
+        loader->expand(*this);
 }
 
 const char* module::kind() const {
-    return m_kind.c_str();
+    return m_kind;
 }
 
 const char* module::version() const {
-    return m_version.c_str();
+    return m_version;
 }
 
-module* module::find_module(const string& mod) {
-    if (mod == "")
+module* module::find_module(string_view mod) {
+    if (mod.empty())
         return this;
 
+    ensure_loaded();
     size_t dot_pos = mod.find('.');
-    string mod_name = dot_pos == string::npos ? mod : mod.substr(0, dot_pos);
-    auto it = find_if(m_mods.begin(), m_mods.end(),
-                      [&mod_name](const class module* m) -> bool {
-                          return strcmp(m->name(), mod_name.c_str()) == 0;
-                      });
+    string_view mod_name = mod.substr(0, dot_pos);
+    auto it = std::find_if(m_mods.begin(), m_mods.end(),
+                           [mod_name](const class module* m) -> bool {
+                               return m->name() == mod_name;
+                           });
 
     if (it == m_mods.end())
         return nullptr;
 
-    if (dot_pos == string::npos)
+    if (dot_pos == string_view::npos)
         return *it;
 
     return (*it)->find_module(mod.substr(dot_pos + 1));
 }
 
-attribute* module::find_attribute(const string& name) {
+attribute* module::find_attribute(string_view name) {
     size_t dot_pos = name.find_last_of('.');
 
-    if (dot_pos == string::npos) {
-        auto it = find_if(m_attrs.begin(), m_attrs.end(),
-                          [&name](const class attribute* a) -> bool {
-                              return strcmp(a->name(), name.c_str()) == 0;
-                          });
+    if (dot_pos == string_view::npos) {
+        ensure_loaded();
+        auto it = std::find_if(m_attrs.begin(), m_attrs.end(),
+                               [name](const class attribute* a) -> bool {
+                                   return a->name() == name;
+                               });
         if (it == m_attrs.end())
             return nullptr;
         return *it;
@@ -78,14 +82,15 @@ attribute* module::find_attribute(const string& name) {
     return module->find_attribute(name.substr(dot_pos + 1));
 }
 
-command* module::find_command(const string& name) {
+command* module::find_command(string_view name) {
     size_t dot_pos = name.find_last_of('.');
 
-    if (dot_pos == string::npos) {
-        auto it = find_if(m_cmds.begin(), m_cmds.end(),
-                          [&name](const command* c) -> bool {
-                              return strcmp(c->name(), name.c_str()) == 0;
-                          });
+    if (dot_pos == string_view::npos) {
+        ensure_loaded();
+        auto it = std::find_if(m_cmds.begin(), m_cmds.end(),
+                               [name](const command* c) -> bool {
+                                   return c->name() == name;
+                               });
         if (it == m_cmds.end())
             return nullptr;
         return *it;
@@ -98,30 +103,11 @@ command* module::find_command(const string& name) {
     return module->find_command(name.substr(dot_pos + 1));
 }
 
-void module::add_module(module* mod) {
-    m_mods.push_back(mod);
-}
-
-void module::add_attribute(attribute* attr) {
-    m_attrs.push_back(attr);
-}
-
-void module::add_attribute(const string& name, const string& type,
-                           size_t count) {
-    add_attribute(new attribute(name, m_conn, this, type, count));
-}
-
-void module::add_command(command* c) {
-    m_cmds.push_back(c);
-}
-
-void module::add_command(const string& name, size_t argc, const string& desc) {
-    add_command(new command(name, m_conn, this, argc, desc));
-}
-
 ostream& operator<<(ostream& os, const module& mod) {
     os << mod.hierarchy_name() << " (" << mod.kind() << ")" << endl;
 
+    mod.ensure_loaded();
+
     for (const auto* attr : mod.m_attrs)
         os << "  " << attr->name() << ": " << attr->type() << endl;
 
@@ -0,0 +1,84 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/packet.h"
+
+namespace vsp {
+
+void packet::put(char c) {
+    if (c == '$' || c == '#' || c == '*' || c == '}') {
+        m_data += '}';
+        m_checksum += static_cast<u8>('}');
+        c ^= 0x20;
+    }
+
+    m_data += c;
+    m_checksum += static_cast<u8>(c);
+}
+
+void packet::put(string_view s) {
+    for (char c : s)
+        put(c);
+}
+
+packet::packet(): m_data(), m_checksum() {
+    // nothing to do
+}
+
+void packet::clear() {
+    m_data.clear();
+    m_checksum = 0;
+}
+
+packet& packet::begin(string_view cmd) {
+    m_data += '$';
+    m_checksum = 0;
+    put(cmd);
+    return *this;
+}
+
+packet& packet::finish() {
+    static constexpr char HEX[] = "0123456789abcdef";
+    m_data += '#';
+    m_data += HEX[m_checksum >> 4];
+    m_data += HEX[m_checksum & 0xf];
+    return *this;
+}
+
+packet& packet::field(string_view s) {
+    put(',');
+    put(s);
+    return *this;
+}
+
+packet& packet::field(const binary_data& bin) {
+    put(',');
+    for (size_t i = 0; i < bin.size; i++) {
+        char c = (char)bin.data[i];
+        if (c == ',' || c == '\\')
+            put('\\');
+        put(c);
+    }
+
+    return *this;
+}
+
+packet& packet::field(const decimal_data& dec) {
+    for (size_t i = 0; i < dec.size; i++)
+        field(dec.data[i]);
+    return *this;
+}
+
+packet& packet::append(char c) {
+    m_data += c;
+    return *this;
+}
+
+} // namespace vsp
@@ -0,0 +1,210 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/profiler.h"
+#include "vsp/symbols.h"
+
+namespace vsp {
+
+static size_t slot_index(u64 key, size_t mask) {
+    u64 mix = key * 0x9e3779b97f4a7c15ull;
+    return (size_t)(mix ^ (mix >> 32)) & mask;
+}
+
+pc_histogram::pc_histogram(size_t capacity):
+    m_slots(), m_mask(), m_total(0), m_dropped(0) {
+    size_t size = 16;
+    while (size < capacity)
+        size *= 2;
+
+    m_slots.reset(new slot[size]);
+    m_mask = size - 1;
+    clear();
+}
+
+void pc_histogram::add(u64 pc, u64 n) {
+    m_total.fetch_add(n, std::memory_order_relaxed);
+
+    // all-ones cannot be told apart from a free slot and counts as dropped
+    u64 key = pc + 1;
+    if (key != 0) {
+        size_t idx = slot_index(key, m_mask);
+        for (size_t probe = 0; probe <= m_mask; probe++) {
+            slot& s = m_slots[idx];
+            u64 cur = s.key.load(std::memory_order_acquire);
+            if (cur == 0 && s.key.compare_exchange_strong(cur, key))
+                cur = key;
+
+            if (cur == key) {
+                s.count.fetch_add(n, std::memory_order_relaxed);
+                return;
+            }
+
+            idx = (idx + 1) & m_mask;
+        }
+    }
+
+    m_dropped.fetch_add(n, std::memory_order_relaxed);
+}
+
+u64 pc_histogram::count(u64 pc) const {
+    u64 key = pc + 1;
+    if (key == 0)
+        return 0;
+
+    size_t idx = slot_index(key, m_mask);
+    for (size_t probe = 0; probe <= m_mask; probe++) {
+        const slot& s = m_slots[idx];
+        u64 cur = s.key.load(std::memory_order_acquire);
+        if (cur == key)
+            return s.count.load(std::memory_order_relaxed);
+        if (cur == 0)
+            return 0;
+        idx = (idx + 1) & m_mask;
+    }
+
+    return 0;
+}
+
+void pc_histogram::clear() {
+    for (size_t i = 0; i <= m_mask; i++) {
+        m_slots[i].key = 0;
+        m_slots[i].count = 0;
+    }
+
+    m_total = 0;
+    m_dropped = 0;
+}
+
+vector<pair<u64, u64>> pc_histogram::entries() const {
+    vector<pair<u64, u64>> result;
+    for (size_t i = 0; i <= m_mask; i++) {
+        u64 key = m_slots[i].key.load(std::memory_order_acquire);
+        u64 n = m_slots[i].count.load(std::memory_order_relaxed);
+        if (key != 0 && n != 0)
+            result.emplace_back(key - 1, n);
+    }
+
+    std::sort(result.begin(), result.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+
+    return result;
+}
+
+profiler::profiler(session& sess, size_t capacity):
+    m_session(sess), m_targets(sess.targets()), m_hists(), m_cancel(false) {
+    for (size_t i = 0; i < m_targets.size(); i++)
+        m_hists.push_back(std::make_unique<pc_histogram>(capacity));
+}
+
+const pc_histogram* profiler::find_histogram(const target& t) const {
+    for (size_t i = 0; i < m_targets.size(); i++) {
+        if (m_targets[i] == &t)
+            return m_hists[i].get();
+    }
+
+    return nullptr;
+}
+
+void profiler::sample() {
+    for (size_t i = 0; i < m_targets.size(); i++)
+        m_hists[i]->add(m_targets[i]->get_pc());
+}
+
+size_t profiler::run(profile_clock clock, u64 interval, size_t samples) {
+    m_cancel = false;
+
+    size_t n = 0;
+    while (n < samples && !m_cancel) {
+        bool stopped_by_us = true;
+
+        switch (clock) {
+        case PROFILE_WALL_CLOCK:
+            m_session.run();
+            std::this_thread::sleep_for(std::chrono::microseconds(interval));
+            stopped_by_us = m_session.check_running();
+            if (stopped_by_us) {
+                m_session.stop();
+                m_session.wait_until_stopped();
+            }
+            break;
+
+        case PROFILE_SIM_TIME:
+            m_session.step(interval, true);
+            stopped_by_us = m_session.reason().reason ==
+                            VSP_STOP_REASON_STEP_COMPLETE;
+            break;
+
+        default:
+            MWR_ERROR("invalid profile clock: %d", (int)clock);
+        }
+
+        sample();
+        n++;
+
+        // breakpoints and watchpoints end profiling with their state intact
+        if (!stopped_by_us)
+            break;
+    }
+
+    return n;
+}
+
+void profiler::clear() {
+    for (auto& hist : m_hists)
+        hist->clear();
+}
+
+string profiler::symbol(const symbolizer& sym, size_t i, u64 pc) const {
+    string name;
+    if (sym)
+        name = sym(*m_targets[i], pc);
+    else if (const symbol_index* syms = m_targets[i]->symbols())
+        name = syms->describe(pc);
+
+    if (!name.empty())
+        return name;
+
+    return mkstr("0x%llx", (unsigned long long)pc);
+}
+
+void profiler::export_flat(ostream& os, const symbolizer& sym) const {
+    for (size_t i = 0; i < m_targets.size(); i++) {
+        const pc_histogram& hist = *m_hists[i];
+        u64 total = hist.total();
+
+        os << "target " << m_targets[i]->name() << ": " << total
+           << " samples";
+        if (hist.dropped())
+            os << ", " << hist.dropped() << " dropped";
+        os << "\n";
+
+        os << mkstr("%10s %8s  %s\n", "samples", "share", "location");
+        for (const auto& [pc, n] : hist.entries()) {
+            double share = total ? 100.0 * n / total : 0.0;
+            os << mkstr("%10llu %7.2f%%  %s\n", (unsigned long long)n, share,
+                        symbol(sym, i, pc).c_str());
+        }
+
+        os << "\n";
+    }
+}
+
+void profiler::export_collapsed(ostream& os, const symbolizer& sym) const {
+    for (size_t i = 0; i < m_targets.size(); i++) {
+        for (const auto& [pc, n] : m_hists[i]->entries()) {
+            os << m_targets[i]->name() << ";" << symbol(sym, i, pc) << " "
+               << n << "\n";
+        }
+    }
+}
+
+} // namespace vsp
@@ -0,0 +1,107 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/response.h"
+
+namespace vsp {
+
+response::response(): m_buffer(), m_fields() {
+    // nothing to do
+}
+
+response::response(string&& packet, size_t max_fields): response() {
+    assign(std::move(packet), max_fields);
+}
+
+void response::assign(string&& packet, size_t max_fields) {
+    m_buffer = std::move(packet);
+    tokenize(max_fields);
+}
+
+string response::release() {
+    m_fields.clear();
+    return std::move(m_buffer);
+}
+
+// Splits the buffer at unescaped commas. Escaped characters are resolved
+// in place, which can only ever shrink a field, so fields without any
+// backslashes are never touched. Once max_fields is reached, the last
+// field holds the remainder of the packet verbatim.
+void response::tokenize(size_t max_fields) {
+    MWR_REPORT_ON(m_buffer.size() > UINT32_MAX, "response too large");
+
+    m_fields.clear();
+
+    char* s = m_buffer.data();
+    const size_t n = m_buffer.size();
+    size_t begin = 0;
+    size_t w = 0;
+
+    for (size_t r = 0; r < n && max_fields > 1; ++r) {
+        char c = s[r];
+        if (c == '\\' && r < n - 1) {
+            c = s[++r];
+        } else if (c == ',') {
+            m_fields.push_back({ (u32)begin, (u32)(w - begin) });
+            begin = w = r + 1;
+            if (m_fields.size() + 1 == max_fields)
+                break;
+            continue;
+        }
+
+        if (w != r)
+            s[w] = c;
+        w++;
+    }
+
+    if (m_fields.size() + 1 == max_fields)
+        w = n;
+
+    m_fields.push_back({ (u32)begin, (u32)(w - begin) });
+}
+
+string_view response::at(size_t i) const {
+    MWR_REPORT_ON(i >= m_fields.size(), "response field %zu out of range", i);
+    return operator[](i);
+}
+
+u64 response::to_u64(size_t i, int base) const {
+    string_view s = at(i);
+    if (base == 16 && s.size() > 2 && s[0] == '0' && (s[1] | 0x20) == 'x')
+        s.remove_prefix(2);
+
+    u64 val = 0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), val, base);
+    MWR_REPORT_ON(res.ec != std::errc() || s.empty(),
+                  "malformed number in response field %zu", i);
+    return val;
+}
+
+bool response::ok() const {
+    return !empty() && operator[](0) == "OK";
+}
+
+string_view response::error() const {
+    if (ok())
+        return "";
+    if (size() > 1)
+        return operator[](1);
+    return "unknown error";
+}
+
+vector<string> response::to_vector() const {
+    vector<string> result;
+    result.reserve(size());
+    for (size_t i = 0; i < size(); ++i)
+        result.emplace_back(operator[](i));
+    return result;
+}
+
+} // namespace vsp
@@ -0,0 +1,233 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/search.h"
+#include "vsp/simd.h"
+
+namespace vsp {
+
+static inline unsigned lowest_bit(u32 bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return (unsigned)__builtin_ctz(bits);
+#else
+    unsigned n = 0;
+    for (; !(bits & 1); bits >>= 1)
+        n++;
+    return n;
+#endif
+}
+
+// checks positions [begin, end) one by one, also finishes the positions
+// left over by the vector kernels
+static void find_scalar(const byte_pattern& pat, u8 first, u8 first_mask,
+                        size_t first_off, const u8* data, size_t begin,
+                        size_t end, u64 base, vector<u64>& out) {
+    if (first_mask != 0xff) {
+        for (size_t i = begin; i < end; i++) {
+            if ((data[i + first_off] & first_mask) == first &&
+                pat.matches(data + i))
+                out.push_back(base + i);
+        }
+
+        return;
+    }
+
+    const u8* p = data + first_off;
+    for (size_t i = begin; i < end; i++) {
+        const void* hit = memchr(p + i, first, end - i);
+        if (!hit)
+            return;
+
+        i = (const u8*)hit - p;
+        if (pat.matches(data + i))
+            out.push_back(base + i);
+    }
+}
+
+#ifdef VSP_HAVE_SSE2
+
+static size_t find_sse2(const byte_pattern& pat, const u8* data, size_t count,
+                        size_t first_off, u8 first, u8 first_mask,
+                        size_t last_off, u8 last, u8 last_mask, u64 base,
+                        vector<u64>& out) {
+    const __m128i fv = _mm_set1_epi8((char)first);
+    const __m128i fm = _mm_set1_epi8((char)first_mask);
+    const __m128i lv = _mm_set1_epi8((char)last);
+    const __m128i lm = _mm_set1_epi8((char)last_mask);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i*)(data + i + first_off));
+        __m128i b = _mm_loadu_si128((const __m128i*)(data + i + last_off));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(a, fm), fv),
+                                   _mm_cmpeq_epi8(_mm_and_si128(b, lm), lv));
+
+        u32 bits = (u32)_mm_movemask_epi8(eq);
+        for (; bits; bits &= bits - 1) {
+            size_t pos = i + lowest_bit(bits);
+            if (pat.matches(data + pos))
+                out.push_back(base + pos);
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+#ifdef VSP_HAVE_AVX2
+
+VSP_TARGET_AVX2
+static size_t find_avx2(const byte_pattern& pat, const u8* data, size_t count,
+                        size_t first_off, u8 first, u8 first_mask,
+                        size_t last_off, u8 last, u8 last_mask, u64 base,
+                        vector<u64>& out) {
+    const __m256i fv = _mm256_set1_epi8((char)first);
+    const __m256i fm = _mm256_set1_epi8((char)first_mask);
+    const __m256i lv = _mm256_set1_epi8((char)last);
+    const __m256i lm = _mm256_set1_epi8((char)last_mask);
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(data + i + first_off));
+        __m256i b = _mm256_loadu_si256((const __m256i*)(data + i + last_off));
+        __m256i eq = _mm256_and_si256(
+            _mm256_cmpeq_epi8(_mm256_and_si256(a, fm), fv),
+            _mm256_cmpeq_epi8(_mm256_and_si256(b, lm), lv));
+
+        u32 bits = (u32)_mm256_movemask_epi8(eq);
+        for (; bits; bits &= bits - 1) {
+            size_t pos = i + lowest_bit(bits);
+            if (pat.matches(data + pos))
+                out.push_back(base + pos);
+        }
+    }
+
+    return i;
+}
+
+#endif
+
+bool pattern_matcher_supported(pattern_matcher impl) {
+    switch (impl) {
+    case PATTERN_MATCHER_AUTO:
+    case PATTERN_MATCHER_SCALAR:
+        return true;
+    case PATTERN_MATCHER_SSE2:
+        return simd_support() >= SIMD_SSE2;
+    case PATTERN_MATCHER_AVX2:
+        return simd_support() >= SIMD_AVX2;
+
+    default:
+        return false;
+    }
+}
+
+static pattern_matcher best_matcher() {
+    switch (simd_support()) {
+    case SIMD_AVX2:
+        return PATTERN_MATCHER_AVX2;
+    case SIMD_SSE2:
+        return PATTERN_MATCHER_SSE2;
+    default:
+        return PATTERN_MATCHER_SCALAR;
+    }
+}
+
+byte_pattern::byte_pattern(const vector<u8>& bytes, const vector<u8>& mask,
+                           pattern_matcher impl):
+    m_bytes(bytes),
+    m_mask(mask),
+    m_masked(false),
+    m_first(0),
+    m_last(0),
+    m_impl(impl) {
+    MWR_REPORT_ON(m_bytes.empty(), "empty search pattern");
+    MWR_REPORT_ON(!m_mask.empty() && m_mask.size() != m_bytes.size(),
+                  "search mask does not match pattern size");
+    MWR_REPORT_ON(!pattern_matcher_supported(impl),
+                  "pattern matcher %d not supported", (int)impl);
+
+    if (m_impl == PATTERN_MATCHER_AUTO) {
+        static const pattern_matcher best = best_matcher();
+        m_impl = best;
+    }
+
+    if (m_mask.empty())
+        m_mask.assign(m_bytes.size(), 0xff);
+
+    for (size_t i = 0; i < m_bytes.size(); i++) {
+        m_bytes[i] &= m_mask[i];
+        m_masked |= m_mask[i] != 0xff;
+    }
+
+    // anchor on the outermost bytes that are compared at all, a pattern
+    // of wildcards only matches everywhere through its first byte
+    m_first = m_bytes.size() - 1;
+    m_last = 0;
+    for (size_t i = 0; i < m_bytes.size(); i++) {
+        if (m_mask[i]) {
+            m_first = std::min(m_first, i);
+            m_last = std::max(m_last, i);
+        }
+    }
+
+    if (m_first > m_last)
+        m_first = m_last = 0;
+}
+
+bool byte_pattern::matches(const u8* data) const {
+    if (!m_masked)
+        return memcmp(data, m_bytes.data(), m_bytes.size()) == 0;
+
+    for (size_t i = 0; i < m_bytes.size(); i++) {
+        if ((data[i] & m_mask[i]) != m_bytes[i])
+            return false;
+    }
+
+    return true;
+}
+
+void byte_pattern::find(const u8* data, size_t size, u64 base,
+                        vector<u64>& out) const {
+    if (size < m_bytes.size())
+        return;
+
+    // number of positions a match can start at
+    const size_t count = size - m_bytes.size() + 1;
+    const u8 first = m_bytes[m_first];
+    const u8 first_mask = m_mask[m_first];
+
+    size_t done = 0;
+    switch (m_impl) {
+#ifdef VSP_HAVE_AVX2
+    case PATTERN_MATCHER_AVX2:
+        done = find_avx2(*this, data, count, m_first, first, first_mask,
+                         m_last, m_bytes[m_last], m_mask[m_last], base, out);
+        break;
+#endif
+
+#ifdef VSP_HAVE_SSE2
+    case PATTERN_MATCHER_SSE2:
+        done = find_sse2(*this, data, count, m_first, first, first_mask,
+                         m_last, m_bytes[m_last], m_mask[m_last], base, out);
+        break;
+#endif
+
+    default:
+        break;
+    }
+
+    find_scalar(*this, first, first_mask, m_first, data, done, count, base,
+                out);
+}
+
+} // namespace vsp
@@ -10,16 +10,15 @@
 
 #include "vsp/session.h"
 
+#include "vsp/checksum.h"
 #include "vsp/connection.h"
 #include "vsp/module.h"
 
-#include <pugixml.hpp>
-
 namespace vsp {
 
 // converts a string of bytes to a vector of bytes
 // "ddccbbaa" -> { aa, bb, cc, dd }
-static void strhex(u8* buffer, size_t buflen, const string& bytes) {
+static void strhex(u8* buffer, size_t buflen, string_view bytes) {
     if (!buffer)
         return;
 
@@ -39,7 +38,7 @@ static void strhex(u8* buffer, size_t buflen, const string& bytes) {
 
     while (src_idx != 0) {
         src_idx -= chars_per_byte;
-        string chunk = bytes.substr(src_idx, chars_per_byte);
+        string chunk(bytes.substr(src_idx, chars_per_byte));
         buffer[dst_idx++] = (u8)stoi(chunk, 0, 16);
     }
 }
@@ -54,11 +53,16 @@ static const unordered_map<std::string_view, vsp_stop_reason> VSP_STOP_REASONS{
     { "<unknown>", VSP_STOP_REASON_UNKNOWN },
 };
 
-static vsp_stop_reason stop_reason_from_string(const string& s) {
-    if (!VSP_STOP_REASONS.count(s))
-        return VSP_STOP_REASON_UNKNOWN;
+static vsp_stop_reason stop_reason_from_string(string_view s) {
+    auto it = VSP_STOP_REASONS.find(s);
+    return it != VSP_STOP_REASONS.end() ? it->second : VSP_STOP_REASON_UNKNOWN;
+}
 
-    return VSP_STOP_REASONS.at(s);
+static u64 parse_u64(string_view s, int base) {
+    u64 val = 0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), val, base);
+    MWR_REPORT_ON(res.ec != std::errc() || s.empty(), "malformed number");
+    return val;
 }
 
 string_view stop_reason_str(const stop_reason& reason) {
@@ -82,14 +86,36 @@ session::session():
     m_conn(),
     m_sysc_version(),
     m_vcml_version(),
-    m_protover(VSP_UNKNOWN),
     m_running(),
     m_reason(),
     m_time_ns(),
     m_cycle(),
-    m_mods(),
+    m_hier(m_conn),
     m_targets(),
-    m_target_groups() {
+    m_target_groups(),
+    m_lazy(false),
+    m_load_mtx(),
+    m_load_cv(),
+    m_loader(),
+    m_loading(false),
+    m_load_error(),
+    m_cache_dir(),
+    m_list_digest(),
+    m_resp(),
+    m_event_mtx(),
+    m_event_cv(),
+    m_poller(),
+    m_poller_exit(false),
+    m_poller_kick(false),
+    m_policy(),
+    m_waiters(0),
+    m_poll_seq(0),
+    m_event_seq(0),
+    m_event_running(),
+    m_event_reason(),
+    m_event_error(),
+    m_event_time_ns(),
+    m_event_cycle() {
 }
 
 session::session(const string& host, u16 port): session() {
@@ -105,20 +131,121 @@ session::~session() {
     m_targets.clear();
 }
 
+void session::poll_events() {
+    response resp;
+    size_t round = 0;
+    u64 sleep_us = 0;
+
+    unique_lock lk(m_event_mtx);
+    while (!m_poller_exit) {
+        if (m_waiters == 0) {
+            m_event_cv.wait(lk, [this]() {
+                return m_poller_exit || m_waiters > 0;
+            });
+            continue;
+        }
+
+        if (m_poller_kick)
+            round = 0;
+
+        u64 seq = ++m_poll_seq;
+        m_poller_kick = false;
+        lk.unlock();
+
+        bool running = false;
+        string reason, error;
+        u64 time_ns = 0, cycle = 0;
+
+        try {
+            m_conn.request(resp, response::ALL_FIELDS, "status");
+            MWR_REPORT_ON(resp.size() < 4, "malformed status response");
+            running = resp[1] == "running";
+            if (!running)
+                reason = resp[1].substr(std::min<size_t>(8, resp[1].size()));
+            time_ns = resp.to_u64(2);
+            cycle = resp.to_u64(3);
+        } catch (std::exception& ex) {
+            error = ex.what();
+        }
+
+        lk.lock();
+
+        // a disconnect may have published a newer event meanwhile
+        if (seq > m_event_seq) {
+            // the simulation kept going after the last run or step, so
+            // anything read while it was running may be stale
+            if (m_event_running && !running && error.empty())
+                m_conn.advance_epoch();
+
+            m_event_seq = seq;
+            m_event_running = running;
+            m_event_reason = std::move(reason);
+            m_event_error = std::move(error);
+            m_event_time_ns = time_ns;
+            m_event_cycle = cycle;
+            m_event_cv.notify_all();
+        }
+
+        const wait_policy& policy = m_policy;
+        if (!running) {
+            round = 0;
+            sleep_us = policy.sleep_min_us;
+        } else if (++round <= policy.spin_polls) {
+            continue;
+        } else if (round <= policy.spin_polls + policy.yield_polls) {
+            lk.unlock();
+            mwr::cpu_yield();
+            lk.lock();
+            continue;
+        } else if (round == policy.spin_polls + policy.yield_polls + 1) {
+            sleep_us = policy.sleep_min_us;
+        } else {
+            sleep_us = std::min(sleep_us * 2, policy.sleep_max_us);
+        }
+
+        m_event_cv.wait_for(lk, std::chrono::microseconds(sleep_us), [this]() {
+            return m_poller_exit || m_poller_kick;
+        });
+    }
+}
+
+void session::stop_poller() noexcept {
+    {
+        lock_guard lk(m_event_mtx);
+        m_poller_exit = true;
+        m_event_seq = ++m_poll_seq;
+        m_event_error = "session disconnected";
+    }
+
+    m_event_cv.notify_all();
+    if (m_poller.joinable())
+        m_poller.join();
+
+    lock_guard lk(m_event_mtx);
+    m_poller_exit = false;
+}
+
 void session::update_version() {
-    auto resp = m_conn.command("version");
+    m_conn.request(m_resp, response::ALL_FIELDS, "version");
+    update_version(m_resp);
+}
+
+void session::update_version(const response& resp) {
     MWR_REPORT_ON(resp.size() < 3, "malformed version response");
 
     m_sysc_version = resp[1];
     m_vcml_version = resp[2];
 
     if (resp.size() > 3)
-        m_protover = stoi(resp[3]);
+        m_conn.set_proto_version((int)resp.to_u64(3));
 }
 
 void session::update_status() {
-    auto resp = m_conn.command("status");
+    m_conn.request(m_resp, response::ALL_FIELDS, "status");
+    update_status(m_resp);
+}
 
+void session::update_status(const response& resp) {
     if (!is_connected()) {
         m_running = false;
         return;
@@ -128,26 +255,34 @@ void session::update_status() {
 
     if (resp[1] == "running") {
         m_running = true;
+        m_conn.advance_epoch();
     } else {
         m_running = false;
-        update_reason(resp[1].substr(8));
+        update_reason(resp[1].substr(std::min<size_t>(8, resp[1].size())));
     }
 
-    m_time_ns = stoull(resp[2]);
-    m_cycle = stoull(resp[3]);
+    m_time_ns = resp.to_u64(2);
+    m_cycle = resp.to_u64(3);
 }
 
-void session::update_reason(const string& reason) {
+void session::update_reason(string_view reason) {
     if (reason.empty())
         return;
 
-    auto args = split(reason, ':');
+    // stop reasons have at most five colon separated arguments, anything
+    // longer ends up with six and is reported as unknown
+    string_view args[6];
+    size_t nargs = 0;
+    while (nargs < 6) {
+        size_t pos = reason.find(':');
+        args[nargs++] = reason.substr(0, pos);
+        if (pos == string_view::npos)
+            break;
+        reason.remove_prefix(pos + 1);
+    }
 
     stop_reason newreason;
-    if (args.size() < 1)
-        newreason.reason = VSP_STOP_REASON_UNKNOWN;
-    else
-        newreason.reason = stop_reason_from_string(args[0]);
+    newreason.reason = stop_reason_from_string(args[0]);
 
     switch (newreason.reason) {
     case VSP_STOP_REASON_STEP_COMPLETE:
@@ -157,50 +292,56 @@ void session::update_reason(const string& reason) {
     }
 
     case VSP_STOP_REASON_BREAKPOINT: {
-        if (args.size() != 3) {
+        if (nargs != 3) {
             newreason.reason = VSP_STOP_REASON_UNKNOWN;
             break;
         }
 
-        newreason.breakpoint.id = stoull(args[1], 0, 10);
-        newreason.breakpoint.time = stoull(args[2], 0, 10);
+        newreason.breakpoint.id = parse_u64(args[1], 10);
+        newreason.breakpoint.time = parse_u64(args[2], 10);
         break;
     }
 
     case VSP_STOP_REASON_TARGET_STEP_COMPLETE: {
-        if (args.size() != 3) {
+        if (nargs != 3) {
             newreason.reason = VSP_STOP_REASON_UNKNOWN;
             break;
         }
 
-        newreason.target_step_complete.tgt = find_target(args[1]);
-        newreason.target_step_complete.time = stoull(args[2], 0, 10);
+        newreason.target_step_complete.tgt = nullptr;
+        wait_for_modules();
+        for (target* t : m_targets) {
+            if (args[1] == t->name())
+                newreason.target_step_complete.tgt = t;
+        }
+
+        newreason.target_step_complete.time = parse_u64(args[2], 10);
         break;
     }
 
     case VSP_STOP_REASON_RWATCHPOINT: {
-        if (args.size() != 5) {
+        if (nargs != 5) {
             newreason.reason = VSP_STOP_REASON_UNKNOWN;
             break;
         }
 
-        newreason.rwatchpoint.id = stoull(args[1], 0, 10);
-        newreason.rwatchpoint.addr = stoull(args[2], 0, 16);
-        newreason.rwatchpoint.size = stoull(args[3], 0, 10);
-        newreason.rwatchpoint.time = stoull(args[4], 0, 10);
+        newreason.rwatchpoint.id = parse_u64(args[1], 10);
+        newreason.rwatchpoint.addr = parse_u64(args[2], 16);
+        newreason.rwatchpoint.size = parse_u64(args[3], 10);
+        newreason.rwatchpoint.time = parse_u64(args[4], 10);
         break;
     }
 
     case VSP_STOP_REASON_WWATCHPOINT: {
-        if (args.size() != 5) {
+        if (nargs != 5) {
             newreason.reason = VSP_STOP_REASON_UNKNOWN;
             break;
         }
 
-        newreason.wwatchpoint.id = stoull(args[1], 0, 10);
-        newreason.wwatchpoint.addr = stoull(args[2], 0, 16);
+        newreason.wwatchpoint.id = parse_u64(args[1], 10);
+        newreason.wwatchpoint.addr = parse_u64(args[2], 16);
 
-        const string& data = args[3];
+        string_view data = args[3];
         const size_t hex_chars_per_byte = 2;
         if (hex_chars_per_byte * data.length() > stop_reason::DATA_SIZE) {
             log_error("wwatchpoint: written %lu bytes (>%lu), data dropped",
@@ -208,7 +349,7 @@ void session::update_reason(const string& reason) {
         }
 
         strhex(newreason.wwatchpoint.data, stop_reason::DATA_SIZE, data);
-        newreason.wwatchpoint.time = stoull(args[4], 0, 10);
+        newreason.wwatchpoint.time = parse_u64(args[4], 10);
         break;
     }
 
@@ -221,55 +362,120 @@ void session::update_reason(const string& reason) {
     m_reason = newreason;
 }
 
-static module* xml_parse_modules(connection& conn, const pugi::xml_node& node,
-                                 module* parent) {
-    module* mod = new module(node.attribute("name").value(), conn, parent,
-                             node.attribute("kind").value(),
-                             node.attribute("version").value());
+void session::update_modules() {
+    bool lazy = m_lazy && m_conn.has_capability(VSP_CAP_SUBTREE_LIST);
+    vector<target_desc> targets = m_hier.load(lazy ? LAZY_DEPTH : 0);
+    create_targets(targets);
 
-    for (auto& child : node.children("object")) {
-        mod->add_module(xml_parse_modules(conn, child, mod));
-    }
+    if (!lazy && !m_cache_dir.empty())
+        store_cached_modules(targets);
+}
 
-    for (auto& target : node.children("attribute")) {
-        mod->add_attribute(target.attribute("name").value(),
-                           target.attribute("type").value(),
-                           target.attribute("count").as_ullong());
+void session::create_targets(const vector<target_desc>& targets) {
+    for (const target_desc& t : targets) {
+        string gname = t.group.empty() ? t.name : t.group;
+        auto& group = m_target_groups[gname];
+        group.name = gname;
+        m_targets.push_back(new target(m_conn, *this, t.name, t.arch, group));
     }
+}
+
+string session::cache_key() const {
+    return hierarchy_cache::key(m_sysc_version, m_vcml_version,
+                                m_conn.proto_version());
+}
+
+bool session::load_cached_modules() {
+    m_list_digest.reset();
+    if (m_cache_dir.empty())
+        return false;
+
+    hierarchy_cache cache(m_cache_dir);
+    string key = cache_key();
+    u64 digest = FNV1A64_INIT;
+
+    if (m_conn.has_capability(VSP_CAP_LIST_DIGEST)) {
+        // servers that know the digest of their listing spare the transfer
+        response resp = m_conn.request("list,digest");
+        string_view str = resp.at(1);
+        digest = fnv1a64((const u8*)str.data(), str.size(), digest);
+        m_list_digest = digest;
+    } else {
+        // otherwise the listing has to be received to tell whether it
+        // changed, but it only gets hashed on the way; the text is kept
+        // so that a stale image does not cost a second transfer
+        if (!cache.contains(key))
+            return false;
+
+        string listing;
+        m_conn.request_stream("list,xml", [&](const char* data, size_t size) {
+            digest = fnv1a64((const u8*)data, size, digest);
+            listing.append(data, size);
+        });
+
+        vector<target_desc> targets;
+        if (!cache.load(key, digest, m_hier, targets)) {
+            targets = m_hier.load(listing, digest);
+            store_cached_modules(targets);
+        }
 
-    for (auto& cmd : node.children("command")) {
-        mod->add_command(cmd.attribute("name").value(),
-                         cmd.attribute("argc").as_ullong(),
-                         cmd.attribute("desc").value());
+        create_targets(targets);
+        return true;
     }
 
-    return mod;
+    vector<target_desc> targets;
+    if (!cache.load(key, digest, m_hier, targets))
+        return false;
+
+    create_targets(targets);
+    return true;
 }
 
-void session::update_modules() {
-    auto resp = m_conn.command("list,xml");
-    MWR_REPORT_ON(resp.size() < 2, "malformed 'list' response");
+void session::store_cached_modules(
+    const vector<target_desc>& targets) noexcept {
+    try {
+        hierarchy_cache cache(m_cache_dir);
+        u64 digest = m_list_digest.value_or(m_hier.digest());
+        cache.store(cache_key(), digest, m_hier, targets);
+    } catch (std::exception& ex) {
+        log_warn("cannot cache modules: %s", ex.what());
+    }
+}
 
-    pugi::xml_document list;
-    if (!list.load_string(resp[1].c_str()))
-        MWR_REPORT("invalid module xml");
+void session::start_loader() {
+    m_loading = true;
+    m_load_error = nullptr;
+    m_loader = thread([this]() {
+        std::exception_ptr error;
+        try {
+            update_modules();
+        } catch (...) {
+            error = std::current_exception();
+        }
 
-    pugi::xml_node hierachy = list.child("hierarchy");
+        lock_guard lk(m_load_mtx);
+        m_load_error = error;
+        m_loading = false;
+        m_load_cv.notify_all();
+    });
+}
 
-    if (m_mods != nullptr)
-        delete m_mods;
-    m_mods = xml_parse_modules(m_conn, hierachy, nullptr);
+void session::stop_loader() noexcept {
+    if (m_loader.joinable())
+        m_loader.join();
 
-    for (auto& t : hierachy.children("target")) {
-        string name = t.text().as_string();
-        string arch = t.attribute("arch").value();
-        string gname = t.attribute("group").value();
-        if (gname.empty())
-            gname = name;
-        auto& group = m_target_groups[gname];
-        group.name = gname;
-        m_targets.push_back(new target(m_conn, name, arch, group));
-    }
+    lock_guard lk(m_load_mtx);
+    m_loading = false;
+    m_load_error = nullptr;
+}
+
+// everything that touches the modules or targets waits for the loader
+// thread, which reports its errors to every one of them
+void session::wait_for_modules() const {
+    unique_lock lk(m_load_mtx);
+    m_load_cv.wait(lk, [this]() { return !m_loading; });
+    if (m_load_error)
+        std::rethrow_exception(m_load_error);
 }
 
 const char* session::sysc_version() const {
@@ -281,7 +487,7 @@ const char* session::vcml_version() const {
 }
 
 int session::proto_version() const {
-    return m_protover;
+    return m_conn.proto_version();
 }
 
 u64 session::get_time_ns() {
@@ -317,25 +523,48 @@ void session::connect(const string& host, u16 port) {
         if (!is_connected())
             return;
 
-        update_version();
-        update_status();
+        // servers that do not know caps answer with an error, they
+        // support no protocol extensions
+        static const char* const CMDS[] = { "version", "status", "caps" };
+        response resps[3];
+        m_conn.pipeline(
+            3, [](size_t i, packet& pkt) { pkt.begin(CMDS[i]); },
+            [&resps](size_t i, response& resp) {
+                MWR_REPORT_ON(i < 2 && !resp.ok(), "%s",
+                              string(resp.error()).c_str());
+                resps[i] = std::move(resp);
+            });
+
+        update_version(resps[0]);
+        update_status(resps[1]);
+        if (resps[2].ok())
+            m_conn.set_capabilities(parse_capabilities(resps[2]));
+
+        if (m_running) {
+            m_conn.command("stop");
+            wait_until_stopped();
+        }
 
-        stop();
-        while (check_running())
-            mwr::cpu_yield();
+        if (load_cached_modules())
+            return;
 
-        update_modules();
+        if (m_lazy && !m_conn.has_capability(VSP_CAP_SUBTREE_LIST))
+            start_loader();
+        else
+            update_modules();
     } catch (std::exception& ex) {
         MWR_REPORT("error connecting: %s", ex.what());
     }
 }
 
 void session::disconnect() noexcept {
+    // the poller and the loader may be waiting for a simulation that does
+    // not respond, they only return once the connection is gone
     m_conn.disconnect();
+    stop_poller();
+    stop_loader();
 
-    if (m_mods != nullptr)
-        delete m_mods;
-    m_mods = nullptr;
+    m_hier.clear();
 }
 
 bool session::is_connected() const {
@@ -357,30 +586,30 @@ void session::step(bool block) {
 }
 
 void session::step(u64 ns, bool block) {
+    m_conn.advance_epoch();
     update_status();
     if (!m_running) {
         m_running = true;
         m_conn.command("resume," + to_string(ns) + "ns");
     }
 
-    if (block) {
-        while (m_running)
-            update_status();
-    }
+    if (block)
+        wait_until_stopped();
 }
 
 void session::stepi(const target& t) {
+    m_conn.advance_epoch();
     update_status();
     if (!m_running) {
         m_running = true;
-        m_conn.command("step," + string(t.name()));
+        m_conn.request(m_resp, response::ALL_FIELDS, "step", t.name());
     }
 
-    while (m_running)
-        update_status();
+    wait_until_stopped();
 }
 
 void session::run() {
+    m_conn.advance_epoch();
     update_status();
     if (!m_running) {
         m_running = true;
@@ -399,6 +628,76 @@ void session::stop() {
         m_conn.command("stop");
 }
 
+wait_result session::wait_until_stopped(
+    std::chrono::steady_clock::time_point deadline,
+    const wait_policy& policy) {
+    if (!is_connected()) {
+        m_running = false;
+        return { true, 0 };
+    }
+
+    unique_lock lk(m_event_mtx);
+    if (!m_poller.joinable())
+        m_poller = thread(&session::poll_events, this);
+
+    // concurrent waiters share the poller, which then follows the most
+    // eager of their policies
+    if (m_waiters++ == 0) {
+        m_policy = policy;
+    } else {
+        m_policy.spin_polls = std::max(m_policy.spin_polls, policy.spin_polls);
+        m_policy.yield_polls = std::max(m_policy.yield_polls,
+                                        policy.yield_polls);
+        m_policy.sleep_min_us = std::min(m_policy.sleep_min_us,
+                                         policy.sleep_min_us);
+        m_policy.sleep_max_us = std::min(m_policy.sleep_max_us,
+                                         policy.sleep_max_us);
+    }
+
+    m_poller_kick = true;
+    m_event_cv.notify_all();
+
+    // only accept results from polls issued after we started waiting, an
+    // older one may still report the state before the last resume
+    u64 seq = m_poll_seq;
+    auto stopped = [this, seq]() {
+        return m_event_seq > seq &&
+               (!m_event_running || !m_event_error.empty());
+    };
+
+    // the first poll is always awaited, so even a past deadline reports
+    // whether the simulation is running right now
+    m_event_cv.wait(lk, [this, seq]() { return m_event_seq > seq; });
+
+    bool done = true;
+    if (deadline == std::chrono::steady_clock::time_point::max())
+        m_event_cv.wait(lk, stopped);
+    else
+        done = m_event_cv.wait_until(lk, deadline, stopped);
+
+    m_waiters--;
+
+    wait_result result{ done, (size_t)(m_event_seq - seq) };
+    if (!done)
+        return result;
+
+    MWR_REPORT_ON(!m_event_error.empty(), "%s", m_event_error.c_str());
+
+    m_running = false;
+    m_time_ns = m_event_time_ns;
+    m_cycle = m_event_cycle;
+    update_reason(m_event_reason);
+    return result;
+}
+
+bool session::wait_for_stop(u64 timeout_ms) {
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (timeout_ms != WAIT_FOREVER)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::milliseconds(timeout_ms);
+    return wait_until_stopped(deadline).stopped;
+}
+
 void session::set_stop_mode(vsp_stop_mode mode) {
     switch (mode) {
     case VSP_STOP_MODE_SOFT:
@@ -413,32 +712,40 @@ void session::set_stop_mode(vsp_stop_mode mode) {
 }
 
 void session::dump(ostream& os) {
-    if (m_mods)
-        os << *m_mods;
+    wait_for_modules();
+    if (m_hier.root())
+        os << *m_hier.root();
 }
 
-module* session::find_module(const string& name) {
-    if (!m_mods)
-        return nullptr;
-
-    return m_mods->find_module(name);
+// names the index does not know may still be part of a module that has
+// not been listed yet, looking them up from the root lists the modules
+// along their path
+module* session::find_module(string_view name) const {
+    wait_for_modules();
+    module* mod = m_hier.find_module(name);
+    if (mod || !m_hier.num_unloaded())
+        return mod;
+    return m_hier.root()->find_module(name);
 }
 
-attribute* session::find_attribute(const string& name) {
-    if (!m_mods)
-        return nullptr;
-
-    return m_mods->find_attribute(name);
+attribute* session::find_attribute(string_view name) const {
+    wait_for_modules();
+    attribute* attr = m_hier.find_attribute(name);
+    if (attr || !m_hier.num_unloaded())
+        return attr;
+    return m_hier.root()->find_attribute(name);
 }
 
-command* session::find_command(const string& name) {
-    if (!m_mods)
-        return nullptr;
-
-    return m_mods->find_command(name);
+command* session::find_command(string_view name) const {
+    wait_for_modules();
+    command* cmd = m_hier.find_command(name);
+    if (cmd || !m_hier.num_unloaded())
+        return cmd;
+    return m_hier.root()->find_command(name);
 }
 
 target* session::find_target(const string& name) {
+    wait_for_modules();
     for (auto& t : m_targets) {
         if (strcmp(t->name(), name.c_str()) == 0)
             return t;
@@ -447,13 +754,23 @@ target* session::find_target(const string& name) {
     return nullptr;
 }
 
-const vector<module*>& session::modules() const {
-    if (!m_mods) {
-        static vector<module*> empty;
-        return empty;
-    }
+const vector<target*>& session::targets() const {
+    wait_for_modules();
+    return m_targets;
+}
+
+const hierarchy& session::modules_hierarchy() const {
+    wait_for_modules();
+    return m_hier;
+}
+
+const element_range<module>& session::modules() const {
+    static const element_range<module> none;
+    wait_for_modules();
+    if (!m_hier.root())
+        return none;
 
-    return m_mods->children();
+    return m_hier.root()->children();
 }
 
 vector<session_info> session::local_sessions() {
@@ -483,10 +800,12 @@ vector<session_info> session::local_sessions() {
 }
 
 const unordered_map<string, target_group>& session::target_groups() const {
+    wait_for_modules();
     return m_target_groups;
 }
 
 const target_group* session::find_target_group(const string& name) const {
+    wait_for_modules();
     auto it = m_target_groups.find(name);
     return it != m_target_groups.end() ? &it->second : nullptr;
 }
@@ -0,0 +1,36 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/simd.h"
+
+namespace vsp {
+
+static simd_level detect_simd() {
+#if defined(VSP_HAVE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+#elif defined(VSP_HAVE_AVX2)
+    return SIMD_AVX2;
+#endif
+
+#ifdef VSP_HAVE_SSE2
+    return SIMD_SSE2;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+simd_level simd_support() {
+    static const simd_level level = detect_simd();
+    return level;
+}
+
+} // namespace vsp
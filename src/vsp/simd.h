@@ -0,0 +1,46 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#ifndef VSP_SIMD_H
+#define VSP_SIMD_H
+
+#include "vsp/common.h"
+
+// Internal to the library: which vector code paths get compiled in. AVX2
+// code is built for every x86 target and only runs on cpus that have it.
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__)
+#define VSP_HAVE_SSE2
+#include <immintrin.h>
+#endif
+
+#if defined(VSP_HAVE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define VSP_HAVE_AVX2
+#define VSP_TARGET_AVX2 __attribute__((target("avx2")))
+#elif defined(VSP_HAVE_SSE2) && defined(__AVX2__)
+#define VSP_HAVE_AVX2
+#define VSP_TARGET_AVX2
+#endif
+
+namespace vsp {
+
+enum simd_level {
+    SIMD_SCALAR = 0,
+    SIMD_SSE2,
+    SIMD_AVX2,
+};
+
+// the widest vector code paths that are compiled in and that the cpu
+// running this process supports, detected once on first use
+simd_level simd_support();
+
+} // namespace vsp
+
+#endif
@@ -0,0 +1,178 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/symbols.h"
+
+namespace vsp {
+
+static constexpr u8 STT_NOTYPE = 0;
+static constexpr u8 STT_OBJECT = 1;
+static constexpr u8 STT_FUNC = 2;
+static constexpr u8 STB_LOCAL = 0;
+static constexpr u64 SHN_UNDEF = 0;
+static constexpr u64 SHN_ABS = 0xfff1;
+
+// how far lookups walk back past zero-sized labels to find an enclosing
+// function, labels are rare enough that this is never exhausted in practice
+static constexpr size_t MAX_LOOKBACK = 64;
+
+symbol_index::symbol_index(const string& path):
+    m_elf(path),
+    m_addrs(),
+    m_sizes(),
+    m_names(),
+    m_name_once(),
+    m_by_name() {
+    load();
+}
+
+void symbol_index::load() {
+    const elf_section* symtab = m_elf.find_section(elf_file::SECTION_SYMTAB);
+    if (!symtab)
+        symtab = m_elf.find_section(elf_file::SECTION_DYNSYM);
+    if (!symtab)
+        return;
+
+    MWR_REPORT_ON(symtab->link >= m_elf.sections().size(),
+                  "invalid symbol string table");
+    const elf_section& strtab = m_elf.sections()[symtab->link];
+    MWR_REPORT_ON(strtab.offset > m_elf.size() ||
+                      strtab.size > m_elf.size() - strtab.offset,
+                  "symbol string table exceeds file");
+    const char* strs = (const char*)m_elf.data() + strtab.offset;
+    MWR_REPORT_ON(symtab->offset > m_elf.size() ||
+                      symtab->size > m_elf.size() - symtab->offset,
+                  "symbol table exceeds file");
+
+    struct entry {
+        u64 addr;
+        u64 size;
+        string_view name;
+        u32 rank;
+    };
+
+    const bool is64 = m_elf.is_64bit();
+    const u64 entsize = is64 ? 24 : 16;
+    const u64 count = symtab->size / entsize;
+    const bool thumb = m_elf.machine() == elf_file::MACHINE_ARM;
+
+    vector<entry> entries;
+    entries.reserve(count);
+
+    // entry zero is reserved
+    for (u64 i = 1; i < count; i++) {
+        u64 off = symtab->offset + i * entsize;
+        u64 name = m_elf.read(off, 4);
+        u64 value, size, info, shndx;
+        if (is64) {
+            info = m_elf.read(off + 4, 1);
+            shndx = m_elf.read(off + 6, 2);
+            value = m_elf.read(off + 8, 8);
+            size = m_elf.read(off + 16, 8);
+        } else {
+            value = m_elf.read(off + 4, 4);
+            size = m_elf.read(off + 8, 4);
+            info = m_elf.read(off + 12, 1);
+            shndx = m_elf.read(off + 14, 2);
+        }
+
+        u8 type = info & 0xf;
+        u8 bind = info >> 4;
+        if (type != STT_NOTYPE && type != STT_OBJECT && type != STT_FUNC)
+            continue;
+        if (shndx == SHN_UNDEF || shndx == SHN_ABS || name == 0 ||
+            name >= strtab.size)
+            continue;
+
+        string_view str(strs + name, strnlen(strs + name, strtab.size - name));
+
+        // arm mapping symbols such as $a, $t and $d mark code and data
+        if (str.empty() || str[0] == '$')
+            continue;
+
+        if (thumb && type == STT_FUNC)
+            value &= ~1ull;
+
+        // of several symbols at the same address, lookups report the one
+        // with the highest rank, which ends up last after sorting
+        u32 rank = size ? 8 : 0;
+        if (type == STT_FUNC)
+            rank += 4;
+        else if (type == STT_OBJECT)
+            rank += 2;
+        if (bind != STB_LOCAL)
+            rank++;
+
+        entries.push_back({ value, size, str, rank });
+    }
+
+    std::sort(entries.begin(), entries.end(),
+              [](const entry& a, const entry& b) {
+                  return a.addr != b.addr ? a.addr < b.addr : a.rank < b.rank;
+              });
+
+    m_addrs.reserve(entries.size());
+    m_sizes.reserve(entries.size());
+    m_names.reserve(entries.size());
+    for (const entry& e : entries) {
+        m_addrs.push_back(e.addr);
+        m_sizes.push_back(e.size);
+        m_names.push_back(e.name);
+    }
+}
+
+void symbol_index::index_names() const {
+    m_by_name.resize(m_names.size());
+    for (size_t i = 0; i < m_by_name.size(); i++)
+        m_by_name[i] = (u32)i;
+
+    std::stable_sort(m_by_name.begin(), m_by_name.end(),
+                     [this](u32 a, u32 b) { return m_names[a] < m_names[b]; });
+}
+
+optional<symbol> symbol_index::lookup(u64 addr) const {
+    auto it = std::upper_bound(m_addrs.begin(), m_addrs.end(), addr);
+    size_t idx = it - m_addrs.begin();
+
+    for (size_t n = 0; idx > 0 && n < MAX_LOOKBACK; n++) {
+        idx--;
+        u64 base = m_addrs[idx];
+        u64 size = m_sizes[idx];
+        if (addr == base || addr - base < size)
+            return at(idx);
+    }
+
+    return nullopt;
+}
+
+string symbol_index::describe(u64 addr) const {
+    optional<symbol> sym = lookup(addr);
+    if (!sym)
+        return "";
+
+    string name(sym->name);
+    if (addr != sym->addr)
+        name += mkstr("+0x%llx", (unsigned long long)(addr - sym->addr));
+    return name;
+}
+
+optional<symbol> symbol_index::find(string_view name) const {
+    std::call_once(m_name_once, [this]() { index_names(); });
+
+    auto it = std::lower_bound(
+        m_by_name.begin(), m_by_name.end(), name,
+        [this](u32 idx, string_view s) { return m_names[idx] < s; });
+    if (it == m_by_name.end() || m_names[*it] != name)
+        return nullopt;
+
+    return at(*it);
+}
+
+} // namespace vsp
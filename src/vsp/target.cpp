@@ -9,10 +9,16 @@
  ******************************************************************************/
 
 #include "vsp/target.h"
+#include "vsp/checksum.h"
+#include "vsp/elf.h"
+#include "vsp/hexdec.h"
+#include "vsp/search.h"
+#include "vsp/session.h"
+#include "vsp/symbols.h"
 
 namespace vsp {
 
-static string wp_type_str(watchpoint_type type) {
+static const char* wp_type_str(watchpoint_type type) {
     switch (type) {
     case WP_READ:
         return "r";
@@ -24,6 +30,15 @@ static string wp_type_str(watchpoint_type type) {
     }
 }
 
+const u8* reg_snapshot::find(const string& name) const {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (name == names[i])
+            return value(i);
+    }
+
+    return nullptr;
+}
+
 target* target_group::find_target(const string& name) const {
     for (auto* target : targets) {
         if (name == target->name())
@@ -33,9 +48,31 @@ target* target_group::find_target(const string& name) const {
     return nullptr;
 }
 
-target::target(connection& conn, const string& name, const string& arch,
-               target_group& group):
-    m_conn(conn), m_name(name), m_arch(arch), m_group(group), m_regs() {
+target::target(connection& conn, session& sess, const string& name,
+               const string& arch, target_group& group):
+    m_conn(conn),
+    m_session(sess),
+    m_name(name),
+    m_arch(arch),
+    m_group(group),
+    m_regs(),
+    m_chunk_size(DEFAULT_CHUNK_SIZE),
+    m_depth(connection::PIPELINE_DEPTH),
+    m_page_size(0),
+    m_cache_epoch(conn.epoch()),
+    m_cache_hits(0),
+    m_cache_misses(0),
+    m_ppages(),
+    m_vpages(),
+    m_tlb_page_size(0),
+    m_tlb_epoch(conn.epoch()),
+    m_tlb_hits(0),
+    m_tlb_misses(0),
+    m_tlb(),
+    m_snapshot(),
+    m_snapshot_epoch(conn.epoch() - 1),
+    m_symbols(),
+    m_resp() {
     update_regs();
 
     if (m_arch.empty())
@@ -55,6 +92,10 @@ target::~target() {
 
 void target::update_regs() {
     auto resp = m_conn.command("lreg," + m_name);
+
+    vector<string> names;
+    vector<size_t> sizes;
+    vector<string> queries;
     for (size_t i = 1; i < resp.size(); ++i) {
         size_t regsize = 0;
         const string& regname = resp[i];
@@ -62,161 +103,883 @@ void target::update_regs() {
         if (colon_pos != string::npos)
             regsize = stoi(regname.substr(colon_pos + 1));
 
-        auto reg = new cpureg(m_conn, regname.substr(0, colon_pos), *this,
-                              regsize);
+        names.push_back(regname.substr(0, colon_pos));
+        sizes.push_back(regsize);
+        if (regsize == 0)
+            queries.push_back("getr," + m_name + "," + names.back());
+    }
+
+    // older servers do not report register sizes, so fetch them all at once
+    auto values = m_conn.command_batch(queries);
+    for (size_t i = 0, j = 0; i < names.size(); ++i) {
+        if (sizes[i] == 0)
+            sizes[i] = values[j++].size() - 1;
+
+        auto reg = new cpureg(m_conn, names[i], *this, sizes[i]);
         m_regs.push_back(reg);
     }
 }
 
-void target::fetch_arch() {
-    auto resp = m_conn.command("version");
-    int protover = resp.size() > 3 ? stoi(resp[3]) : 0;
+// all requests go out before the first response is read
+void target::fetch_regs(const vector<cpureg*>& regs,
+                        const vector<size_t>& offsets, u8* out) {
+    m_conn.pipeline(
+        regs.size(),
+        [&](size_t i, packet& pkt) {
+            pkt.begin("getr").field(m_name).field(regs[i]->name());
+        },
+        [&](size_t i, response& resp) {
+            if (!resp.ok())
+                MWR_REPORT("%s", string(resp.error()).c_str());
 
-    if (protover < 2) {
-        resp = m_conn.command(mkstr("geta,%s.arch", m_name.c_str()));
+            string_view data = resp.size() > 1 ? resp[1] : "";
+            if (!decode_hex(data, out + offsets[i],
+                            offsets[i + 1] - offsets[i]))
+                MWR_REPORT("getr: malformed response");
+        },
+        std::max<size_t>(regs.size(), 1), 2);
+}
+
+void target::fetch_arch() {
+    if (proto_version() < VSP_V2) {
+        auto resp = m_conn.command(mkstr("geta,%s.arch", m_name.c_str()));
         MWR_REPORT_ON(resp.size() != 2, "%s: malformed response", __func__);
         m_arch = resp[1];
         return;
     }
 
-    resp = m_conn.command("arch," + m_name);
+    auto resp = m_conn.command("arch," + m_name);
     MWR_REPORT_ON(resp.size() < 2, "malfomed arch response");
     m_arch = resp[1];
 }
 
+int target::proto_version() {
+    if (m_conn.proto_version() == VSP_UNKNOWN) {
+        auto resp = m_conn.command("version");
+        m_conn.set_proto_version(resp.size() > 3 ? stoi(resp[3]) : VSP_V1);
+    }
+
+    return m_conn.proto_version();
+}
+
+// servers with VSP_CAP_BINARY_MEMORY transfer memory contents as one field
+// of raw bytes, which only need the usual escaping of commas, backslashes
+// and framing characters, otherwise each byte is a hex or decimal field
+size_t target::fetch_mem(const char* cmd, u64 addr, u8* buf, size_t size,
+                         string* err) {
+    const bool binary = m_conn.has_capability(VSP_CAP_BINARY_MEMORY);
+    const string name = binary ? "b" + string(cmd) : string(cmd);
+    const size_t chunk = m_chunk_size;
+    const size_t count = (size + chunk - 1) / chunk;
+    size_t failed = count;
+
+    m_conn.pipeline(
+        count,
+        [&](size_t i, packet& pkt) {
+            size_t len = std::min(chunk, size - i * chunk);
+            pkt.begin(name).field(m_name).field(addr + i * chunk).field(len);
+        },
+        [&](size_t i, response& resp) {
+            if (!resp.ok()) {
+                if (err && failed == count)
+                    *err = resp.error();
+                failed = std::min(failed, i);
+                return;
+            }
+
+            u8* dest = buf + i * chunk;
+            size_t len = std::min(chunk, size - i * chunk);
+            string_view data = resp.size() > 1 ? resp[1] : "";
+            if (binary && data.size() == len)
+                memcpy(dest, data.data(), len);
+            else if (binary || !decode_hex(data, dest, len))
+                MWR_REPORT("%s: malformed response", cmd);
+        },
+        m_depth, binary ? response::ALL_FIELDS : 2);
+
+    return failed < count ? failed * chunk : size;
+}
+
+// pages that cannot be read as a whole, e.g. because they straddle the end
+// of a memory region, are not cached and read directly instead
+size_t target::read_cached(const char* cmd,
+                           unordered_map<u64, vector<u8>>& pages, u64 addr,
+                           u8* buf, size_t size, string* err) {
+    if (m_cache_epoch != m_conn.epoch())
+        flush_cache();
+
+    const u64 mask = ~(u64)(m_page_size - 1);
+    const u64 last = (addr + size - 1) & mask;
+    u64 fresh_lo = 1, fresh_hi = 0;
+
+    size_t done = 0;
+    while (done < size) {
+        u64 cur = addr + done;
+        u64 page = cur & mask;
+        size_t off = cur - page;
+        size_t len = std::min<size_t>(m_page_size - off, size - done);
+
+        auto it = pages.find(page);
+        if (it == pages.end()) {
+            if (pages.size() >= MAX_CACHED_PAGES)
+                pages.clear();
+
+            // fetch this and all directly following missing pages at once
+            u64 end = page;
+            while (end != last && !pages.count(end + m_page_size))
+                end += m_page_size;
+
+            size_t n = (end - page) / m_page_size + 1;
+            vector<u8> tmp(n * m_page_size);
+            size_t full = fetch_mem(cmd, page, tmp.data(), tmp.size(), err) /
+                          m_page_size;
+            if (full == 0)
+                return done + fetch_mem(cmd, cur, buf + done, size - done, err);
+
+            for (size_t i = 0; i < full; i++) {
+                auto first = tmp.begin() + i * m_page_size;
+                pages[page + i * m_page_size].assign(first,
+                                                     first + m_page_size);
+            }
+
+            fresh_lo = page;
+            fresh_hi = page + (full - 1) * m_page_size;
+            m_cache_misses += full;
+            it = pages.find(page);
+        } else if (page < fresh_lo || page > fresh_hi) {
+            m_cache_hits++;
+        }
+
+        memcpy(buf + done, it->second.data() + off, len);
+        done += len;
+    }
+
+    return size;
+}
+
+size_t target::read_mem(const char* cmd, u64 addr, u8* buf, size_t size,
+                        string* err) {
+    if (!cache_enabled() || size == 0)
+        return fetch_mem(cmd, addr, buf, size, err);
+
+    auto& pages = cmd[0] == 'p' ? m_ppages : m_vpages;
+    return read_cached(cmd, pages, addr, buf, size, err);
+}
+
+size_t target::write_mem(const char* cmd, u64 addr, const u8* data,
+                         size_t size, string* err) {
+    const bool binary = m_conn.has_capability(VSP_CAP_BINARY_MEMORY);
+    const string name = binary ? "b" + string(cmd) : string(cmd);
+    const size_t chunk = m_chunk_size;
+    const size_t count = (size + chunk - 1) / chunk;
+    size_t failed = count;
+    size_t partial = 0;
+
+    // memory may be aliased, e.g. physical and virtual or between targets
+    m_conn.advance_epoch();
+
+    m_conn.pipeline(
+        count,
+        [&](size_t i, packet& pkt) {
+            const u8* src = data + i * chunk;
+            size_t len = std::min(chunk, size - i * chunk);
+
+            pkt.begin(name).field(m_name).field(addr + i * chunk);
+            if (binary)
+                pkt.field(binary_data{ src, len });
+            else
+                pkt.field(decimal_data{ src, len });
+        },
+        [&](size_t i, response& resp) {
+            if (i > failed)
+                return;
+
+            if (!resp.ok()) {
+                if (err)
+                    *err = resp.error();
+                failed = i;
+                return;
+            }
+
+            size_t len = std::min(chunk, size - i * chunk);
+            size_t written = 0;
+
+            auto parts = split(string(resp.at(1)), ' ');
+            if (parts.size() == 3)
+                written = stoull(parts[0], nullptr, 10);
+
+            if (written < len) {
+                failed = i;
+                partial = written;
+            }
+        },
+        m_depth);
+
+    return failed < count ? failed * chunk + partial : size;
+}
+
+static bool is_zero(const u8* data, size_t size) {
+    for (; size >= 8; data += 8, size -= 8) {
+        u64 word;
+        memcpy(&word, data, sizeof(word));
+        if (word)
+            return false;
+    }
+
+    for (; size > 0; data++, size--) {
+        if (*data)
+            return false;
+    }
+
+    return true;
+}
+
+// hands chunks to sink in order as their responses arrive, so only one
+// chunk is ever held in memory; binary responses are passed on right from
+// the receive buffer
+size_t target::stream_mem(const char* cmd, u64 addr, size_t size,
+                          const mem_sink& sink, string* err) {
+    const bool binary = m_conn.has_capability(VSP_CAP_BINARY_MEMORY);
+    const string name = binary ? "b" + string(cmd) : string(cmd);
+    const size_t chunk = m_chunk_size;
+    const size_t count = (size + chunk - 1) / chunk;
+    size_t failed = count;
+    vector<u8> buf(binary ? 0 : std::min(chunk, size));
+
+    m_conn.pipeline(
+        count,
+        [&](size_t i, packet& pkt) {
+            size_t len = std::min(chunk, size - i * chunk);
+            pkt.begin(name).field(m_name).field(addr + i * chunk).field(len);
+        },
+        [&](size_t i, response& resp) {
+            if (i > failed)
+                return;
+
+            if (!resp.ok()) {
+                if (err)
+                    *err = resp.error();
+                failed = i;
+                return;
+            }
+
+            size_t len = std::min(chunk, size - i * chunk);
+            string_view data = resp.size() > 1 ? resp[1] : "";
+            const u8* src = (const u8*)data.data();
+            if (!binary) {
+                if (!decode_hex(data, buf.data(), len))
+                    MWR_REPORT("%s: malformed response", cmd);
+                src = buf.data();
+            } else if (data.size() != len) {
+                MWR_REPORT("%s: malformed response", cmd);
+            }
+
+            sink(i * chunk, src, len);
+        },
+        m_depth, binary ? response::ALL_FIELDS : 2);
+
+    return failed < count ? failed * chunk : size;
+}
+
+size_t target::dump_mem(const char* cmd, u64 addr, size_t size, ostream& os,
+                        bool sparse) {
+    const std::streamoff start = os.tellp();
+
+    // offsets within the dump, pos is where the stream currently is
+    size_t pos = 0;
+    size_t written = 0;
+
+    auto emit = [&](size_t off, const u8* data, size_t len) {
+        if (pos != off)
+            os.seekp(start + (std::streamoff)off);
+        os.write((const char*)data, len);
+        pos = written = off + len;
+    };
+
+    size_t done = stream_mem(
+        cmd, addr, size, [&](size_t off, const u8* data, size_t len) {
+            if (!sparse) {
+                emit(off, data, len);
+                return;
+            }
+
+            // zero pages are aligned to the start of the dump
+            for (size_t end = off + len; off < end;) {
+                size_t run = std::min<size_t>(
+                    DEFAULT_PAGE_SIZE - off % DEFAULT_PAGE_SIZE, end - off);
+                if (!is_zero(data, run))
+                    emit(off, data, run);
+                data += run;
+                off += run;
+            }
+        });
+
+    // the dump must end up at its full length even if it ends in zeros
+    if (sparse && written < done) {
+        static const u8 zero = 0;
+        emit(done - 1, &zero, 1);
+    }
+
+    MWR_REPORT_ON(!os, "%s: failed to write dump", cmd);
+    return done;
+}
+
+size_t target::dump_mem(const char* cmd, u64 addr, size_t size,
+                        const string& path, bool sparse) {
+    ofstream os(path, std::ios::binary | std::ios::trunc);
+    MWR_REPORT_ON(!os, "cannot open %s", path.c_str());
+    return dump_mem(cmd, addr, size, os, sparse);
+}
+
+// Keeps the last pattern size - 1 bytes seen in carry. Matches that start
+// in there are found by searching carry together with the head of the
+// next chunk, which also makes sure every match is reported only once.
+vector<u64> target::search_mem(const char* cmd, u64 addr, size_t size,
+                               const byte_pattern& pattern) {
+    const size_t overlap = pattern.size() - 1;
+    vector<u8> carry;
+    vector<u64> matches;
+
+    string err;
+    size_t done = stream_mem(
+        cmd, addr, size, [&](size_t off, const u8* data, size_t len) {
+            size_t head = std::min(overlap, len);
+            if (!carry.empty()) {
+                u64 base = addr + off - carry.size();
+                carry.insert(carry.end(), data, data + head);
+                pattern.find(carry.data(), carry.size(), base, matches);
+            }
+
+            if (len > overlap) {
+                pattern.find(data, len, addr + off, matches);
+                carry.assign(data + len - overlap, data + len);
+            } else if (carry.size() > overlap) {
+                carry.erase(carry.begin(), carry.end() - overlap);
+            } else if (carry.empty()) {
+                carry.assign(data, data + len);
+            }
+        },
+        &err);
+
+    MWR_REPORT_ON(done < size, "%s", err.c_str());
+    return matches;
+}
+
 void target::step() {
+    m_conn.advance_epoch();
     try {
-        auto resp = m_conn.command("step," + m_name);
+        m_conn.request(m_resp, response::ALL_FIELDS, "step", m_name);
     } catch (std::exception& ex) {
         string err = ex.what();
         MWR_REPORT_ON(err != "simulation running", "step failed");
     }
 }
 
-void target::step(size_t steps) {
-    constexpr unsigned long long max_sleep = 1'000ull << 6;
-    unsigned long long sleep = 1'000ull;
-
-    for (size_t i = 0; i < steps; i++) {
-        string err;
-        do {
-            err = "";
+const stop_reason& target::step(size_t steps) {
+    m_conn.advance_epoch();
+    if (steps == 0)
+        return m_session.reason();
 
+    // servers without counted steps run each single step asynchronously
+    // and reject further steps until it has finished, so those go out one
+    // at a time; steps rejected because the simulation was already
+    // running are sent again once it has stopped
+    const bool counted = m_conn.has_capability(VSP_CAP_COUNTED_STEP);
+    for (size_t done = 0; done < steps; done += counted ? steps : 1) {
+        while (true) {
             try {
-                auto resp = m_conn.command("step," + m_name);
+                if (counted)
+                    m_conn.request(m_resp, response::ALL_FIELDS, "step",
+                                   m_name, steps);
+                else
+                    m_conn.request(m_resp, response::ALL_FIELDS, "step",
+                                   m_name);
+                break;
             } catch (std::exception& ex) {
-                err = ex.what();
-                MWR_REPORT_ON(err != "simulation running", "step failed");
-                mwr::usleep(sleep);
-                sleep *= sleep >= max_sleep ? 1 : 2;
+                MWR_REPORT_ON(strcmp(ex.what(), "simulation running") != 0,
+                              "step failed: %s", ex.what());
+            }
+
+            m_session.wait_until_stopped();
+        }
+
+        m_session.wait_until_stopped();
+    }
+
+    return m_session.reason();
+}
+
+void target::step_and_read(const vector<cpureg*>& regs, u8* out) {
+    vector<size_t> offsets(regs.size() + 1, 0);
+    for (size_t i = 0; i < regs.size(); i++)
+        offsets[i + 1] = offsets[i] + regs[i]->size();
+
+    m_conn.advance_epoch();
+
+    // the status request tells whether the step had already completed
+    // when the registers were read, only if not a second trip is needed
+    while (true) {
+        bool stepped = false;
+        bool complete = true;
+        m_conn.pipeline(
+            regs.size() + 2,
+            [&](size_t i, packet& pkt) {
+                if (i == 0)
+                    pkt.begin("step").field(m_name);
+                else if (i == 1)
+                    pkt.begin("status");
+                else
+                    pkt.begin("getr").field(m_name).field(regs[i - 2]->name());
+            },
+            [&](size_t i, response& resp) {
+                if (i == 0) {
+                    stepped = resp.ok();
+                    MWR_REPORT_ON(!stepped &&
+                                      resp.error() != "simulation running",
+                                  "step failed: %s",
+                                  string(resp.error()).c_str());
+                } else if (i == 1) {
+                    // fields beyond the state stay joined with max_fields
+                    if (!resp.ok() || resp.size() < 2 ||
+                        resp[1].compare(0, 7, "stopped") != 0)
+                        complete = false;
+                } else {
+                    string_view data = resp.size() > 1 ? resp[1] : "";
+                    size_t size = offsets[i - 1] - offsets[i - 2];
+                    if (!resp.ok() ||
+                        !decode_hex(data, out + offsets[i - 2], size))
+                        complete = false;
+                }
+            },
+            regs.size() + 2, 2);
+
+        if (stepped && complete)
+            return;
+
+        m_session.wait_until_stopped();
+        if (!stepped)
+            continue;
+
+        fetch_regs(regs, offsets, out);
+        return;
+    }
+}
+
+// parses the id from messages like "inserted breakpoint 3"
+static u64 parse_id(const response& resp) {
+    string_view msg = resp.at(1);
+    msg.remove_prefix(msg.find_last_of(' ') + 1);
+
+    u64 id = 0;
+    auto res = std::from_chars(msg.data(), msg.data() + msg.size(), id);
+    MWR_REPORT_ON(res.ec != std::errc() || msg.empty(), "malformed id");
+    return id;
+}
+
+// looks up the physical address of each page, NO_TRANSLATION marks pages
+// the server could not translate
+// servers answer addresses without a mapping with an error, which is only
+// worth remembering if it says so rather than e.g. naming a bad target
+static bool is_unmapped(string_view err) {
+    return err.find("translat") != string_view::npos ||
+           err.find("not mapped") != string_view::npos;
+}
+
+void target::translate_pages(const vector<u64>& pages, vector<u64>& result,
+                             string* err) {
+    result.assign(pages.size(), NO_TRANSLATION);
+    vector<bool> known(pages.size(), true);
+    m_conn.pipeline(
+        pages.size(),
+        [&](size_t i, packet& pkt) {
+            pkt.begin("vapa").field(m_name).field(pages[i]);
+        },
+        [&](size_t i, response& resp) {
+            if (!resp.ok()) {
+                known[i] = is_unmapped(resp.error());
+                if (err && err->empty())
+                    *err = resp.error();
+                return;
             }
-        } while (err == "simulation running");
+
+            MWR_REPORT_ON(resp.size() < 2, "vapa: malformed response");
+            result[i] = resp.to_u64(1, 16);
+        },
+        m_depth, 2);
+
+    if (!tlb_enabled())
+        return;
+
+    if (m_tlb.size() + pages.size() > MAX_TLB_ENTRIES)
+        m_tlb.clear();
+
+    for (size_t i = 0; i < pages.size(); i++) {
+        if (known[i])
+            m_tlb[pages[i]] = result[i];
     }
+
+    m_tlb_misses += pages.size();
 }
 
 u64 target::virt_to_phys(u64 va) {
-    auto resp = m_conn.command("vapa," + m_name + "," + to_string(va));
-    MWR_REPORT_ON(resp.size() < 2, "%s: malformed response", __func__);
-    return stoull(resp[1], nullptr, 16);
+    if (!tlb_enabled()) {
+        m_conn.request(m_resp, response::ALL_FIELDS, "vapa", m_name, va);
+        MWR_REPORT_ON(m_resp.size() < 2, "%s: malformed response", __func__);
+        return m_resp.to_u64(1, 16);
+    }
+
+    if (m_tlb_epoch != m_conn.epoch())
+        flush_tlb();
+
+    u64 page = va & ~(u64)(m_tlb_page_size - 1);
+    u64 pa;
+
+    auto it = m_tlb.find(page);
+    if (it != m_tlb.end()) {
+        m_tlb_hits++;
+        pa = it->second;
+        MWR_REPORT_ON(pa == NO_TRANSLATION, "no translation for 0x%llx",
+                      (unsigned long long)va);
+    } else {
+        string err;
+        vector<u64> result;
+        translate_pages({ page }, result, &err);
+        pa = result[0];
+        MWR_REPORT_ON(pa == NO_TRANSLATION, "%s", err.c_str());
+    }
+
+    return pa + (va - page);
+}
+
+vector<phys_extent> target::virt_to_phys(u64 va, size_t size, size_t step) {
+    MWR_REPORT_ON(step == 0 || (step & (step - 1)),
+                  "translation step must be a power of two");
+
+    vector<phys_extent> extents;
+    if (size == 0)
+        return extents;
+
+    const u64 end = va + size - 1;
+    MWR_REPORT_ON(end < va, "range 0x%llx+%zu wraps around",
+                  (unsigned long long)va, size);
+
+    if (m_tlb_epoch != m_conn.epoch())
+        flush_tlb();
+
+    // the page size of the target is unknown without the tlb, a lookup is
+    // then only trusted for as far as the caller says
+    const u64 page_size = tlb_enabled() ? m_tlb_page_size : step;
+    const u64 mask = ~(page_size - 1);
+    const u64 first = va & mask;
+    const size_t count = ((end - first) / page_size) + 1;
+
+    // physical page of every virtual page, cached ones are filled in right
+    // away and the rest is looked up in one pipelined batch
+    vector<u64> phys(count, NO_TRANSLATION);
+    vector<u64> missing;
+    vector<size_t> slots;
+    for (size_t i = 0; i < count; i++) {
+        u64 page = first + i * page_size;
+        auto it = m_tlb.find(page);
+        if (it != m_tlb.end()) {
+            phys[i] = it->second;
+            m_tlb_hits++;
+        } else {
+            missing.push_back(page);
+            slots.push_back(i);
+        }
+    }
+
+    if (!missing.empty()) {
+        vector<u64> result;
+        translate_pages(missing, result);
+        for (size_t i = 0; i < slots.size(); i++)
+            phys[slots[i]] = result[i];
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (phys[i] == NO_TRANSLATION)
+            continue;
+
+        // inclusive ends, the last page may end at the top of memory
+        u64 page = first + i * page_size;
+        u64 vstart = std::max(va, page);
+        u64 vlast = std::min(end, page + (page_size - 1));
+        u64 pstart = phys[i] + (vstart - page);
+        u64 len = vlast - vstart + 1;
+
+        phys_extent* last = extents.empty() ? nullptr : &extents.back();
+        if (last && last->vaddr + last->size == vstart &&
+            last->paddr + last->size == pstart) {
+            last->size += len;
+        } else {
+            extents.push_back({ vstart, pstart, len });
+        }
+    }
+
+    return extents;
+}
+
+void target::enable_tlb(size_t page_size) {
+    MWR_REPORT_ON(page_size == 0 || (page_size & (page_size - 1)),
+                  "tlb page size must be a power of two");
+    if (page_size != m_tlb_page_size)
+        flush_tlb();
+    m_tlb_page_size = page_size;
+}
+
+void target::disable_tlb() {
+    flush_tlb();
+    m_tlb_page_size = 0;
+}
+
+void target::flush_tlb() {
+    m_tlb.clear();
+    m_tlb_epoch = m_conn.epoch();
 }
 
 breakpoint target::insert_breakpoint(u64 addr) {
-    auto resp = m_conn.command("mkbp," + m_name + "," + to_string(addr));
-    MWR_REPORT_ON(resp.size() < 2, "%s: malformed response", __func__);
-    const string& msg = resp[1];
-    string bpstr = msg.substr(msg.find_last_of(' ') + 1);
+    m_conn.request(m_resp, response::ALL_FIELDS, "mkbp", m_name, addr);
+    MWR_REPORT_ON(m_resp.size() < 2, "%s: malformed response", __func__);
 
     breakpoint bp;
     bp.addr = addr;
-    bp.id = stoull(bpstr, nullptr, 10);
+    bp.id = parse_id(m_resp);
     return bp;
 }
 
+breakpoint target::insert_breakpoint(const string& symbol) {
+    MWR_REPORT_ON(!m_symbols, "no symbols loaded for %s", m_name.c_str());
+    auto sym = m_symbols->find(symbol);
+    MWR_REPORT_ON(!sym, "symbol %s not found", symbol.c_str());
+    return insert_breakpoint(sym->addr);
+}
+
+void target::set_symbols(std::shared_ptr<const symbol_index> symbols) {
+    m_symbols = std::move(symbols);
+}
+
 void target::remove_breakpoint(const breakpoint& bp) {
-    m_conn.command("rmbp," + to_string(bp.id));
+    m_conn.request(m_resp, response::ALL_FIELDS, "rmbp", bp.id);
 }
 
 watchpoint target::insert_watchpoint(u64 base, u64 size,
                                      watchpoint_type type) {
-    auto resp = m_conn.command("mkwp," + m_name + "," + to_string(base) + "," +
-                               to_string(size) + "," + wp_type_str(type));
-    MWR_REPORT_ON(resp.size() < 2, "%s: malformed response", __func__);
-    const string& msg = resp[1];
-    string wpstr = msg.substr(msg.find_last_of(' ') + 1);
+    m_conn.request(m_resp, response::ALL_FIELDS, "mkwp", m_name, base, size,
+                   wp_type_str(type));
+    MWR_REPORT_ON(m_resp.size() < 2, "%s: malformed response", __func__);
 
     watchpoint wp;
     wp.base = base;
     wp.size = size;
-    wp.id = stoull(wpstr, nullptr, 10);
+    wp.id = parse_id(m_resp);
     wp.type = type;
     return wp;
 }
 
 void target::remove_watchpoint(const watchpoint& wp) {
-    m_conn.command("rmwp," + to_string(wp.id) + "," + wp_type_str(wp.type));
+    m_conn.request(m_resp, response::ALL_FIELDS, "rmwp", wp.id,
+                   wp_type_str(wp.type));
+}
+
+void target::set_chunk_size(size_t size) {
+    MWR_REPORT_ON(size == 0, "chunk size cannot be zero");
+    m_chunk_size = size;
+}
+
+void target::set_transfer_depth(size_t depth) {
+    MWR_REPORT_ON(depth == 0, "transfer depth cannot be zero");
+    m_depth = depth;
+}
+
+void target::enable_cache(size_t page_size) {
+    MWR_REPORT_ON(page_size == 0 || (page_size & (page_size - 1)),
+                  "cache page size must be a power of two");
+    if (page_size != m_page_size)
+        flush_cache();
+    m_page_size = page_size;
+}
+
+void target::disable_cache() {
+    flush_cache();
+    m_page_size = 0;
+}
+
+void target::flush_cache() {
+    m_ppages.clear();
+    m_vpages.clear();
+    m_cache_epoch = m_conn.epoch();
 }
 
 vector<u8> target::read_vmem(u64 vaddr, size_t size) {
-    vector<u8> ret;
-    string cmd = "vread," + m_name + "," + to_string(vaddr) + ',' +
-                 to_string(size);
-    auto resp = m_conn.command(cmd);
-    if (resp.size() != size + 1)
-        MWR_REPORT("%s: malformed response", __func__);
-
-    ret.reserve(size);
-    for (size_t i = 1; i < resp.size(); ++i)
-        ret.emplace_back((u8)stoul(resp[i], nullptr, 16));
+    string err;
+    vector<u8> ret(size);
+    if (read_mem("vread", vaddr, ret.data(), size, &err) < size)
+        MWR_REPORT("%s", err.c_str());
     return ret;
 }
 
 size_t target::write_vmem(u64 vaddr, const vector<u8>& data) {
-    stringstream ss;
-    ss << "vwrite," << m_name << ',' << vaddr;
-    for (auto& v : data)
-        ss << ',' << static_cast<u32>(v);
+    string err;
+    size_t n = write_mem("vwrite", vaddr, data.data(), data.size(), &err);
+    if (!err.empty())
+        MWR_REPORT("%s", err.c_str());
+    return n;
+}
 
-    auto resp = m_conn.command(ss.str());
-    MWR_REPORT_ON(resp.size() < 2, "%s: malformed response", __func__);
+vector<u8> target::read_pmem(u64 paddr, size_t size) {
+    string err;
+    vector<u8> ret(size);
+    if (read_mem("pread", paddr, ret.data(), size, &err) < size)
+        MWR_REPORT("%s", err.c_str());
+    return ret;
+}
 
-    auto parts = split(resp[1], ' ');
-    if (parts.size() != 3)
-        return 0;
+size_t target::write_pmem(u64 paddr, const vector<u8>& data) {
+    string err;
+    size_t n = write_mem("pwrite", paddr, data.data(), data.size(), &err);
+    if (!err.empty())
+        MWR_REPORT("%s", err.c_str());
+    return n;
+}
 
-    const string& bytes_written = parts[0];
-    return stoull(bytes_written, nullptr, 10);
+size_t target::read_vmem(u64 vaddr, u8* buf, size_t size) {
+    return read_mem("vread", vaddr, buf, size);
 }
 
-vector<u8> target::read_pmem(u64 paddr, size_t size) {
-    vector<u8> ret;
-    string cmd = "pread," + m_name + "," + to_string(paddr) + ',' +
-                 to_string(size);
-    auto resp = m_conn.command(cmd);
-    if (resp.size() != size + 1)
-        MWR_REPORT("%s malformed response", __func__);
+size_t target::write_vmem(u64 vaddr, const u8* data, size_t size) {
+    return write_mem("vwrite", vaddr, data, size);
+}
 
-    ret.reserve(size);
-    for (size_t i = 1; i < resp.size(); ++i)
-        ret.emplace_back((u8)stoul(resp[i], nullptr, 16));
+size_t target::read_pmem(u64 paddr, u8* buf, size_t size) {
+    return read_mem("pread", paddr, buf, size);
+}
 
-    return ret;
+size_t target::write_pmem(u64 paddr, const u8* data, size_t size) {
+    return write_mem("pwrite", paddr, data, size);
 }
 
-size_t target::write_pmem(u64 paddr, const vector<u8>& data) {
-    stringstream ss;
-    ss << "pwrite," << m_name << ',' << paddr;
-    for (auto& v : data)
-        ss << ',' << static_cast<u32>(v);
+size_t target::dump_vmem(u64 vaddr, size_t size, ostream& os, bool sparse) {
+    return dump_mem("vread", vaddr, size, os, sparse);
+}
+
+size_t target::dump_pmem(u64 paddr, size_t size, ostream& os, bool sparse) {
+    return dump_mem("pread", paddr, size, os, sparse);
+}
+
+size_t target::dump_vmem(u64 vaddr, size_t size, const string& path,
+                         bool sparse) {
+    return dump_mem("vread", vaddr, size, path, sparse);
+}
+
+size_t target::dump_pmem(u64 paddr, size_t size, const string& path,
+                         bool sparse) {
+    return dump_mem("pread", paddr, size, path, sparse);
+}
 
-    auto resp = m_conn.command(ss.str());
-    MWR_REPORT_ON(resp.size() < 2, "%s: malformed response", __func__);
+vector<u64> target::search_vmem(u64 vaddr, size_t size,
+                                const vector<u8>& pattern,
+                                const vector<u8>& mask) {
+    return search_mem("vread", vaddr, size, byte_pattern(pattern, mask));
+}
+
+vector<u64> target::search_pmem(u64 paddr, size_t size,
+                                const vector<u8>& pattern,
+                                const vector<u8>& mask) {
+    return search_mem("pread", paddr, size, byte_pattern(pattern, mask));
+}
+
+load_stats target::load_image(const string& path, u64 base, bool verify,
+                              const load_progress& progress) {
+    auto start = std::chrono::steady_clock::now();
+
+    // regions without data are uninitialized and get zero filled
+    struct region {
+        u64 addr;
+        const u8* data;
+        size_t size;
+    };
+
+    load_stats stats{};
+    stats.entry = base;
+    stats.verified = verify;
+
+    vector<region> regions;
+    mapped_file file(path);
+    optional<elf_file> elf;
+    if (elf_file::is_elf(file.data(), file.size())) {
+        elf.emplace(std::move(file));
+        stats.entry = base + elf->entry();
+        for (const elf_segment& seg : elf->segments()) {
+            if (seg.type != elf_file::SEGMENT_LOAD || seg.memsz == 0)
+                continue;
 
-    auto parts = split(resp[1], ' ');
-    if (parts.size() != 3)
-        return 0;
+            u64 addr = base + seg.paddr;
+            if (seg.filesz > 0)
+                regions.push_back({ addr, elf->data() + seg.offset,
+                                    (size_t)seg.filesz });
+            if (seg.memsz > seg.filesz)
+                regions.push_back({ addr + seg.filesz, nullptr,
+                                    (size_t)(seg.memsz - seg.filesz) });
+            stats.segments++;
+        }
+    } else if (file.size() > 0) {
+        regions.push_back({ base, file.data(), file.size() });
+        stats.segments = 1;
+    }
+
+    size_t total = 0;
+    for (const region& r : regions)
+        total += r.size;
+
+    vector<u8> zeros;
+    vector<u8> readback;
+    for (const region& r : regions) {
+        if (!r.data && zeros.size() < std::min(r.size, LOAD_BLOCK_SIZE))
+            zeros.resize(std::min(r.size, LOAD_BLOCK_SIZE));
+
+        for (size_t off = 0; off < r.size; off += LOAD_BLOCK_SIZE) {
+            u64 addr = r.addr + off;
+            size_t len = std::min(LOAD_BLOCK_SIZE, r.size - off);
+            const u8* src = r.data ? r.data + off : zeros.data();
+
+            string err;
+            if (write_mem("pwrite", addr, src, len, &err) < len) {
+                MWR_REPORT("%s: failed to write 0x%llx: %s", path.c_str(),
+                           (unsigned long long)addr,
+                           err.empty() ? "incomplete write" : err.c_str());
+            }
 
-    const string& bytes_written = parts[0];
-    return stoull(bytes_written, nullptr, 10);
+            stats.checksum = crc32(src, len, stats.checksum);
+
+            if (verify) {
+                readback.resize(len);
+                if (fetch_mem("pread", addr, readback.data(), len, &err) <
+                    len) {
+                    MWR_REPORT("%s: failed to read back 0x%llx: %s",
+                               path.c_str(), (unsigned long long)addr,
+                               err.c_str());
+                }
+
+                if (memcmp(readback.data(), src, len) != 0) {
+                    auto diff = std::mismatch(src, src + len,
+                                              readback.data());
+                    u64 bad = addr + (diff.first - src);
+                    MWR_REPORT("%s: verification failed at 0x%llx",
+                               path.c_str(), (unsigned long long)bad);
+                }
+            }
+
+            stats.bytes += len;
+            if (progress)
+                progress(stats.bytes, total);
+        }
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() -
+                                            start;
+    stats.seconds = elapsed.count();
+    return stats;
 }
 
 u64 target::get_pc() {
@@ -244,4 +1007,26 @@ cpureg* target::find_reg(const string& name) {
     return nullptr;
 }
 
+const reg_snapshot& target::read_all_regs() {
+    // taken before reading, a change while the registers are in flight
+    // leaves the snapshot stale rather than marking it as current
+    u64 epoch = m_conn.epoch();
+    if (m_snapshot_epoch == epoch)
+        return m_snapshot;
+
+    reg_snapshot snap;
+    snap.offsets.push_back(0);
+    for (const cpureg* reg : m_regs) {
+        snap.names.push_back(reg->name());
+        snap.offsets.push_back(snap.offsets.back() + reg->size());
+    }
+
+    snap.data.resize(snap.offsets.back());
+    fetch_regs(m_regs, snap.offsets, snap.data.data());
+
+    m_snapshot = std::move(snap);
+    m_snapshot_epoch = epoch;
+    return m_snapshot;
+}
+
 } // namespace vsp
@@ -0,0 +1,360 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "vsp/tracer.h"
+
+namespace vsp {
+
+static constexpr string_view TRACE_MAGIC = "VSPTRACE";
+static constexpr string_view INDEX_MAGIC = "VSPTRIDX";
+static constexpr u32 TRACE_VERSION = 1;
+
+// index offset, record count, index interval and magic
+static constexpr size_t FOOTER_SIZE = 8 + 8 + 8 + INDEX_MAGIC.size();
+
+static u64 zigzag(u64 delta) {
+    return (delta << 1) ^ (u64)((i64)delta >> 63);
+}
+
+static u64 unzigzag(u64 val) {
+    return (val >> 1) ^ (~(val & 1) + 1);
+}
+
+static u64 load_le(const u8* data, size_t size) {
+    u64 val = 0;
+    for (size_t i = std::min<size_t>(size, 8); i > 0; i--)
+        val = (val << 8) | data[i - 1];
+    return val;
+}
+
+namespace {
+
+class trace_writer
+{
+private:
+    ofstream m_file;
+    string m_buf;
+    u64 m_offset;
+
+public:
+    explicit trace_writer(const string& path):
+        m_file(path, std::ios::binary | std::ios::trunc),
+        m_buf(),
+        m_offset(0) {
+        MWR_REPORT_ON(!m_file, "cannot open trace file %s", path.c_str());
+    }
+
+    u64 offset() const { return m_offset + m_buf.size(); }
+
+    void put(const void* data, size_t size) {
+        m_buf.append((const char*)data, size);
+        if (m_buf.size() >= 64 * 1024)
+            flush();
+    }
+
+    void put_uint(u64 val, size_t size) {
+        char buf[8];
+        for (size_t i = 0; i < size; i++, val >>= 8)
+            buf[i] = (char)(val & 0xff);
+        put(buf, size);
+    }
+
+    void put_varint(u64 val) {
+        char buf[10];
+        size_t n = 0;
+        for (; val >= 0x80; val >>= 7)
+            buf[n++] = (char)(val | 0x80);
+        buf[n++] = (char)val;
+        put(buf, n);
+    }
+
+    void put_str(string_view s) {
+        put_uint(s.size(), 2);
+        put(s.data(), s.size());
+    }
+
+    void flush() {
+        m_file.write(m_buf.data(), m_buf.size());
+        MWR_REPORT_ON(!m_file, "error writing trace file");
+        m_offset += m_buf.size();
+        m_buf.clear();
+    }
+};
+
+} // namespace
+
+void tracer::add_target(target& t, const vector<string>& regs) {
+    traced tr;
+    tr.tgt = &t;
+    tr.info.name = t.name();
+    tr.info.regs = regs;
+    tr.info.offsets.push_back(0);
+
+    cpureg* pc = t.find_reg("pc");
+    if (!pc)
+        pc = t.find_reg("PC");
+    MWR_REPORT_ON(!pc, "cannot find program counter of %s", t.name());
+    tr.regs.push_back(pc);
+    tr.pc_size = pc->size();
+
+    for (const string& name : regs) {
+        cpureg* reg = t.find_reg(name);
+        MWR_REPORT_ON(!reg, "%s has no register %s", t.name(), name.c_str());
+        tr.regs.push_back(reg);
+        tr.info.offsets.push_back(tr.info.offsets.back() + reg->size());
+    }
+
+    m_targets.push_back(std::move(tr));
+}
+
+tracer::tracer(target& t, const vector<string>& regs):
+    m_targets(), m_interval(INDEX_INTERVAL) {
+    add_target(t, regs);
+}
+
+tracer::tracer(const target_group& group, const vector<string>& regs):
+    m_targets(), m_interval(INDEX_INTERVAL) {
+    for (target* t : group.targets)
+        add_target(*t, regs);
+    MWR_REPORT_ON(m_targets.empty(), "target group %s is empty",
+                  group.name.c_str());
+}
+
+void tracer::set_index_interval(size_t interval) {
+    MWR_REPORT_ON(interval == 0, "index interval must not be zero");
+    m_interval = interval;
+}
+
+size_t tracer::run(const string& path, size_t steps,
+                   const function<bool(u64)>& inside) {
+    trace_writer out(path);
+
+    out.put(TRACE_MAGIC.data(), TRACE_MAGIC.size());
+    out.put_uint(TRACE_VERSION, 4);
+    out.put_uint(m_targets.size(), 4);
+    for (const traced& t : m_targets) {
+        out.put_str(t.info.name);
+        out.put_uint(t.info.regs.size(), 4);
+        for (size_t i = 0; i < t.info.regs.size(); i++) {
+            out.put_str(t.info.regs[i]);
+            out.put_uint(t.info.offsets[i + 1] - t.info.offsets[i], 4);
+        }
+    }
+
+    vector<u64> prev_pcs(m_targets.size());
+    vector<vector<u8>> prev_regs(m_targets.size());
+    vector<u64> index;
+    vector<u8> vals, mask;
+
+    size_t count = 0;
+    while (count < steps) {
+        size_t idx = count % m_targets.size();
+        traced& t = m_targets[idx];
+        const vector<size_t>& offsets = t.info.offsets;
+
+        vals.resize(t.pc_size + offsets.back());
+        t.tgt->step_and_read(t.regs, vals.data());
+        u64 pc = load_le(vals.data(), t.pc_size);
+        const u8* regs = vals.data() + t.pc_size;
+
+        if (count % m_interval == 0) {
+            index.push_back(out.offset());
+            for (size_t i = 0; i < m_targets.size(); i++) {
+                prev_pcs[i] = 0;
+                prev_regs[i].assign(m_targets[i].info.offsets.back(), 0);
+            }
+        }
+
+        mask.assign((t.info.regs.size() + 7) / 8, 0);
+        for (size_t i = 0; i < t.info.regs.size(); i++) {
+            if (memcmp(regs + offsets[i], prev_regs[idx].data() + offsets[i],
+                       offsets[i + 1] - offsets[i])) {
+                mask[i / 8] |= 1u << (i % 8);
+            }
+        }
+
+        out.put_varint(idx);
+        out.put_varint(zigzag(pc - prev_pcs[idx]));
+        out.put(mask.data(), mask.size());
+        for (size_t i = 0; i < t.info.regs.size(); i++) {
+            if (mask[i / 8] & (1u << (i % 8)))
+                out.put(regs + offsets[i], offsets[i + 1] - offsets[i]);
+        }
+
+        prev_pcs[idx] = pc;
+        prev_regs[idx].assign(regs, regs + offsets.back());
+
+        count++;
+        if (inside && !inside(pc))
+            break;
+    }
+
+    u64 index_offset = out.offset();
+    for (u64 offset : index)
+        out.put_uint(offset, 8);
+
+    out.put_uint(index_offset, 8);
+    out.put_uint(count, 8);
+    out.put_uint(m_interval, 8);
+    out.put(INDEX_MAGIC.data(), INDEX_MAGIC.size());
+    out.flush();
+
+    return count;
+}
+
+size_t tracer::trace(const string& path, size_t steps) {
+    return run(path, steps, nullptr);
+}
+
+size_t tracer::trace_range(const string& path, u64 lo, u64 hi,
+                           size_t max_steps) {
+    return run(path, max_steps,
+               [lo, hi](u64 pc) { return pc >= lo && pc < hi; });
+}
+
+void trace_reader::read(void* data, size_t size) {
+    m_file.read((char*)data, size);
+    MWR_REPORT_ON(!m_file, "trace file truncated");
+}
+
+u64 trace_reader::read_uint(size_t size) {
+    u8 buf[8];
+    read(buf, size);
+    return load_le(buf, size);
+}
+
+u64 trace_reader::read_varint() {
+    u64 val = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        u8 byte;
+        read(&byte, 1);
+        val |= (u64)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return val;
+    }
+
+    MWR_REPORT("malformed trace record");
+}
+
+string trace_reader::read_str() {
+    string s(read_uint(2), '\0');
+    read(s.data(), s.size());
+    return s;
+}
+
+void trace_reader::restart(u64 pos) {
+    size_t keyframe = pos / m_interval;
+    MWR_REPORT_ON(keyframe >= m_index.size(), "malformed trace index");
+
+    m_file.clear();
+    m_file.seekg(m_index[keyframe]);
+    m_pos = keyframe * m_interval;
+
+    for (size_t i = 0; i < m_targets.size(); i++) {
+        m_pcs[i] = 0;
+        m_regs[i].assign(m_targets[i].offsets.back(), 0);
+    }
+}
+
+trace_reader::trace_reader(const string& path):
+    m_file(path, std::ios::binary),
+    m_targets(),
+    m_index(),
+    m_count(0),
+    m_interval(0),
+    m_pos(0),
+    m_pcs(),
+    m_regs(),
+    m_mask() {
+    MWR_REPORT_ON(!m_file, "cannot open trace file %s", path.c_str());
+
+    char magic[8];
+    read(magic, sizeof(magic));
+    MWR_REPORT_ON(TRACE_MAGIC != string_view(magic, sizeof(magic)),
+                  "%s is not a trace file", path.c_str());
+    u64 version = read_uint(4);
+    MWR_REPORT_ON(version != TRACE_VERSION, "unsupported trace version %llu",
+                  (unsigned long long)version);
+
+    m_targets.resize(read_uint(4));
+    for (trace_target& t : m_targets) {
+        t.name = read_str();
+        t.regs.resize(read_uint(4));
+        t.offsets.assign(1, 0);
+        for (string& reg : t.regs) {
+            reg = read_str();
+            t.offsets.push_back(t.offsets.back() + read_uint(4));
+        }
+    }
+
+    m_file.seekg(-(std::streamoff)FOOTER_SIZE, std::ios::end);
+    u64 index_offset = read_uint(8);
+    m_count = read_uint(8);
+    m_interval = read_uint(8);
+    read(magic, sizeof(magic));
+    MWR_REPORT_ON(INDEX_MAGIC != string_view(magic, sizeof(magic)),
+                  "trace file %s has no index", path.c_str());
+    MWR_REPORT_ON(m_interval == 0, "malformed trace index");
+
+    m_file.seekg(index_offset);
+    m_index.resize((m_count + m_interval - 1) / m_interval);
+    for (u64& offset : m_index)
+        offset = read_uint(8);
+
+    m_pcs.resize(m_targets.size());
+    m_regs.resize(m_targets.size());
+    if (m_count > 0)
+        restart(0);
+}
+
+void trace_reader::seek(size_t pos) {
+    MWR_REPORT_ON(pos > m_count, "seeking beyond trace end");
+    if (pos == m_count) {
+        m_pos = m_count;
+        return;
+    }
+
+    if (pos < m_pos || pos / m_interval != m_pos / m_interval)
+        restart(pos);
+
+    trace_record skip;
+    while (m_pos < pos)
+        next(skip);
+}
+
+bool trace_reader::next(trace_record& rec) {
+    if (m_pos >= m_count)
+        return false;
+
+    if (m_pos % m_interval == 0)
+        restart(m_pos);
+
+    rec.target = read_varint();
+    MWR_REPORT_ON(rec.target >= m_targets.size(), "malformed trace record");
+
+    const vector<size_t>& offsets = m_targets[rec.target].offsets;
+    vector<u8>& regs = m_regs[rec.target];
+
+    rec.pc = m_pcs[rec.target] += unzigzag(read_varint());
+
+    size_t nregs = offsets.size() - 1;
+    m_mask.resize((nregs + 7) / 8);
+    read(m_mask.data(), m_mask.size());
+    for (size_t i = 0; i < nregs; i++) {
+        if (m_mask[i / 8] & (1u << (i % 8)))
+            read(regs.data() + offsets[i], offsets[i + 1] - offsets[i]);
+    }
+
+    rec.regs.assign(regs.begin(), regs.end());
+    m_pos++;
+    return true;
+}
+
+} // namespace vsp
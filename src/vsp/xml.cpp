@@ -0,0 +1,461 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "vsp/xml.h"
+
+namespace vsp {
+
+static bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static void append_utf8(string& s, u32 cp) {
+    if (cp < 0x80) {
+        s += (char)cp;
+    } else if (cp < 0x800) {
+        s += (char)(0xc0 | (cp >> 6));
+        s += (char)(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        s += (char)(0xe0 | (cp >> 12));
+        s += (char)(0x80 | ((cp >> 6) & 0x3f));
+        s += (char)(0x80 | (cp & 0x3f));
+    } else {
+        s += (char)(0xf0 | (cp >> 18));
+        s += (char)(0x80 | ((cp >> 12) & 0x3f));
+        s += (char)(0x80 | ((cp >> 6) & 0x3f));
+        s += (char)(0x80 | (cp & 0x3f));
+    }
+}
+
+string_view xml_attrs::get(string_view name) const {
+    for (const auto& [key, value] : m_attrs) {
+        if (key == name)
+            return value;
+    }
+
+    return "";
+}
+
+u64 xml_attrs::get_u64(string_view name) const {
+    string_view s = get(name);
+    int base = 10;
+    if (s.size() > 2 && s[0] == '0' && (s[1] | 0x20) == 'x') {
+        s.remove_prefix(2);
+        base = 16;
+    }
+
+    u64 val = 0;
+    auto res = std::from_chars(s.data(), s.data() + s.size(), val, base);
+    return res.ec == std::errc() ? val : 0;
+}
+
+xml_reader::xml_reader():
+    m_markup(MARKUP_NONE),
+    m_quote(0),
+    m_buf(),
+    m_text(),
+    m_decoded(),
+    m_names(),
+    m_open(),
+    m_attrs(),
+    m_root_seen(false),
+    m_offset(0),
+    m_markup_pos(0),
+    m_error() {
+    // nothing to do
+}
+
+void xml_reader::begin_element(string_view, const xml_attrs&) {
+    // nothing to do
+}
+
+void xml_reader::end_element(string_view) {
+    // nothing to do
+}
+
+void xml_reader::text(string_view) {
+    // nothing to do
+}
+
+void xml_reader::end_document() {
+    // nothing to do
+}
+
+void xml_reader::fail(const string& msg) {
+    if (m_error.empty()) {
+        m_error = mkstr("%s at offset %llu", msg.c_str(),
+                        (unsigned long long)m_markup_pos);
+    }
+}
+
+// checks whether the markup that started in m_buf and continues from
+// begin up to gt ends with suffix and is long enough to hold both suffix
+// and the given number of characters that opened it
+bool xml_reader::has_suffix(const char* begin, const char* gt,
+                            string_view suffix, size_t prefix) const {
+    size_t len = m_buf.size() + (gt - begin);
+    if (len < prefix + suffix.size())
+        return false;
+
+    for (size_t i = 0; i < suffix.size(); i++) {
+        size_t k = len - suffix.size() + i;
+        char c = k < m_buf.size() ? m_buf[k] : begin[k - m_buf.size()];
+        if (c != suffix[i])
+            return false;
+    }
+
+    return true;
+}
+
+const char* xml_reader::find_markup_end(const char* p, const char* end) {
+    const char* begin = p;
+    switch (m_markup) {
+    case MARKUP_TAG:
+    case MARKUP_DECL:
+        for (; p != end; p++) {
+            if (m_quote) {
+                if (*p == m_quote)
+                    m_quote = 0;
+            } else if (*p == '"' || *p == '\'') {
+                m_quote = *p;
+            } else if (*p == '>') {
+                return p;
+            }
+        }
+
+        return nullptr;
+
+    case MARKUP_COMMENT:
+    case MARKUP_CDATA:
+    case MARKUP_PI: {
+        string_view suffix = m_markup == MARKUP_COMMENT ? "--"
+                             : m_markup == MARKUP_CDATA ? "]]"
+                                                        : "?";
+        size_t prefix = m_markup == MARKUP_COMMENT ? 3
+                        : m_markup == MARKUP_CDATA ? 8
+                                                   : 1;
+        while (p != end) {
+            const char* gt = (const char*)memchr(p, '>', end - p);
+            if (!gt)
+                return nullptr;
+            if (has_suffix(begin, gt, suffix, prefix))
+                return gt;
+            p = gt + 1;
+        }
+
+        return nullptr;
+    }
+
+    default:
+        MWR_ERROR("invalid markup kind %d", (int)m_markup);
+    }
+}
+
+string_view xml_reader::decode(string_view str) {
+    if (str.find('&') == string_view::npos)
+        return str;
+
+    // decoding never grows a string, callers reserve enough room up front
+    // so that earlier results stay where they are
+    size_t start = m_decoded.size();
+    size_t i = 0;
+    while (i < str.size()) {
+        size_t amp = str.find('&', i);
+        if (amp == string_view::npos) {
+            m_decoded.append(str.substr(i));
+            break;
+        }
+
+        m_decoded.append(str.substr(i, amp - i));
+        i = amp + 1;
+
+        size_t semi = str.find(';', amp);
+        if (semi == string_view::npos || semi - amp > 12) {
+            m_decoded += '&';
+            continue;
+        }
+
+        string_view ent = str.substr(amp + 1, semi - amp - 1);
+        if (ent == "lt")
+            m_decoded += '<';
+        else if (ent == "gt")
+            m_decoded += '>';
+        else if (ent == "amp")
+            m_decoded += '&';
+        else if (ent == "quot")
+            m_decoded += '"';
+        else if (ent == "apos")
+            m_decoded += '\'';
+        else if (ent.size() > 1 && ent[0] == '#') {
+            int base = 10;
+            ent.remove_prefix(1);
+            if ((ent[0] | 0x20) == 'x') {
+                ent.remove_prefix(1);
+                base = 16;
+            }
+
+            u32 cp = 0;
+            auto res = std::from_chars(ent.data(), ent.data() + ent.size(),
+                                       cp, base);
+            if (res.ec != std::errc() || res.ptr != ent.data() + ent.size() ||
+                cp > 0x10ffff) {
+                m_decoded += '&';
+                continue;
+            }
+
+            append_utf8(m_decoded, cp);
+        } else {
+            // unknown entities are kept as they are
+            m_decoded += '&';
+            continue;
+        }
+
+        i = semi + 1;
+    }
+
+    return string_view(m_decoded.data() + start, m_decoded.size() - start);
+}
+
+void xml_reader::flush_text() {
+    bool blank = true;
+    for (char c : m_text) {
+        if (!is_space(c)) {
+            blank = false;
+            break;
+        }
+    }
+
+    if (!blank) {
+        m_decoded.clear();
+        m_decoded.reserve(m_text.size());
+        text(decode(m_text));
+    }
+
+    m_text.clear();
+}
+
+void xml_reader::start_tag(string_view str) {
+    bool empty = !str.empty() && str.back() == '/';
+    if (empty)
+        str.remove_suffix(1);
+
+    size_t i = 0;
+    while (i < str.size() && !is_space(str[i]))
+        i++;
+
+    string_view name = str.substr(0, i);
+    if (name.empty()) {
+        fail("missing element name");
+        return;
+    }
+
+    m_attrs.m_attrs.clear();
+    m_decoded.clear();
+    m_decoded.reserve(str.size());
+
+    while (true) {
+        while (i < str.size() && is_space(str[i]))
+            i++;
+        if (i == str.size())
+            break;
+
+        size_t key = i;
+        while (i < str.size() && str[i] != '=' && !is_space(str[i]))
+            i++;
+        size_t keylen = i - key;
+
+        while (i < str.size() && is_space(str[i]))
+            i++;
+        if (keylen == 0 || i == str.size() || str[i] != '=') {
+            fail(mkstr("malformed attribute in <%.*s>", (int)name.size(),
+                       name.data()));
+            return;
+        }
+
+        i++;
+        while (i < str.size() && is_space(str[i]))
+            i++;
+
+        size_t close = string_view::npos;
+        if (i < str.size() && (str[i] == '"' || str[i] == '\''))
+            close = str.find(str[i], i + 1);
+        if (close == string_view::npos) {
+            fail(mkstr("unquoted attribute value in <%.*s>",
+                       (int)name.size(), name.data()));
+            return;
+        }
+
+        string_view value = decode(str.substr(i + 1, close - i - 1));
+        m_attrs.m_attrs.emplace_back(str.substr(key, keylen), value);
+        i = close + 1;
+    }
+
+    m_root_seen = true;
+    m_open.push_back(m_names.size());
+    m_names.append(name);
+
+    begin_element(name, m_attrs);
+    if (empty)
+        end_tag(name);
+}
+
+void xml_reader::end_tag(string_view str) {
+    while (!str.empty() && is_space(str.back()))
+        str.remove_suffix(1);
+
+    if (m_open.empty()) {
+        fail(mkstr("unexpected </%.*s>", (int)str.size(), str.data()));
+        return;
+    }
+
+    string_view open = string_view(m_names).substr(m_open.back());
+    if (open != str) {
+        fail(mkstr("</%.*s> does not close <%.*s>", (int)str.size(),
+                   str.data(), (int)open.size(), open.data()));
+        return;
+    }
+
+    end_element(str);
+    m_names.resize(m_open.back());
+    m_open.pop_back();
+}
+
+void xml_reader::markup(string_view str) {
+    switch (m_markup) {
+    case MARKUP_TAG:
+        if (!str.empty() && str[0] == '/')
+            end_tag(str.substr(1));
+        else
+            start_tag(str);
+        break;
+
+    case MARKUP_CDATA:
+        if (!m_open.empty())
+            text(str.substr(8, str.size() - 10));
+        break;
+
+    default:
+        break;
+    }
+}
+
+void xml_reader::feed(const char* data, size_t size) {
+    const char* p = data;
+    const char* end = data + size;
+
+    while (p != end && !failed()) {
+        if (m_markup == MARKUP_NONE) {
+            const char* lt = (const char*)memchr(p, '<', end - p);
+            const char* stop = lt ? lt : end;
+
+            // text outside of the root element carries no meaning
+            if (!m_open.empty())
+                m_text.append(p, stop);
+
+            p = stop;
+            if (!lt)
+                break;
+
+            flush_text();
+            m_markup = MARKUP_UNKNOWN;
+            m_markup_pos = m_offset + (lt - data);
+            m_quote = 0;
+            p++;
+            continue;
+        }
+
+        if (m_markup == MARKUP_UNKNOWN) {
+            // comments and CDATA sections need up to eight characters to
+            // be told apart from other declarations
+            char head[8];
+            size_t n = std::min(m_buf.size(), sizeof(head));
+            memcpy(head, m_buf.data(), n);
+            size_t more = std::min<size_t>(sizeof(head) - n, end - p);
+            memcpy(head + n, p, more);
+            n += more;
+
+            string_view s(head, n);
+            string_view comment = "!--";
+            string_view cdata = "![CDATA[";
+            if (s[0] == '?') {
+                m_markup = MARKUP_PI;
+            } else if (s[0] != '!') {
+                m_markup = MARKUP_TAG;
+            } else if (s.substr(0, comment.size()) == comment) {
+                m_markup = MARKUP_COMMENT;
+            } else if (s == cdata) {
+                m_markup = MARKUP_CDATA;
+            } else if (s == comment.substr(0, n) || s == cdata.substr(0, n)) {
+                m_buf.append(p, end);
+                break;
+            } else {
+                m_markup = MARKUP_DECL;
+            }
+        }
+
+        const char* gt = find_markup_end(p, end);
+        if (!gt) {
+            m_buf.append(p, end);
+            break;
+        }
+
+        if (m_buf.empty()) {
+            markup(string_view(p, gt - p));
+        } else {
+            m_buf.append(p, gt);
+            markup(m_buf);
+            m_buf.clear();
+        }
+
+        m_markup = MARKUP_NONE;
+        p = gt + 1;
+    }
+
+    m_offset += size;
+}
+
+void xml_reader::finish() {
+    if (!failed()) {
+        if (m_markup != MARKUP_NONE) {
+            fail("unterminated markup");
+        } else if (!m_open.empty()) {
+            m_markup_pos = m_offset;
+            string_view open = string_view(m_names).substr(m_open.back());
+            fail(mkstr("<%.*s> not closed", (int)open.size(), open.data()));
+        } else if (!m_root_seen) {
+            m_markup_pos = m_offset;
+            fail("no root element");
+        }
+    }
+
+    string error = m_error;
+    reset();
+
+    MWR_REPORT_ON(!error.empty(), "invalid xml: %s", error.c_str());
+    end_document();
+}
+
+void xml_reader::reset() {
+    m_markup = MARKUP_NONE;
+    m_quote = 0;
+    m_buf.clear();
+    m_text.clear();
+    m_decoded.clear();
+    m_names.clear();
+    m_open.clear();
+    m_attrs.m_attrs.clear();
+    m_root_seen = false;
+    m_offset = 0;
+    m_markup_pos = 0;
+    m_error.clear();
+}
+
+} // namespace vsp
@@ -0,0 +1,207 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+static size_t count_images(const string& dir) {
+    size_t n = 0;
+    for (const auto& entry : fs::directory_iterator(dir))
+        n += entry.path().extension() == ".vsph" ? 1 : 0;
+    return n;
+}
+
+// every connect gets a fresh session, like a new run of a tool would
+class cache_test : public mockvp_test
+{
+protected:
+    string dir;
+
+    explicit cache_test(u32 caps = mockvp::DEFAULT_CAPS):
+        mockvp_test(caps, false),
+        dir((fs::temp_directory_path() / "vsp_cache_test").string()) {
+        fs::remove_all(dir);
+    }
+
+    virtual ~cache_test() { fs::remove_all(dir); }
+
+    unique_ptr<session> connect() {
+        unique_ptr<session> client(new session());
+        client->set_cache_dir(dir);
+        client->connect(server.host(), server.port());
+        return client;
+    }
+
+    string dump(session& client) {
+        stringstream ss;
+        client.dump(ss);
+        return ss.str();
+    }
+};
+
+class cache_digest_test : public cache_test
+{
+protected:
+    cache_digest_test():
+        cache_test(mockvp::DEFAULT_CAPS | VSP_CAP_LIST_DIGEST) {}
+};
+
+TEST(checksum, fnv1a64) {
+    EXPECT_EQ(fnv1a64(nullptr, 0), FNV1A64_INIT);
+    EXPECT_EQ(fnv1a64((const u8*)"a", 1), 0xaf63dc4c8601ec8cull);
+    EXPECT_EQ(fnv1a64((const u8*)"foobar", 6), 0x85944171f73967e8ull);
+    u64 hash = fnv1a64((const u8*)"foo", 3);
+    EXPECT_EQ(fnv1a64((const u8*)"bar", 3, hash), 0x85944171f73967e8ull);
+}
+
+TEST_F(cache_test, listing) {
+    string xml = make_test_hierarchy(0, 8, "cpu", true);
+    server.handle("list", [&xml](const response&) { return "OK," + xml; });
+
+    auto client = connect();
+    EXPECT_FALSE(client->modules_hierarchy().from_cache());
+    EXPECT_EQ(server.count("list"), 1);
+    EXPECT_EQ(count_images(dir), 1);
+    string listed = dump(*client);
+    client->disconnect();
+
+    // the listing is only received to check its digest
+    client = connect();
+    const hierarchy& hier = client->modules_hierarchy();
+    EXPECT_TRUE(hier.from_cache());
+    EXPECT_EQ(server.count("list"), 2);
+    EXPECT_EQ(hier.strings().size(), 0);
+    EXPECT_EQ(dump(*client), listed);
+    EXPECT_EQ(hier.num_modules(), 1 + 1 + 8);
+    EXPECT_EQ(hier.num_attributes(), 1 + 2 * 8);
+    EXPECT_EQ(hier.num_commands(), 8);
+
+    module* sys = client->find_module("system");
+    ASSERT_NE(sys, nullptr);
+    EXPECT_STREQ(sys->version(), "2.0");
+    attribute* freq = client->find_attribute("system.cpu5.freq");
+    ASSERT_NE(freq, nullptr);
+    EXPECT_EQ(freq->count(), 1);
+    EXPECT_EQ(freq->type(), "u64");
+    EXPECT_EQ(freq->parent()->parent(), sys);
+    command* reset = client->find_command("system.cpu7.reset");
+    ASSERT_NE(reset, nullptr);
+    EXPECT_EQ(reset->argc(), 0);
+    EXPECT_STREQ(reset->desc(), "resets");
+
+    ASSERT_EQ(client->targets().size(), 1);
+    EXPECT_STREQ(client->targets()[0]->name(), mockvp::TARGET);
+    EXPECT_NE(client->find_target_group("cpus"), nullptr);
+    client->disconnect();
+
+    // a different listing from the same simulation is taken from the
+    // transfer that checked its digest rather than listed again
+    xml = make_test_hierarchy(0, 8, "core", true);
+    client = connect();
+    EXPECT_FALSE(client->modules_hierarchy().from_cache());
+    EXPECT_EQ(server.count("list"), 3);
+    EXPECT_STREQ(client->find_module("system.cpu0")->kind(), "core");
+    EXPECT_EQ(count_images(dir), 1);
+    client->disconnect();
+
+    // the new listing replaced the image of the old one
+    client = connect();
+    EXPECT_TRUE(client->modules_hierarchy().from_cache());
+    EXPECT_EQ(server.count("list"), 4);
+    EXPECT_STREQ(client->find_module("system.cpu0")->kind(), "core");
+    client->disconnect();
+}
+
+TEST_F(cache_digest_test, digest) {
+    auto client = connect();
+    EXPECT_FALSE(client->modules_hierarchy().from_cache());
+    EXPECT_EQ(server.count("list"), 2);
+    client->disconnect();
+
+    // servers with digests do not send their listing again
+    client = connect();
+    EXPECT_TRUE(client->modules_hierarchy().from_cache());
+    EXPECT_EQ(server.count("list"), 3);
+    EXPECT_NE(client->find_attribute("system.cpu.arch"), nullptr);
+    target* cpu = client->find_target(mockvp::TARGET);
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_EQ(cpu->group().name, "cpus");
+    client->disconnect();
+}
+
+TEST_F(cache_test, damaged) {
+    connect()->disconnect();
+    ASSERT_EQ(count_images(dir), 1);
+    fs::path image = fs::directory_iterator(dir)->path();
+    fs::resize_file(image, fs::file_size(image) - 1);
+
+    // damaged images are listed anew and replaced
+    auto client = connect();
+    EXPECT_FALSE(client->modules_hierarchy().from_cache());
+    EXPECT_NE(client->find_module("system.cpu"), nullptr);
+    client->disconnect();
+
+    client = connect();
+    EXPECT_TRUE(client->modules_hierarchy().from_cache());
+    EXPECT_NE(client->find_module("system.cpu"), nullptr);
+    client->disconnect();
+}
+
+TEST_F(cache_test, images) {
+    connection conn;
+    hierarchy hier(conn);
+    hier.begin_module("", "", "");
+    hier.begin_module("sys", "soc", "1.0");
+    hier.add_attribute("clock", "u64", 1ull << 40);
+    hier.begin_module("cpu", "cpu", "");
+    hier.add_command("reset", 0, "resets the core");
+    hier.end_module();
+    hier.add_command("dump", 1, "");
+    hier.end_module();
+    hier.end_module();
+    hier.finish();
+
+    hierarchy_cache cache(dir);
+    string key = hierarchy_cache::key("2.3.1", "2025.01", VSP_V2);
+    EXPECT_FALSE(cache.contains(key));
+    cache.store(key, 42, hier, { { "sys.cpu", "riscv", "" } });
+    EXPECT_TRUE(cache.contains(key));
+    EXPECT_FALSE(cache.contains(hierarchy_cache::key("2.3.1", "", VSP_V2)));
+
+    hierarchy copy(conn);
+    vector<target_desc> targets;
+    EXPECT_FALSE(cache.load(key, 43, copy, targets));
+    ASSERT_TRUE(cache.load(key, 42, copy, targets));
+    EXPECT_EQ(copy.digest(), 42);
+    EXPECT_EQ(copy.num_modules(), 3);
+    EXPECT_EQ(copy.num_attributes(), 1);
+    EXPECT_EQ(copy.num_commands(), 2);
+
+    module* cpu = copy.index().find_module("sys.cpu");
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_STREQ(cpu->parent()->kind(), "soc");
+    EXPECT_EQ(cpu->parent()->parent(), copy.root());
+    EXPECT_EQ(copy.index().find_attribute("sys.clock")->count(), 1ull << 40);
+    EXPECT_STREQ(copy.index().find_command("sys.cpu.reset")->desc(),
+                 "resets the core");
+
+    ASSERT_EQ(targets.size(), 1);
+    EXPECT_EQ(targets[0].name, "sys.cpu");
+    EXPECT_EQ(targets[0].arch, "riscv");
+    EXPECT_EQ(targets[0].group, "");
+
+    copy.clear();
+    EXPECT_FALSE(copy.from_cache());
+    EXPECT_THROW(cache.store(key, 42, copy, targets), mwr::report);
+}
@@ -13,8 +13,28 @@
 #include <future>
 #include <string_view>
 
+using namespace testing;
 using namespace vsp;
 
+static string frame(const string& payload) {
+    u8 csum = 0;
+    for (char c : payload)
+        csum += static_cast<u8>(c);
+    return "$" + payload + mkstr("#%02x", csum);
+}
+
+static bool serve(mwr::server_socket& server, int client, const string& cmd,
+                  const string& reply) {
+    for (const char& c : frame(cmd)) {
+        if (server.recv_char(client) != c)
+            return false;
+    }
+
+    server.send(client, "+");
+    server.send(client, frame(reply));
+    return server.recv_char(client) == '+';
+}
+
 TEST(connection, constructor) {
     connection conn;
     EXPECT_STREQ(conn.host(), "");
@@ -166,3 +186,284 @@ TEST(connection, nack) {
     EXPECT_EQ(resp[0], "OK");
     EXPECT_EQ(resp[1], "myarg");
 }
+
+TEST(connection, large_response) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    EXPECT_TRUE(conn.is_connected());
+
+    server.poll(100);
+    EXPECT_TRUE(server.is_connected());
+    int client = server.clients()[0];
+
+    // payload with escaped framing characters, sent in uneven pieces
+    string payload;
+    for (size_t i = 0; i < 300000; i++)
+        payload += "abc$#}"[i % 6];
+
+    string escaped = "OK,";
+    for (char c : payload) {
+        if (c == '$' || c == '#' || c == '}')
+            escaped += { '}', char(c ^ 0x20) };
+        else
+            escaped += c;
+    }
+
+    u8 csum = 0;
+    for (char c : escaped)
+        csum += static_cast<u8>(c);
+    string frame = "$" + escaped + mkstr("#%02x", csum);
+
+    std::future<bool> correct = std::async([&server, client, &frame]() {
+        std::string_view expected_msg = "$test#c0";
+        for (const char& c : expected_msg) {
+            if (server.recv_char(client) != c)
+                return false;
+        }
+
+        server.send(client, "+");
+        for (size_t off = 0; off < frame.size(); off += 4093) {
+            size_t n = std::min<size_t>(4093, frame.size() - off);
+            server.send(client, frame.data() + off, n);
+        }
+
+        return server.recv_char(client) == '+';
+    });
+
+    auto resp = conn.command("test");
+    correct.wait();
+    EXPECT_TRUE(correct.get());
+    ASSERT_EQ(resp.size(), 2);
+    EXPECT_EQ(resp[0], "OK");
+    EXPECT_EQ(resp[1], payload);
+}
+
+TEST(connection, stream) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    server.poll(100);
+    ASSERT_TRUE(server.is_connected());
+    int client = server.clients()[0];
+
+    // fields escape commas and backslashes, framing characters on top
+    string payload;
+    for (size_t i = 0; i < 100000; i++)
+        payload += "ab,\\$#}"[i % 7];
+
+    string fields = "OK,";
+    for (char c : payload) {
+        if (c == ',' || c == '\\')
+            fields += '\\';
+        fields += c;
+    }
+
+    fields += ",dropped";
+
+    string escaped;
+    for (char c : fields) {
+        if (c == '$' || c == '#' || c == '}')
+            escaped += { '}', char(c ^ 0x20) };
+        else
+            escaped += c;
+    }
+
+    u8 csum = 0;
+    for (char c : escaped)
+        csum += static_cast<u8>(c);
+    string frame = "$" + escaped + mkstr("#%02x", csum);
+
+    std::future<bool> correct = std::async([&server, client, &frame]() {
+        std::string_view expected_msg = "$test#c0";
+        for (const char& c : expected_msg) {
+            if (server.recv_char(client) != c)
+                return false;
+        }
+
+        server.send(client, "+");
+        for (size_t off = 0; off < frame.size(); off += 1021) {
+            size_t n = std::min<size_t>(1021, frame.size() - off);
+            server.send(client, frame.data() + off, n);
+        }
+
+        return server.recv_char(client) == '+' &&
+               serve(server, client, "fail", "ERROR,not\\, today") &&
+               serve(server, client, "next", "OK");
+    });
+
+    string streamed;
+    conn.request_stream("test", [&streamed](const char* data, size_t size) {
+        streamed.append(data, size);
+    });
+    EXPECT_EQ(streamed, payload);
+
+    streamed.clear();
+    try {
+        conn.request_stream("fail", [&streamed](const char* data,
+                                                size_t size) {
+            streamed.append(data, size);
+        });
+        ADD_FAILURE() << "error response not reported";
+    } catch (mwr::report& err) {
+        EXPECT_STREQ(err.what(), "not, today");
+    }
+
+    EXPECT_TRUE(streamed.empty());
+    EXPECT_TRUE(conn.is_connected());
+    EXPECT_EQ(conn.command("next"), vector<string>{ "OK" });
+
+    correct.wait();
+    EXPECT_TRUE(correct.get());
+}
+
+TEST(connection, batch) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    EXPECT_TRUE(conn.is_connected());
+
+    server.poll(100);
+    EXPECT_TRUE(server.is_connected());
+    int client = server.clients()[0];
+
+    std::future<bool> correct = std::async([&server, client]() {
+        for (int i = 0; i < 100; i++) {
+            if (!serve(server, client, mkstr("cmd%d", i), mkstr("OK,%d", i)))
+                return false;
+        }
+
+        return serve(server, client, "a", "OK,a") &&
+               serve(server, client, "b", "E,failed") &&
+               serve(server, client, "c", "OK,c") &&
+               serve(server, client, "d", "OK,d");
+    });
+
+    vector<string> cmds;
+    for (int i = 0; i < 100; i++)
+        cmds.push_back(mkstr("cmd%d", i));
+
+    auto resps = conn.command_batch(cmds);
+    ASSERT_EQ(resps.size(), cmds.size());
+    for (size_t i = 0; i < resps.size(); i++)
+        EXPECT_THAT(resps[i], ElementsAre("OK", to_string(i)));
+
+    EXPECT_THROW(conn.command_batch({ "a", "b", "c" }), mwr::report);
+    EXPECT_TRUE(conn.is_connected());
+
+    auto resp = conn.command("d");
+    EXPECT_THAT(resp, ElementsAre("OK", "d"));
+
+    correct.wait();
+    EXPECT_TRUE(correct.get());
+}
+
+TEST(connection, async) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    EXPECT_TRUE(conn.is_connected());
+
+    server.poll(100);
+    EXPECT_TRUE(server.is_connected());
+    int client = server.clients()[0];
+
+    std::future<bool> correct = std::async([&server, client]() {
+        for (int i = 0; i < 20; i++) {
+            string reply = i == 7 ? "E,failed" : mkstr("OK,%d", i);
+            if (!serve(server, client, mkstr("cmd%d", i), reply))
+                return false;
+        }
+
+        return true;
+    });
+
+    vector<std::future<vector<string>>> resps;
+    for (int i = 0; i < 20; i++)
+        resps.push_back(conn.command_async(mkstr("cmd%d", i)));
+
+    for (int i = 0; i < 20; i++) {
+        if (i == 7)
+            EXPECT_THROW(resps[i].get(), mwr::report);
+        else
+            EXPECT_THAT(resps[i].get(), ElementsAre("OK", to_string(i)));
+    }
+
+    correct.wait();
+    EXPECT_TRUE(correct.get());
+}
+
+TEST(connection, async_unresponsive) {
+    mwr::server_socket server(1, 0);
+    std::future<vector<string>> resp;
+
+    {
+        connection conn;
+        EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+        server.poll(100);
+        EXPECT_TRUE(server.is_connected());
+
+        // the server never answers, the worker stays blocked in recv
+        // until the connection goes away
+        resp = conn.command_async("cmd");
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_THROW(resp.get(), mwr::report);
+}
+
+TEST(connection, disconnect_blocked) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    server.poll(100);
+    EXPECT_TRUE(server.is_connected());
+
+    // the server never answers, disconnecting from another thread must
+    // not wait for the request to finish
+    std::future<void> req = std::async(std::launch::async, [&conn]() {
+        conn.command("cmd");
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    conn.disconnect();
+    EXPECT_THROW(req.get(), std::exception);
+    EXPECT_FALSE(conn.is_connected());
+}
+
+TEST(connection, async_move) {
+    mwr::server_socket server(1, 0);
+    connection conn;
+
+    EXPECT_TRUE(try_connect(conn, server.host(), server.port()));
+    server.poll(100);
+    EXPECT_TRUE(server.is_connected());
+    int client = server.clients()[0];
+
+    std::future<bool> correct = std::async([&server, client]() {
+        for (int i = 0; i < 4; i++) {
+            if (!serve(server, client, mkstr("cmd%d", i), mkstr("OK,%d", i)))
+                return false;
+        }
+
+        return true;
+    });
+
+    vector<std::future<vector<string>>> resps;
+    for (int i = 0; i < 2; i++)
+        resps.push_back(conn.command_async(mkstr("cmd%d", i)));
+
+    connection moved(std::move(conn));
+    for (int i = 2; i < 4; i++)
+        resps.push_back(moved.command_async(mkstr("cmd%d", i)));
+
+    for (int i = 0; i < 4; i++)
+        EXPECT_THAT(resps[i].get(), ElementsAre("OK", to_string(i)));
+
+    correct.wait();
+    EXPECT_TRUE(correct.get());
+}
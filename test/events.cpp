@@ -0,0 +1,221 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+class events_test : public mockvp_test
+{
+protected:
+    std::thread halt_after(u64 ms, const string& reason = "user") {
+        return std::thread([this, ms, reason]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+            server.halt(reason);
+        });
+    }
+};
+
+TEST_F(events_test, already_stopped) {
+    EXPECT_TRUE(sess.wait_for_stop(0));
+    EXPECT_TRUE(sess.wait_for_stop());
+    EXPECT_FALSE(sess.check_running());
+}
+
+TEST_F(events_test, timeout) {
+    sess.run();
+    EXPECT_FALSE(sess.wait_for_stop(20));
+    sess.stop();
+    EXPECT_TRUE(sess.wait_for_stop(1000));
+    EXPECT_EQ(sess.reason().reason, VSP_STOP_REASON_USER);
+}
+
+TEST_F(events_test, halt) {
+    sess.run();
+    std::thread t = halt_after(300, "breakpoint:3:42");
+    size_t before = server.count("status");
+    EXPECT_TRUE(sess.wait_for_stop());
+    size_t polls = server.count("status") - before;
+    t.join();
+
+    EXPECT_EQ(sess.reason().reason, VSP_STOP_REASON_BREAKPOINT);
+    EXPECT_EQ(sess.reason().breakpoint.id, 3);
+    EXPECT_EQ(sess.reason().breakpoint.time, 42);
+
+    // the poller backs off while running instead of spinning on status
+    EXPECT_LT(polls, 300 * 1000 / wait_policy().sleep_max_us + 20);
+}
+
+TEST_F(events_test, unresponsive) {
+    sess.run();
+    server.handle("status", [](const response&) { return string(); });
+
+    // the poller stays blocked in its status request, which must neither
+    // keep the disconnect nor the waiter from returning
+    auto waiter = std::async(std::launch::async, [this]() {
+        return sess.wait_for_stop(20);
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    auto done = std::async(std::launch::async, [this]() {
+        sess.disconnect();
+    });
+
+    ASSERT_EQ(done.wait_for(std::chrono::seconds(5)),
+              std::future_status::ready);
+    EXPECT_FALSE(sess.is_connected());
+    EXPECT_THROW(waiter.get(), mwr::report);
+}
+
+TEST_F(events_test, blocking_step) {
+    std::thread t = halt_after(50);
+    sess.step(1000, true);
+    t.join();
+    EXPECT_FALSE(sess.check_running());
+}
+
+TEST_F(events_test, instant_step) {
+    server.set_instant_runs(true);
+    u64 time = sess.get_time_ns();
+    sess.step(1000, true);
+    EXPECT_FALSE(sess.check_running());
+    EXPECT_EQ(sess.get_time_ns(), time + 1000);
+    EXPECT_EQ(sess.reason().reason, VSP_STOP_REASON_STEP_COMPLETE);
+}
+
+TEST_F(events_test, shared_poller) {
+    sess.run();
+
+    std::atomic<size_t> woken = 0;
+    vector<std::thread> waiters;
+    for (int i = 0; i < 4; i++) {
+        waiters.emplace_back([this, &woken]() {
+            if (sess.wait_for_stop(5000))
+                woken++;
+        });
+    }
+
+    std::thread t = halt_after(100);
+    for (auto& w : waiters)
+        w.join();
+    t.join();
+
+    EXPECT_EQ(woken, 4);
+}
+
+TEST_F(events_test, disconnect) {
+    sess.run();
+    std::thread t([this]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        sess.disconnect();
+    });
+
+    EXPECT_THROW(sess.wait_for_stop(), mwr::report);
+    t.join();
+}
+
+TEST_F(events_test, round_trips) {
+    auto now = std::chrono::steady_clock::now;
+    auto ms = [](u64 n) { return std::chrono::milliseconds(n); };
+
+    sess.run();
+    wait_result res = sess.wait_until_stopped(now() + ms(20));
+    EXPECT_FALSE(res.stopped);
+    EXPECT_GT(res.round_trips, 0);
+
+    wait_policy lazy;
+    lazy.spin_polls = lazy.yield_polls = 0;
+    lazy.sleep_min_us = lazy.sleep_max_us = 50000;
+    res = sess.wait_until_stopped(now() + ms(120), lazy);
+    EXPECT_FALSE(res.stopped);
+    EXPECT_LE(res.round_trips, 4);
+
+    sess.stop();
+    res = sess.wait_until_stopped(now() + ms(1000));
+    EXPECT_TRUE(res.stopped);
+    EXPECT_GE(res.round_trips, 1);
+    EXPECT_EQ(sess.reason().reason, VSP_STOP_REASON_USER);
+}
+
+TEST_F(events_test, epoch) {
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+    targ->enable_cache();
+
+    u8 val;
+    bool binary = server.has_capability(VSP_CAP_BINARY_MEMORY);
+    const char* cmd = binary ? "bpread" : "pread";
+    sess.run();
+    targ->read_pmem(0x100, &val, 1);
+    targ->read_pmem(0x100, &val, 1);
+    EXPECT_EQ(server.count(cmd), 1);
+
+    // data read while running is stale once the poller sees the stop
+    std::thread t = halt_after(50);
+    EXPECT_TRUE(sess.wait_for_stop());
+    t.join();
+    targ->read_pmem(0x100, &val, 1);
+    EXPECT_EQ(server.count(cmd), 2);
+
+    // stopping a stopped simulation changes nothing
+    sess.stop();
+    targ->read_pmem(0x100, &val, 1);
+    EXPECT_EQ(server.count(cmd), 2);
+}
+
+TEST_F(events_test, target_step_while_running) {
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+
+    sess.run();
+    std::thread t = halt_after(50);
+    const stop_reason& reason = targ->step(3);
+    t.join();
+
+    // the rejected step is retried once the simulation stopped
+    EXPECT_EQ(reason.reason, VSP_STOP_REASON_TARGET_STEP_COMPLETE);
+    EXPECT_EQ(server.count("step"), 2);
+}
+
+TEST_F(events_test, counted_step) {
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+
+    server.set_async_steps(true);
+    u64 cycle = sess.get_cycle_count();
+    const stop_reason& reason = targ->step(10000);
+    EXPECT_EQ(reason.reason, VSP_STOP_REASON_TARGET_STEP_COMPLETE);
+    EXPECT_EQ(reason.target_step_complete.tgt, targ);
+    EXPECT_EQ(sess.get_cycle_count(), cycle + 10000);
+    EXPECT_EQ(server.count("step"), 1);
+}
+
+TEST(events, single_steps) {
+    mockvp server(VSP_CAP_BINARY_MEMORY);
+    session sess(server.host(), server.port());
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+
+    // like a real simulation, every step keeps running for a while and
+    // further steps get rejected until then
+    server.set_async_steps(true);
+    size_t polls = server.count("status");
+    u64 cycle = sess.get_cycle_count();
+    const stop_reason& reason = targ->step(100);
+    EXPECT_EQ(reason.reason, VSP_STOP_REASON_TARGET_STEP_COMPLETE);
+    EXPECT_EQ(sess.get_cycle_count(), cycle + 100);
+
+    // each step waits for the one before, so none is ever rejected
+    EXPECT_EQ(server.count("step"), 100);
+    EXPECT_GE(server.count("status") - polls, 2 * 100);
+
+    sess.disconnect();
+}
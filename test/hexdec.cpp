@@ -0,0 +1,114 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+
+using namespace testing;
+using namespace vsp;
+
+static string encode(const vector<u8>& data) {
+    string s;
+    for (size_t i = 0; i < data.size(); i++)
+        s += mkstr(i ? ",%02x" : "%02x", data[i]);
+    return s;
+}
+
+static vector<u8> pattern(size_t size) {
+    vector<u8> data(size);
+    for (size_t i = 0; i < size; i++)
+        data[i] = (u8)(i * 37 + 11);
+    return data;
+}
+
+static const hex_decoder DECODERS[] = {
+    HEX_DECODER_AUTO,
+    HEX_DECODER_SCALAR,
+    HEX_DECODER_SSE2,
+    HEX_DECODER_AVX2,
+};
+
+TEST(hexdec, sizes) {
+    for (hex_decoder impl : DECODERS) {
+        if (!hex_decoder_supported(impl))
+            continue;
+
+        for (size_t size = 0; size < 300; size++) {
+            vector<u8> data = pattern(size);
+            vector<u8> out(size, 0xee);
+            EXPECT_TRUE(decode_hex(encode(data), out.data(), size, impl))
+                << "decoder " << impl << " size " << size;
+            EXPECT_EQ(out, data) << "decoder " << impl << " size " << size;
+        }
+    }
+}
+
+TEST(hexdec, digits) {
+    string s = "0,1,aB,Cd,ef,F,00,ff";
+    vector<u8> expect{ 0x0, 0x1, 0xab, 0xcd, 0xef, 0xf, 0x00, 0xff };
+
+    // pad past the vector block sizes so that every kernel sees the
+    // single digit fields and has to fall back to the scalar path
+    vector<u8> tail = pattern(100);
+    s += "," + encode(tail);
+    expect.insert(expect.end(), tail.begin(), tail.end());
+
+    for (hex_decoder impl : DECODERS) {
+        if (!hex_decoder_supported(impl))
+            continue;
+
+        vector<u8> out(expect.size());
+        EXPECT_TRUE(decode_hex(s, out.data(), out.size(), impl));
+        EXPECT_EQ(out, expect) << "decoder " << impl;
+    }
+}
+
+TEST(hexdec, malformed) {
+    string good = encode(pattern(128));
+
+    for (hex_decoder impl : DECODERS) {
+        if (!hex_decoder_supported(impl))
+            continue;
+
+        vector<u8> out(129);
+        EXPECT_FALSE(decode_hex(good, out.data(), 127, impl));
+        EXPECT_FALSE(decode_hex(good, out.data(), 129, impl));
+        EXPECT_FALSE(decode_hex(good.substr(0, good.size() - 3), out.data(),
+                                128, impl));
+        EXPECT_FALSE(decode_hex("", out.data(), 1, impl));
+        EXPECT_FALSE(decode_hex("12,", out.data(), 1, impl));
+        EXPECT_FALSE(decode_hex("123", out.data(), 1, impl));
+        EXPECT_FALSE(decode_hex("1,,2", out.data(), 2, impl));
+        EXPECT_TRUE(decode_hex("", out.data(), 0, impl));
+
+        for (size_t pos : { 0, 1, 2, 50, 100, 200, 382 }) {
+            for (char c : { 'g', 'x', ' ', ':', '/', '@', 'G', '`' }) {
+                string bad = good;
+                if (bad[pos] == ',')
+                    continue;
+                bad[pos] = c;
+                EXPECT_FALSE(decode_hex(bad, out.data(), 128, impl))
+                    << "decoder " << impl << " char " << c << " at " << pos;
+            }
+
+            string bad = good;
+            bad[pos] = bad[pos] == ',' ? ';' : ',';
+            EXPECT_FALSE(decode_hex(bad, out.data(), 128, impl))
+                << "decoder " << impl << " separator at " << pos;
+        }
+    }
+}
+
+TEST(hexdec, supported) {
+    EXPECT_TRUE(hex_decoder_supported(HEX_DECODER_AUTO));
+    EXPECT_TRUE(hex_decoder_supported(HEX_DECODER_SCALAR));
+    EXPECT_FALSE(hex_decoder_supported((hex_decoder)42));
+
+    u8 out;
+    EXPECT_THROW(decode_hex("00", &out, 1, (hex_decoder)42), mwr::report);
+}
@@ -0,0 +1,504 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+class hierarchy_test : public mockvp_test
+{
+protected:
+    hierarchy_test(): mockvp_test(mockvp::DEFAULT_CAPS, false) {}
+
+    void connect(const string& xml) {
+        server.handle("list", [xml](const response&) { return "OK," + xml; });
+        sess.connect(server.host(), server.port());
+    }
+};
+
+TEST_F(hierarchy_test, find) {
+    connect(make_test_hierarchy(8, 8));
+
+    module* root = sess.find_module();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->parent(), nullptr);
+    EXPECT_EQ(sess.find_module(""), root);
+
+    module* cpu = sess.find_module("system.cluster3.cpu5");
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_STREQ(cpu->name(), "cpu5");
+    EXPECT_STREQ(cpu->kind(), "cpu");
+    EXPECT_EQ(cpu->hierarchy_name(), "system.cluster3.cpu5");
+    EXPECT_EQ(root->find_module("system.cluster3.cpu5"), cpu);
+
+    attribute* attr = sess.find_attribute("system.cluster3.cpu5.freq");
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->parent(), cpu);
+    EXPECT_EQ(attr->type(), "u64");
+    EXPECT_EQ(cpu->find_attribute("freq"), attr);
+
+    command* cmd = sess.find_command("system.cluster7.cpu0.reset");
+    ASSERT_NE(cmd, nullptr);
+    EXPECT_STREQ(cmd->desc(), "resets");
+    EXPECT_EQ(cmd->parent(), sess.find_module("system.cluster7.cpu0"));
+
+    attr = sess.find_attribute("version");
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->parent(), root);
+
+    EXPECT_EQ(sess.find_module("system.cluster8"), nullptr);
+    EXPECT_EQ(sess.find_module("system.cluster3.cpu5.freq"), nullptr);
+    EXPECT_EQ(sess.find_module("cluster3.cpu5"), nullptr);
+    EXPECT_EQ(sess.find_attribute("system.cluster3.cpu5"), nullptr);
+    EXPECT_EQ(sess.find_attribute("system.cluster3.cpu5.reset"), nullptr);
+    EXPECT_EQ(sess.find_command("system.cluster3.cpu5.freq"), nullptr);
+
+    // string_view keys need not be terminated
+    string_view name("system.cluster1.cpu1.arch.tail", 25);
+    EXPECT_EQ(sess.find_attribute(name),
+              sess.find_attribute("system.cluster1.cpu1.arch"));
+}
+
+TEST_F(hierarchy_test, every_element) {
+    connect(make_test_hierarchy(6, 6));
+
+    size_t mods = 0, attrs = 0, cmds = 0;
+    function<void(module*)> check = [&](module* mod) {
+        EXPECT_EQ(sess.find_module(mod->hierarchy_name()), mod);
+        mods++;
+        for (attribute* attr : mod->attributes()) {
+            EXPECT_EQ(sess.find_attribute(attr->hierarchy_name()), attr);
+            attrs++;
+        }
+        for (command* cmd : mod->commands()) {
+            string name = mod->hierarchy_name() + "." + cmd->name();
+            EXPECT_EQ(sess.find_command(name), cmd);
+            cmds++;
+        }
+        for (module* child : mod->children())
+            check(child);
+    };
+
+    check(sess.find_module());
+    EXPECT_EQ(mods, 1 + 1 + 6 + 36);
+    EXPECT_EQ(attrs, 1 + 2 * 36);
+    EXPECT_EQ(cmds, 36);
+}
+
+TEST_F(hierarchy_test, duplicates) {
+    connect("<hierarchy><object name=\"a\" kind=\"first\" />"
+            "<object name=\"a\" kind=\"second\" /></hierarchy>");
+
+    module* a = sess.find_module("a");
+    ASSERT_NE(a, nullptr);
+    EXPECT_STREQ(a->kind(), "first");
+}
+
+TEST_F(hierarchy_test, disconnect) {
+    connect(make_test_hierarchy(2, 2));
+    EXPECT_NE(sess.find_module("system.cluster1"), nullptr);
+
+    sess.disconnect();
+    EXPECT_EQ(sess.find_module(), nullptr);
+    EXPECT_EQ(sess.find_module("system.cluster1"), nullptr);
+    EXPECT_EQ(sess.find_attribute("version"), nullptr);
+}
+
+TEST_F(hierarchy_test, layout) {
+    connect(make_test_hierarchy(4, 4));
+
+    const hierarchy& hier = sess.modules_hierarchy();
+    EXPECT_EQ(hier.num_modules(), 1 + 1 + 4 + 16);
+    EXPECT_EQ(hier.num_attributes(), 1 + 2 * 16);
+    EXPECT_EQ(hier.num_commands(), 16);
+
+    // repeated names and kinds are stored only once
+    module* a = sess.find_module("system.cluster0.cpu0");
+    module* b = sess.find_module("system.cluster3.cpu2");
+    ASSERT_NE(a, nullptr);
+    ASSERT_NE(b, nullptr);
+    EXPECT_EQ(a->kind(), b->kind());
+    EXPECT_EQ(a->attributes()[1]->name(), b->attributes()[1]->name());
+    EXPECT_EQ(a->attributes()[1]->type().data(),
+              b->attributes()[1]->type().data());
+
+    // children keep the order in which they were listed
+    module* cluster = sess.find_module("system.cluster2");
+    ASSERT_NE(cluster, nullptr);
+    ASSERT_EQ(cluster->children().size(), 4);
+    for (size_t i = 0; i < 4; i++) {
+        EXPECT_EQ(cluster->children()[i]->name(), mkstr("cpu%zu", i));
+        EXPECT_EQ(cluster->children()[i]->parent(), cluster);
+    }
+
+    ASSERT_EQ(sess.modules().size(), 1);
+    EXPECT_STREQ(sess.modules()[0]->name(), "system");
+    const vector<module*>& mods = sess.modules();
+    EXPECT_EQ(mods, vector<module*>{ sess.find_module("system") });
+}
+
+TEST(hierarchy, strings) {
+    string_pool pool;
+    const char* a = pool.intern("cpu");
+    EXPECT_STREQ(a, "cpu");
+    EXPECT_EQ(pool.intern(string("cpu")), a);
+    EXPECT_EQ(pool.intern(string_view("cpu0", 3)), a);
+    EXPECT_NE(pool.intern("cpu0"), a);
+    EXPECT_EQ(pool.size(), 2);
+
+    string big(string_pool::BLOCK_SIZE, 'x');
+    const char* c = pool.intern(big);
+    EXPECT_EQ(c, big);
+    EXPECT_EQ(pool.intern("cpu"), a);
+    EXPECT_STREQ(pool.intern("gpu"), "gpu");
+
+    pool.clear();
+    EXPECT_EQ(pool.size(), 0);
+    EXPECT_EQ(pool.bytes(), 0);
+}
+
+TEST(hierarchy, build) {
+    connection conn;
+    hierarchy hier(conn);
+    hier.begin_module("", "", "");
+    hier.begin_module("sys", "soc", "1.0");
+    hier.add_attribute("clock", "u64", 1);
+    hier.begin_module("cpu", "cpu", "");
+    hier.add_command("reset", 0, "resets the core");
+    hier.end_module();
+    hier.begin_module("mem", "memory", "");
+    hier.end_module();
+    hier.add_command("dump", 1, "");
+    hier.end_module();
+    hier.end_module();
+    EXPECT_EQ(hier.root(), nullptr);
+    hier.finish();
+
+    module* root = hier.root();
+    ASSERT_NE(root, nullptr);
+    EXPECT_EQ(root->parent(), nullptr);
+    EXPECT_EQ(hier.num_modules(), 4);
+    EXPECT_EQ(hier.num_attributes(), 1);
+    EXPECT_EQ(hier.num_commands(), 2);
+
+    module* sys = hier.index().find_module("sys");
+    ASSERT_NE(sys, nullptr);
+    EXPECT_STREQ(sys->version(), "1.0");
+    ASSERT_EQ(sys->children().size(), 2);
+    EXPECT_STREQ(sys->children()[0]->name(), "cpu");
+    EXPECT_STREQ(sys->children()[1]->name(), "mem");
+    ASSERT_EQ(sys->commands().size(), 1);
+    EXPECT_STREQ(sys->commands()[0]->name(), "dump");
+    EXPECT_EQ(hier.index().find_command("sys.cpu.reset")->parent(),
+              sys->children()[0]);
+
+    hier.clear();
+    EXPECT_EQ(hier.root(), nullptr);
+    EXPECT_EQ(hier.num_modules(), 0);
+    EXPECT_EQ(hier.index().find_module("sys"), nullptr);
+}
+
+TEST_F(hierarchy_test, escapes) {
+    connect("<?xml version=\"1.0\"?><hierarchy><!-- listing -->"
+            "<object name=\"a\" kind=\"&lt;k&gt;\">"
+            "<command name=\"c\" argc=\"2\" desc=\"x\\, y &amp; z\" />"
+            "<unknown><object name=\"hidden\" /></unknown>"
+            "</object></hierarchy>");
+
+    module* a = sess.find_module("a");
+    ASSERT_NE(a, nullptr);
+    EXPECT_STREQ(a->kind(), "<k>");
+    EXPECT_EQ(a->children().size(), 0);
+
+    command* c = sess.find_command("a.c");
+    ASSERT_NE(c, nullptr);
+    EXPECT_EQ(c->argc(), 2);
+    EXPECT_STREQ(c->desc(), "x, y & z");
+}
+
+TEST_F(hierarchy_test, truncated) {
+    EXPECT_THROW(connect("<hierarchy><object name=\"a\">"), mwr::report);
+    EXPECT_EQ(sess.find_module(), nullptr);
+    EXPECT_EQ(sess.find_module("a"), nullptr);
+}
+
+TEST(hierarchy, get_all) {
+    mockvp a, b;
+    session sa(a.host(), a.port());
+    session sb(b.host(), b.port());
+    attribute* arch_a = sa.find_attribute("system.cpu.arch");
+    attribute* arch_b = sb.find_attribute("system.cpu.arch");
+    ASSERT_NE(arch_a, nullptr);
+    ASSERT_NE(arch_b, nullptr);
+
+    auto values = attribute::get_all({ arch_a, arch_a });
+    ASSERT_EQ(values.size(), 2);
+    EXPECT_EQ(values[0], values[1]);
+
+    EXPECT_THROW(attribute::get_all({ arch_a, arch_b }), mwr::report);
+    sa.disconnect();
+    sb.disconnect();
+}
+
+struct tree_node {
+    string name;
+    string leaves;
+    vector<tree_node> children;
+};
+
+// the hierarchy of make_test_hierarchy(n, n) as a tree that can be listed
+// in parts
+static tree_node make_tree(size_t n) {
+    tree_node root{ "", "<attribute name=\"version\" type=\"string\" "
+                        "count=\"1\" />", {} };
+    tree_node system{ "system", "", {} };
+    for (size_t i = 0; i < n; i++) {
+        tree_node cluster{ mkstr("cluster%zu", i), "", {} };
+        for (size_t j = 0; j < n; j++) {
+            cluster.children.push_back(
+                { mkstr("cpu%zu", j),
+                  "<attribute name=\"arch\" type=\"string\" count=\"1\" />"
+                  "<attribute name=\"freq\" type=\"u64\" count=\"1\" />"
+                  "<command name=\"reset\" argc=\"0\" desc=\"resets\" />",
+                  {} });
+        }
+        system.children.push_back(std::move(cluster));
+    }
+
+    root.children.push_back(std::move(system));
+    return root;
+}
+
+static void list_tree(string& xml, const tree_node& node, size_t depth) {
+    xml += mkstr("<object name=\"%s\" kind=\"node\"", node.name.c_str());
+    if (depth == 0 && (!node.leaves.empty() || !node.children.empty())) {
+        xml += " truncated=\"true\" />";
+        return;
+    }
+
+    xml += ">" + node.leaves;
+    for (const tree_node& child : node.children)
+        list_tree(xml, child, depth - 1);
+    xml += "</object>";
+}
+
+// answers list requests like a server with subtree listings, which takes
+// the module to list and the number of levels below it as arguments
+static string list_request(const tree_node& root, const response& req) {
+    string path = req.size() > 2 ? string(req[2]) : "";
+    size_t depth = req.size() > 3 ? req.to_u64(3) : ~(size_t)0;
+
+    const tree_node* node = &root;
+    if (!path.empty()) {
+        for (const string& name : split(path, '.')) {
+            auto it = std::find_if(node->children.begin(),
+                                   node->children.end(),
+                                   [&name](const tree_node& child) {
+                                       return child.name == name;
+                                   });
+            MWR_REPORT_ON(it == node->children.end(), "unknown module");
+            node = &*it;
+        }
+    }
+
+    string xml = "OK,<hierarchy>";
+    if (node == &root) {
+        xml += root.leaves;
+        for (const tree_node& child : root.children)
+            list_tree(xml, child, depth - 1);
+        xml += mkstr("<target arch=\"arm\">%s</target>", mockvp::TARGET);
+    } else {
+        list_tree(xml, *node, depth);
+    }
+
+    return xml + "</hierarchy>";
+}
+
+TEST(hierarchy, lazy) {
+    mockvp server(mockvp::DEFAULT_CAPS | VSP_CAP_SUBTREE_LIST);
+    tree_node tree = make_tree(8);
+    vector<string> requests;
+    server.handle("list", [&](const response& req) {
+        requests.push_back(req.size() > 2 ? string(req[2]) : "-");
+        return list_request(tree, req);
+    });
+
+    session sess;
+    sess.set_lazy(true);
+    sess.connect(server.host(), server.port());
+    ASSERT_EQ(requests.size(), 1);
+    EXPECT_EQ(requests[0], "");
+
+    // only the root and the two levels below it have been listed
+    const hierarchy& hier = sess.modules_hierarchy();
+    EXPECT_EQ(hier.num_modules(), 1 + 1 + 8);
+    EXPECT_EQ(hier.num_unloaded(), 8);
+    EXPECT_EQ(sess.targets().size(), 1);
+    EXPECT_NE(sess.find_attribute("version"), nullptr);
+    module* cluster = hier.index().find_module("system.cluster3");
+    ASSERT_NE(cluster, nullptr);
+    EXPECT_FALSE(cluster->is_loaded());
+    EXPECT_TRUE(sess.find_module("system")->is_loaded());
+
+    attribute* attr = sess.find_attribute("system.cluster3.cpu5.freq");
+    ASSERT_NE(attr, nullptr);
+    EXPECT_EQ(attr->hierarchy_name(), "system.cluster3.cpu5.freq");
+    EXPECT_EQ(attr->parent()->parent(), cluster);
+    EXPECT_TRUE(cluster->is_loaded());
+    ASSERT_EQ(requests.size(), 2);
+    EXPECT_EQ(requests[1], "system.cluster3");
+
+    // the index knows the new modules now, others are not asked for
+    EXPECT_EQ(hier.index().find_attribute("system.cluster3.cpu5.freq"), attr);
+    EXPECT_EQ(sess.find_command("system.cluster3.cpu0.reset")->parent(),
+              sess.find_module("system.cluster3.cpu0"));
+    EXPECT_EQ(sess.find_module("system.cluster8"), nullptr);
+    EXPECT_EQ(sess.find_module("system.cluster3.cpu8"), nullptr);
+    EXPECT_EQ(requests.size(), 2);
+    EXPECT_FALSE(hier.index().find_module("system.cluster2")->is_loaded());
+
+    // walking the hierarchy lists everything that is still missing
+    size_t mods = 0;
+    function<void(const module*)> walk = [&](const module* mod) {
+        mods++;
+        for (const module* child : mod->children()) {
+            EXPECT_EQ(child->parent(), mod);
+            walk(child);
+        }
+    };
+
+    walk(sess.find_module());
+    EXPECT_EQ(mods, 1 + 1 + 8 + 64);
+    EXPECT_EQ(hier.num_modules(), mods);
+    EXPECT_EQ(hier.num_unloaded(), 0);
+    EXPECT_EQ(requests.size(), 2 + 7);
+    EXPECT_NE(hier.index().find_module("system.cluster7.cpu7"), nullptr);
+
+    // the index stores every path once, no matter how it was listed
+    size_t size = hier.index().size();
+    size_t bytes = hier.index().bytes();
+    sess.disconnect();
+
+    session full;
+    full.connect(server.host(), server.port());
+    EXPECT_EQ(full.modules_hierarchy().num_unloaded(), 0);
+    EXPECT_EQ(full.modules_hierarchy().index().size(), size);
+    EXPECT_EQ(full.modules_hierarchy().index().bytes(), bytes);
+    full.disconnect();
+}
+
+TEST(hierarchy, lazy_threads) {
+    mockvp server(mockvp::DEFAULT_CAPS | VSP_CAP_SUBTREE_LIST);
+    tree_node tree = make_tree(8);
+    std::atomic<size_t> lists(0);
+    server.handle("list", [&](const response& req) {
+        lists++;
+        return list_request(tree, req);
+    });
+
+    session sess;
+    sess.set_lazy(true);
+    sess.connect(server.host(), server.port());
+
+    // threads that use the same modules first wait for one listing each
+    vector<std::future<size_t>> found;
+    for (int t = 0; t < 4; t++) {
+        found.push_back(std::async(std::launch::async, [&sess]() {
+            size_t n = 0;
+            for (size_t i = 0; i < 8; i++) {
+                for (size_t j = 0; j < 8; j++) {
+                    string name = mkstr("system.cluster%zu.cpu%zu.freq", i, j);
+                    attribute* attr = sess.find_attribute(name);
+                    n += attr && attr->hierarchy_name() == name ? 1 : 0;
+                }
+            }
+
+            return n;
+        }));
+    }
+
+    for (auto& f : found)
+        EXPECT_EQ(f.get(), 64);
+
+    EXPECT_EQ(lists, 1 + 8);
+    EXPECT_EQ(sess.modules_hierarchy().num_unloaded(), 0);
+    sess.disconnect();
+}
+
+TEST(hierarchy, lazy_errors) {
+    mockvp server(mockvp::DEFAULT_CAPS | VSP_CAP_SUBTREE_LIST);
+    tree_node tree = make_tree(2);
+    bool broken = false;
+    server.handle("list", [&](const response& req) {
+        MWR_REPORT_ON(broken, "listing failed");
+        return list_request(tree, req);
+    });
+
+    session sess;
+    sess.set_lazy(true);
+    sess.connect(server.host(), server.port());
+    module* cluster = sess.find_module("system.cluster1");
+    ASSERT_NE(cluster, nullptr);
+
+    // failed listings leave the module to be listed again next time
+    broken = true;
+    EXPECT_THROW(sess.find_module("system.cluster1.cpu0"), mwr::report);
+    EXPECT_FALSE(cluster->is_loaded());
+    EXPECT_TRUE(sess.is_connected());
+
+    broken = false;
+    EXPECT_NE(sess.find_module("system.cluster1.cpu0"), nullptr);
+    EXPECT_EQ(cluster->children().size(), 2);
+
+    sess.disconnect();
+}
+
+TEST(hierarchy, lazy_background) {
+    mockvp server;
+    string xml = make_test_hierarchy(4, 4);
+    promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    vector<size_t> args;
+    server.handle("list", [&](const response& req) {
+        args.push_back(req.size());
+        released.wait();
+        return "OK," + xml;
+    });
+
+    // older servers send the whole listing, the session receives it while
+    // the connect call has already returned
+    session sess;
+    sess.set_lazy(true);
+    sess.connect(server.host(), server.port());
+    EXPECT_TRUE(sess.is_connected());
+    release.set_value();
+
+    module* cpu = sess.find_module("system.cluster3.cpu2");
+    ASSERT_NE(cpu, nullptr);
+    EXPECT_TRUE(cpu->is_loaded());
+    EXPECT_EQ(sess.modules_hierarchy().num_modules(), 1 + 1 + 4 + 16);
+    EXPECT_EQ(sess.modules_hierarchy().num_unloaded(), 0);
+    ASSERT_EQ(args.size(), 1);
+    EXPECT_EQ(args[0], 2);
+
+    // errors are reported to everything that needs the modules
+    server.handle("list", [](const response&) -> string {
+        MWR_REPORT("listing failed");
+    });
+
+    sess.connect(server.host(), server.port());
+    EXPECT_THROW(sess.find_module("system"), mwr::report);
+    EXPECT_THROW(sess.targets(), mwr::report);
+    sess.disconnect();
+    EXPECT_EQ(sess.find_module(), nullptr);
+}
@@ -0,0 +1,562 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+class memory_test : public mockvp_test, public WithParamInterface<u32>
+{
+protected:
+    target* targ;
+
+    memory_test(): mockvp_test(GetParam()), targ() {}
+
+    virtual void SetUp() override {
+        targ = sess.find_target(mockvp::TARGET);
+        ASSERT_NE(targ, nullptr);
+    }
+
+    bool binary() const { return GetParam() & VSP_CAP_BINARY_MEMORY; }
+
+    static vector<u8> pattern(size_t size) {
+        vector<u8> data(size);
+        for (size_t i = 0; i < size; i++)
+            data[i] = (u8)(i * 7 + (i >> 8));
+        return data;
+    }
+};
+
+TEST_P(memory_test, negotiate) {
+    EXPECT_EQ(sess.proto_version(), VSP_V2);
+    EXPECT_EQ(sess.capabilities(), GetParam());
+    EXPECT_STREQ(targ->arch(), "mock");
+}
+
+TEST_P(memory_test, pmem) {
+    // covers every byte value, including the framing characters
+    vector<u8> data = pattern(4096);
+    EXPECT_EQ(targ->write_pmem(0x100, data), data.size());
+    EXPECT_EQ(memcmp(server.memory() + 0x100, data.data(), data.size()), 0);
+    EXPECT_EQ(targ->read_pmem(0x100, data.size()), data);
+    EXPECT_EQ(targ->read_pmem(0x100, 0), vector<u8>());
+
+    // empty transfers never go out on the wire
+    EXPECT_EQ(server.count("bpread"), binary() ? 1 : 0);
+    EXPECT_EQ(server.count("bpwrite"), binary() ? 1 : 0);
+    EXPECT_EQ(server.count("pread"), binary() ? 0 : 1);
+    EXPECT_EQ(server.count("pwrite"), binary() ? 0 : 1);
+}
+
+TEST_P(memory_test, vmem) {
+    vector<u8> data = pattern(1000);
+    EXPECT_EQ(targ->write_vmem(0x2000, data), data.size());
+    EXPECT_EQ(memcmp(server.memory() + 0x2000, data.data(), data.size()), 0);
+    EXPECT_EQ(targ->read_vmem(0x2000, data.size()), data);
+
+    EXPECT_EQ(server.count("bvread"), binary() ? 1 : 0);
+    EXPECT_EQ(server.count("vread"), binary() ? 0 : 1);
+}
+
+TEST_P(memory_test, out_of_range) {
+    EXPECT_THROW(targ->read_pmem(mockvp::MEMSIZE - 4, 8), mwr::report);
+    EXPECT_THROW(targ->write_vmem(mockvp::MEMSIZE, { 1, 2 }), mwr::report);
+    EXPECT_TRUE(sess.is_connected());
+    EXPECT_EQ(targ->read_pmem(mockvp::MEMSIZE - 4, 4).size(), 4);
+}
+
+TEST_P(memory_test, wire_bytes) {
+    vector<u8> data = pattern(64 * 1024);
+    size_t rx = server.rx_bytes();
+    size_t tx = server.tx_bytes();
+
+    targ->write_pmem(0, data);
+    targ->read_pmem(0, data.size());
+
+    rx = server.rx_bytes() - rx;
+    tx = server.tx_bytes() - tx;
+    if (binary()) {
+        EXPECT_LT(rx, data.size() * 11 / 10);
+        EXPECT_LT(tx, data.size() * 11 / 10);
+    } else {
+        EXPECT_GT(rx, data.size() * 3);
+        EXPECT_GT(tx, data.size() * 3);
+    }
+}
+
+TEST_P(memory_test, chunked) {
+    vector<u8> data = pattern(100000);
+    vector<u8> buf(data.size());
+
+    targ->set_chunk_size(1000);
+    targ->set_transfer_depth(4);
+    EXPECT_EQ(targ->write_pmem(0x10, data.data(), data.size()), data.size());
+    EXPECT_EQ(targ->read_pmem(0x10, buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf, data);
+
+    EXPECT_EQ(server.count(binary() ? "bpwrite" : "pwrite"), 100);
+    EXPECT_EQ(server.count(binary() ? "bpread" : "pread"), 100);
+
+    std::fill(buf.begin(), buf.end(), 0);
+    targ->set_chunk_size(target::DEFAULT_CHUNK_SIZE);
+    EXPECT_EQ(targ->read_vmem(0x10, buf.data(), 12345), 12345);
+    EXPECT_TRUE(std::equal(buf.begin(), buf.begin() + 12345, data.begin()));
+    EXPECT_EQ(targ->read_vmem(0x10, buf.data(), 0), 0);
+
+    EXPECT_THROW(targ->set_chunk_size(0), mwr::report);
+    EXPECT_THROW(targ->set_transfer_depth(0), mwr::report);
+    EXPECT_EQ(targ->chunk_size(), target::DEFAULT_CHUNK_SIZE);
+}
+
+TEST_P(memory_test, partial) {
+    // the third chunk crosses the end of memory
+    const u64 addr = mockvp::MEMSIZE - 10000;
+    vector<u8> data = pattern(20000);
+    vector<u8> buf(data.size());
+
+    targ->set_chunk_size(4096);
+    EXPECT_EQ(targ->write_pmem(addr, data.data(), data.size()), 8192);
+    EXPECT_EQ(targ->read_pmem(addr, buf.data(), buf.size()), 8192);
+    EXPECT_TRUE(std::equal(buf.begin(), buf.begin() + 8192, data.begin()));
+    EXPECT_EQ(targ->read_pmem(mockvp::MEMSIZE, buf.data(), 1), 0);
+
+    EXPECT_THROW(targ->read_pmem(addr, data.size()), mwr::report);
+    EXPECT_THROW(targ->write_pmem(addr, data), mwr::report);
+    EXPECT_TRUE(sess.is_connected());
+}
+
+TEST_P(memory_test, cache) {
+    const char* pread = binary() ? "bpread" : "pread";
+    const char* vread = binary() ? "bvread" : "vread";
+    u8* mem = server.memory();
+    vector<u8> buf(0x20);
+
+    EXPECT_THROW(targ->enable_cache(0), mwr::report);
+    EXPECT_THROW(targ->enable_cache(0x1800), mwr::report);
+    targ->enable_cache(0x1000);
+    mem[0x1ff0] = 0x11;
+    mem[0x2000] = 0x22;
+
+    // spans two pages, both fetched with one transfer
+    EXPECT_EQ(targ->read_pmem(0x1ff0, buf.data(), buf.size()), buf.size());
+    EXPECT_EQ(buf[0], 0x11);
+    EXPECT_EQ(buf[0x10], 0x22);
+    EXPECT_EQ(targ->cache_misses(), 2);
+    EXPECT_EQ(targ->cache_hits(), 0);
+    EXPECT_EQ(server.count(pread), 1);
+
+    mem[0x1ff0] = 0x33;
+    EXPECT_EQ(targ->read_pmem(0x1ff0, 1)[0], 0x11);
+    EXPECT_EQ(targ->read_pmem(0x2000, 1)[0], 0x22);
+    EXPECT_EQ(targ->cache_hits(), 2);
+    EXPECT_EQ(server.count(pread), 1);
+
+    // virtual pages are cached separately
+    EXPECT_EQ(targ->read_vmem(0x1ff0, 1)[0], 0x33);
+    EXPECT_EQ(server.count(vread), 1);
+
+    targ->step();
+    EXPECT_EQ(targ->read_pmem(0x1ff0, 1)[0], 0x33);
+    EXPECT_EQ(server.count(pread), 2);
+
+    mem[0x1ff0] = 0x44;
+    sess.run();
+    sess.stop();
+    EXPECT_EQ(targ->read_pmem(0x1ff0, 1)[0], 0x44);
+    EXPECT_EQ(server.count(pread), 3);
+
+    mem[0x1ff0] = 0x55;
+    targ->write_pmem(0x3000, { 1 });
+    EXPECT_EQ(targ->read_pmem(0x1ff0, 1)[0], 0x55);
+    EXPECT_EQ(server.count(pread), 4);
+
+    targ->disable_cache();
+    EXPECT_EQ(targ->read_pmem(0x1ff0, 1)[0], 0x55);
+    EXPECT_EQ(server.count(pread), 5);
+}
+
+TEST_P(memory_test, cache_fallback) {
+    // pages larger than memory cannot be cached, reads must still work
+    targ->enable_cache(2 * mockvp::MEMSIZE);
+    server.memory()[0x10] = 0x66;
+    EXPECT_EQ(targ->read_pmem(0x10, 1)[0], 0x66);
+    EXPECT_EQ(targ->cache_misses(), 0);
+
+    vector<u8> buf(16);
+    EXPECT_EQ(targ->read_pmem(mockvp::MEMSIZE - 8, buf.data(), 16), 0);
+}
+
+TEST_P(memory_test, registers) {
+    cpureg* pc = targ->find_reg("pc");
+    ASSERT_NE(pc, nullptr);
+    EXPECT_EQ(pc->size(), 8);
+
+    pc->set_value({ 0x10, 0x32, 0x54, 0x76, 0x98, 0xba, 0xdc, 0xfe });
+    EXPECT_EQ(targ->get_pc(), 0xfedcba9876543210ull);
+}
+
+TEST_P(memory_test, read_all_regs) {
+    cpureg* sp = targ->find_reg("sp");
+    ASSERT_NE(sp, nullptr);
+    sp->set_value({ 1, 2, 3, 4, 5, 6, 7, 8 });
+
+    const reg_snapshot& regs = targ->read_all_regs();
+    ASSERT_EQ(regs.size(), targ->regs().size());
+    EXPECT_EQ(server.count("getr"), regs.size());
+    EXPECT_STREQ(regs.names[1], "sp");
+    EXPECT_EQ(regs.value_size(0), 8);
+    EXPECT_EQ(regs.value_size(9), 4);
+    EXPECT_EQ(regs.offsets.back(), regs.data.size());
+    EXPECT_EQ(regs.data.size(), 2 * 8 + 8 * 4);
+    ASSERT_NE(regs.find("sp"), nullptr);
+    EXPECT_EQ(memcmp(regs.find("sp"), "\1\2\3\4\5\6\7\10", 8), 0);
+    EXPECT_EQ(regs.find("nope"), nullptr);
+
+    // cached until the target advances or a register is written
+    targ->read_all_regs();
+    EXPECT_EQ(server.count("getr"), regs.size());
+
+    targ->step();
+    targ->read_all_regs();
+    EXPECT_EQ(server.count("getr"), 2 * regs.size());
+
+    sp->set_value({ 8, 7, 6, 5, 4, 3, 2, 1 });
+    EXPECT_EQ(targ->read_all_regs().find("sp")[0], 8);
+    EXPECT_EQ(server.count("getr"), 3 * regs.size());
+}
+
+TEST_P(memory_test, load_raw) {
+    string path = (fs::temp_directory_path() / "vsp_load_raw.bin").string();
+    vector<u8> data = pattern(100000);
+    std::ofstream(path, std::ios::binary)
+        .write((const char*)data.data(), data.size());
+
+    vector<pair<size_t, size_t>> calls;
+    load_stats stats = targ->load_image(
+        path, 0x1000, true,
+        [&](size_t done, size_t total) { calls.emplace_back(done, total); });
+    fs::remove(path);
+
+    EXPECT_EQ(memcmp(server.memory() + 0x1000, data.data(), data.size()), 0);
+    EXPECT_EQ(stats.entry, 0x1000);
+    EXPECT_EQ(stats.segments, 1);
+    EXPECT_EQ(stats.bytes, data.size());
+    EXPECT_EQ(stats.checksum, crc32(data.data(), data.size()));
+    EXPECT_TRUE(stats.verified);
+    EXPECT_GE(stats.throughput(), 0.0);
+
+    vector<pair<size_t, size_t>> expect{ { data.size(), data.size() } };
+    EXPECT_EQ(calls, expect);
+
+    size_t chunks = (data.size() + targ->chunk_size() - 1) /
+                    targ->chunk_size();
+    EXPECT_EQ(server.count(binary() ? "bpwrite" : "pwrite"), chunks);
+    EXPECT_EQ(server.count(binary() ? "bpread" : "pread"), chunks);
+}
+
+TEST_P(memory_test, load_elf) {
+    string path = (fs::temp_directory_path() / "vsp_load_elf.elf").string();
+    vector<u8> text = pattern(0x1800);
+    vector<u8> data = pattern(0x300);
+    write_test_elf(path, { { "main", 0x4000, 0x10, 2, true } },
+                   { { 0x4000, text, 0 }, { 0x8000, data, 0x1000 } });
+
+    memset(server.memory(), 0xff, mockvp::MEMSIZE);
+    targ->set_chunk_size(1024);
+
+    size_t calls = 0;
+    load_stats stats = targ->load_image(path, 0x10000, false,
+                                        [&](size_t done, size_t total) {
+                                            EXPECT_EQ(total, 0x2800);
+                                            EXPECT_LE(done, total);
+                                            calls++;
+                                        });
+    fs::remove(path);
+
+    const u8* mem = server.memory() + 0x10000;
+    EXPECT_EQ(memcmp(mem + 0x4000, text.data(), text.size()), 0);
+    EXPECT_EQ(memcmp(mem + 0x8000, data.data(), data.size()), 0);
+    EXPECT_EQ(mem[0x3fff], 0xff);
+    EXPECT_EQ(mem[0x5800], 0xff);
+    EXPECT_EQ(mem[0x8fff], 0x00);
+    EXPECT_EQ(mem[0x9000], 0xff);
+    for (size_t i = 0x8300; i < 0x9000; i++)
+        ASSERT_EQ(mem[i], 0) << i;
+
+    EXPECT_EQ(stats.entry, 0x14000);
+    EXPECT_EQ(stats.segments, 2);
+    EXPECT_EQ(stats.bytes, 0x2800);
+    EXPECT_FALSE(stats.verified);
+    EXPECT_EQ(calls, 3);
+    EXPECT_EQ(server.count(binary() ? "bpwrite" : "pwrite"), 6 + 1 + 4);
+    EXPECT_EQ(server.count(binary() ? "bpread" : "pread"), 0);
+
+    u32 crc = crc32(text.data(), text.size());
+    crc = crc32(data.data(), data.size(), crc);
+    vector<u8> bss(0x1000 - data.size());
+    EXPECT_EQ(stats.checksum, crc32(bss.data(), bss.size(), crc));
+}
+
+TEST_P(memory_test, load_errors) {
+    string path = (fs::temp_directory_path() / "vsp_load_bad.bin").string();
+    vector<u8> data = pattern(0x2000);
+    std::ofstream(path, std::ios::binary)
+        .write((const char*)data.data(), data.size());
+
+    EXPECT_THROW(targ->load_image(path + ".missing"), mwr::report);
+    EXPECT_THROW(targ->load_image(path, mockvp::MEMSIZE - 0x1000),
+                 mwr::report);
+
+    // writes that are acknowledged but never land fail verification
+    const char* cmd = binary() ? "bpwrite" : "pwrite";
+    server.handle(cmd, [this](const response& req) {
+        size_t n = binary() ? req.at(3).size() : req.size() - 3;
+        return mkstr("OK,%zu bytes written", n);
+    });
+
+    EXPECT_NO_THROW(targ->load_image(path, 0x1000));
+    EXPECT_THROW(targ->load_image(path, 0x1000, true), mwr::report);
+
+    // the first byte that differs is reported
+    u8* mem = server.memory();
+    std::copy(data.begin(), data.end(), mem + 0x1000);
+    mem[0x1000 + 0x1234] ^= 0xff;
+    mem[0x1000 + 0x1800] ^= 0xff;
+    try {
+        targ->load_image(path, 0x1000, true);
+        ADD_FAILURE() << "verification did not fail";
+    } catch (mwr::report& r) {
+        EXPECT_THAT(r.what(), HasSubstr("failed at 0x2234"));
+    }
+
+    fs::remove(path);
+}
+
+TEST_P(memory_test, dump) {
+    vector<u8> data = pattern(50000);
+    memcpy(server.memory() + 0x3000, data.data(), data.size());
+
+    std::stringstream ss;
+    EXPECT_EQ(targ->dump_pmem(0x3000, data.size(), ss), data.size());
+    EXPECT_EQ(ss.str(), string(data.begin(), data.end()));
+
+    ss.str("");
+    EXPECT_EQ(targ->dump_vmem(0x3000, 100, ss), 100);
+    EXPECT_EQ(ss.str(), string(data.begin(), data.begin() + 100));
+
+    size_t chunks = (data.size() + targ->chunk_size() - 1) /
+                    targ->chunk_size();
+    EXPECT_EQ(server.count(binary() ? "bpread" : "pread"), chunks);
+    EXPECT_EQ(server.count(binary() ? "bvread" : "vread"), 1);
+
+    // everything up to the chunk that failed ends up in the dump
+    ss.str("");
+    size_t n = 2 * targ->chunk_size();
+    EXPECT_EQ(targ->dump_pmem(mockvp::MEMSIZE - n, 2 * n, ss), n);
+    EXPECT_EQ(ss.str().size(), n);
+}
+
+TEST_P(memory_test, dump_sparse) {
+    string path = (fs::temp_directory_path() / "vsp_dump.bin").string();
+    const size_t size = 64 * 1024;
+    u8* mem = server.memory() + 0x10000;
+    memset(mem, 0, size);
+    mem[0x10] = 1;
+    mem[0x5123] = 2;
+    mem[0x9fff] = 3;
+
+    targ->set_chunk_size(6000);
+    EXPECT_EQ(targ->dump_pmem(0x10000, size, path, true), size);
+
+    std::ifstream file(path, std::ios::binary);
+    string contents((std::istreambuf_iterator<char>(file)),
+                    std::istreambuf_iterator<char>());
+    EXPECT_EQ(contents, string((const char*)mem, size));
+    file.close();
+
+    EXPECT_EQ(targ->dump_pmem(0x10000, size, path, false), size);
+    EXPECT_EQ(fs::file_size(path), size);
+    fs::remove(path);
+
+    EXPECT_THROW(targ->dump_pmem(0, 16, "/nonexistent/dir/dump.bin"),
+                 mwr::report);
+}
+
+TEST_P(memory_test, search) {
+    const u64 base = 0x20000;
+    const size_t size = 0x8000;
+    u8* mem = server.memory() + base;
+    memset(mem, 0, size);
+
+    vector<u8> magic{ 0xde, 0xad, 0xbe, 0xef, 0x11 };
+    vector<u64> expect;
+    for (u64 off : { 0x0, 0x3fe, 0x1000, 0x1ffd, 0x7ffb }) {
+        memcpy(mem + off, magic.data(), magic.size());
+        expect.push_back(base + off);
+    }
+
+    // chunk sizes smaller than, equal to and larger than the pattern put
+    // the matches across chunk boundaries in every possible way
+    size_t reads = 0;
+    for (size_t chunk : { 1, 3, 4, 5, 7, 1000, 4096 }) {
+        targ->set_chunk_size(chunk);
+        EXPECT_EQ(targ->search_pmem(base, size, magic), expect)
+            << "chunk size " << chunk;
+        reads += (size + chunk - 1) / chunk;
+        EXPECT_EQ(server.count(binary() ? "bpread" : "pread"), reads);
+    }
+
+    targ->set_chunk_size(1000);
+    EXPECT_THAT(targ->search_vmem(base, size, { 0xde, 0x00, 0x00, 0xef },
+                                  { 0xff, 0x00, 0x00, 0xff }),
+                ElementsAreArray(expect));
+    EXPECT_THAT(targ->search_pmem(base, 0x1003, magic),
+                ElementsAre(base, base + 0x3fe));
+    EXPECT_TRUE(targ->search_pmem(base + 1, 0x3fe + 3, magic).empty());
+
+    EXPECT_THROW(targ->search_pmem(mockvp::MEMSIZE - 16, 32, magic),
+                 mwr::report);
+}
+
+TEST_P(memory_test, translate) {
+    // pages below 0x10000 are unmapped, all others map to pa = va ^ 0x1000
+    server.handle("vapa", [](const response& req) {
+        u64 va = req.to_u64(2);
+        MWR_REPORT_ON(va < 0x10000, "address not mapped");
+        MWR_REPORT_ON(va >= 0x100000, "server busy");
+        return mkstr("OK,%llx", (unsigned long long)(va ^ 0x1000));
+    });
+
+    EXPECT_FALSE(targ->tlb_enabled());
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(server.count("vapa"), 2);
+    EXPECT_THROW(targ->virt_to_phys(0x100), mwr::report);
+
+    targ->enable_tlb();
+    EXPECT_TRUE(targ->tlb_enabled());
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(targ->virt_to_phys(0x12fff), 0x13fff);
+    EXPECT_EQ(targ->virt_to_phys(0x12000), 0x13000);
+    EXPECT_EQ(server.count("vapa"), 4);
+    EXPECT_EQ(targ->tlb_misses(), 1);
+    EXPECT_EQ(targ->tlb_hits(), 2);
+
+    // failed translations are cached as well
+    EXPECT_THROW(targ->virt_to_phys(0x100), mwr::report);
+    EXPECT_THROW(targ->virt_to_phys(0x200), mwr::report);
+    EXPECT_EQ(server.count("vapa"), 5);
+
+    // other errors are not, the next lookup may well succeed
+    EXPECT_THROW(targ->virt_to_phys(0x100000), mwr::report);
+    EXPECT_THROW(targ->virt_to_phys(0x100000), mwr::report);
+    EXPECT_EQ(server.count("vapa"), 7);
+
+    // anything that advances the target flushes the tlb
+    targ->step();
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(server.count("vapa"), 8);
+    targ->flush_tlb();
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(server.count("vapa"), 9);
+
+    targ->disable_tlb();
+    EXPECT_EQ(targ->virt_to_phys(0x12345), 0x13345);
+    EXPECT_EQ(server.count("vapa"), 10);
+}
+
+TEST_P(memory_test, translate_range) {
+    server.handle("vapa", [](const response& req) {
+        u64 va = req.to_u64(2);
+        MWR_REPORT_ON(va >= 0x13000 && va < 0x15000, "address not mapped");
+        return mkstr("OK,%llx", (unsigned long long)(va ^ 0x1000));
+    });
+
+    // 0x10000 -> 0x11000, 0x11000 -> 0x10000, 0x12000 -> 0x13000, gap,
+    // 0x15000 -> 0x14000
+    vector<phys_extent> ext = targ->virt_to_phys(0x10800, 0x5000);
+    EXPECT_EQ(server.count("vapa"), 20);
+    ASSERT_EQ(ext.size(), 4);
+    EXPECT_EQ(ext[0].vaddr, 0x10800);
+    EXPECT_EQ(ext[0].paddr, 0x11800);
+    EXPECT_EQ(ext[0].size, 0x800);
+    EXPECT_EQ(ext[1].vaddr, 0x11000);
+    EXPECT_EQ(ext[1].paddr, 0x10000);
+    EXPECT_EQ(ext[1].size, 0x1000);
+    EXPECT_EQ(ext[2].vaddr, 0x12000);
+    EXPECT_EQ(ext[2].paddr, 0x13000);
+    EXPECT_EQ(ext[2].size, 0x1000);
+    EXPECT_EQ(ext[3].vaddr, 0x15000);
+    EXPECT_EQ(ext[3].paddr, 0x14000);
+    EXPECT_EQ(ext[3].size, 0x800);
+
+    // callers that know the page size of the target need fewer lookups
+    EXPECT_EQ(targ->virt_to_phys(0x10800, 0x5000, 0x1000).size(), 4);
+    EXPECT_EQ(server.count("vapa"), 20 + 6);
+    EXPECT_THROW(targ->virt_to_phys(0x10800, 0x5000, 0x1800), mwr::report);
+
+    // contiguous pages merge into a single extent
+    server.handle("vapa", [](const response& req) {
+        return mkstr("OK,%llx", (unsigned long long)(req.to_u64(2) + 0x100));
+    });
+
+    targ->enable_tlb();
+    ext = targ->virt_to_phys(0x20010, 0x4000);
+    ASSERT_EQ(ext.size(), 1);
+    EXPECT_EQ(ext[0].vaddr, 0x20010);
+    EXPECT_EQ(ext[0].paddr, 0x20110);
+    EXPECT_EQ(ext[0].size, 0x4000);
+    EXPECT_EQ(targ->tlb_misses(), 5);
+
+    // only the pages that are not cached yet go out
+    ext = targ->virt_to_phys(0x22000, 0x4000);
+    ASSERT_EQ(ext.size(), 1);
+    EXPECT_EQ(targ->tlb_hits(), 3);
+    EXPECT_EQ(targ->tlb_misses(), 6);
+    EXPECT_EQ(targ->virt_to_phys(0x25123), 0x25223);
+    EXPECT_EQ(server.count("vapa"), 26 + 6);
+
+    EXPECT_TRUE(targ->virt_to_phys(0x1000, 0).empty());
+    EXPECT_THROW(targ->virt_to_phys(~0ull - 0xff, 0x200), mwr::report);
+    EXPECT_THROW(targ->enable_tlb(0x1800), mwr::report);
+}
+
+TEST_P(memory_test, translate_small_pages) {
+    // 1k pages, neighbours are swapped: 0x1000 -> 0x1400, 0x1400 -> 0x1000
+    server.handle("vapa", [](const response& req) {
+        return mkstr("OK,%llx", (unsigned long long)(req.to_u64(2) ^ 0x400));
+    });
+
+    vector<phys_extent> ext = targ->virt_to_phys(0x1200, 0x800);
+    ASSERT_EQ(ext.size(), 3);
+    EXPECT_EQ(ext[0].vaddr, 0x1200);
+    EXPECT_EQ(ext[0].paddr, 0x1600);
+    EXPECT_EQ(ext[0].size, 0x200);
+    EXPECT_EQ(ext[1].vaddr, 0x1400);
+    EXPECT_EQ(ext[1].paddr, 0x1000);
+    EXPECT_EQ(ext[1].size, 0x400);
+    EXPECT_EQ(ext[2].vaddr, 0x1800);
+    EXPECT_EQ(ext[2].paddr, 0x1c00);
+    EXPECT_EQ(ext[2].size, 0x200);
+
+    // ranges may end at the very top of the address space
+    ext = targ->virt_to_phys(~0ull - 0x1ff, 0x200);
+    ASSERT_EQ(ext.size(), 1);
+    EXPECT_EQ(ext[0].vaddr, ~0ull - 0x1ff);
+    EXPECT_EQ(ext[0].paddr, ~0ull - 0x5ff);
+    EXPECT_EQ(ext[0].size, 0x200);
+}
+
+INSTANTIATE_TEST_SUITE_P(memory, memory_test,
+                         Values(VSP_CAP_NONE, VSP_CAP_BINARY_MEMORY),
+                         [](const TestParamInfo<u32>& info) {
+                             return string(info.param ? "binary" : "text");
+                         });
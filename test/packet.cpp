@@ -0,0 +1,104 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+#include "mockvp.h"
+
+#include <new>
+
+using namespace testing;
+using namespace vsp;
+
+static thread_local size_t allocations = 0;
+
+void* operator new(size_t size) {
+    allocations++;
+    if (void* ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+TEST(packet, fields) {
+    packet pkt;
+    pkt.begin("cmd").field("a").field((u64)1234).field(-5).finish();
+    EXPECT_EQ(pkt.str(), "$cmd,a,1234,-5#45");
+
+    pkt.clear();
+    EXPECT_TRUE(pkt.empty());
+    pkt.begin("x").finish().append('+');
+    pkt.begin("y").finish();
+    EXPECT_EQ(pkt.str(), "$x#78+$y#79");
+}
+
+TEST(packet, escaping) {
+    packet pkt;
+    pkt.begin("$#*}").finish();
+    EXPECT_EQ(pkt.str(), "$}\x04}\x03}\x0a}]#62");
+}
+
+TEST(packet, data) {
+    const u8 data[] = { 0, '#', 255 };
+    packet pkt;
+    pkt.begin("w").field(decimal_data{ data, sizeof(data) });
+    pkt.field(binary_data{ data, sizeof(data) }).finish();
+    EXPECT_EQ(pkt.str().substr(0, 11), "$w,0,35,255");
+    EXPECT_EQ(pkt.str().substr(11, 6), string(",\0}\x03\xff#", 6));
+}
+
+TEST(packet, binary_fields) {
+    // binary data follows the field rules, so it can be split again
+    const u8 data[] = { ',', '\\', 'x', ',' };
+    packet pkt;
+    pkt.begin("w").field(binary_data{ data, sizeof(data) }).finish();
+    EXPECT_EQ(pkt.str().substr(0, 11), "$w,\\,\\\\x\\,#");
+
+    string payload = pkt.str().substr(1, pkt.str().find('#') - 1);
+    response resp(std::move(payload));
+    ASSERT_EQ(resp.size(), 2);
+    EXPECT_EQ(resp[1], string((const char*)data, sizeof(data)));
+}
+
+TEST(packet, no_allocations) {
+    mockvp server;
+    session sess(server.host(), server.port());
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+    cpureg* pc = targ->find_reg("pc");
+    ASSERT_NE(pc, nullptr);
+
+    vector<u8> val;
+    auto poll = [&]() {
+        targ->step();
+        EXPECT_FALSE(sess.check_running());
+        pc->get_value(val);
+        targ->virt_to_phys(0x1000);
+    };
+
+    // the first round grows all buffers to their final size
+    poll();
+
+    allocations = 0;
+    for (int i = 0; i < 100; i++)
+        poll();
+
+    EXPECT_EQ(allocations, 0);
+    EXPECT_EQ(server.count("step"), 101);
+    EXPECT_EQ(sess.reason().reason, VSP_STOP_REASON_TARGET_STEP_COMPLETE);
+    EXPECT_EQ(sess.reason().target_step_complete.tgt, targ);
+
+    sess.disconnect();
+}
@@ -0,0 +1,129 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+TEST(pc_histogram, counts) {
+    pc_histogram hist(100);
+    EXPECT_EQ(hist.capacity(), 128);
+
+    hist.add(0x1000);
+    hist.add(0x2000, 5);
+    hist.add(0x1000);
+    hist.add(0);
+
+    EXPECT_EQ(hist.total(), 8);
+    EXPECT_EQ(hist.count(0x1000), 2);
+    EXPECT_EQ(hist.count(0x2000), 5);
+    EXPECT_EQ(hist.count(0), 1);
+    EXPECT_EQ(hist.count(0x3000), 0);
+
+    vector<pair<u64, u64>> expect{ { 0x2000, 5 }, { 0x1000, 2 }, { 0, 1 } };
+    EXPECT_EQ(hist.entries(), expect);
+
+    hist.clear();
+    EXPECT_EQ(hist.total(), 0);
+    EXPECT_TRUE(hist.entries().empty());
+}
+
+TEST(pc_histogram, full) {
+    pc_histogram hist(16);
+    for (u64 pc = 0; pc < 20; pc++)
+        hist.add(pc * 4);
+
+    EXPECT_EQ(hist.total(), 20);
+    EXPECT_EQ(hist.dropped(), 4);
+    EXPECT_EQ(hist.entries().size(), 16);
+}
+
+TEST(pc_histogram, concurrent) {
+    pc_histogram hist;
+    vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&hist]() {
+            for (u64 i = 0; i < 10000; i++)
+                hist.add((i % 100) * 4);
+        });
+    }
+
+    // readers may look at the histogram at any time
+    while (hist.total() < 40000)
+        EXPECT_LE(hist.entries().size(), 100);
+
+    for (auto& t : threads)
+        t.join();
+
+    EXPECT_EQ(hist.total(), 40000);
+    EXPECT_EQ(hist.dropped(), 0);
+    for (u64 i = 0; i < 100; i++)
+        EXPECT_EQ(hist.count(i * 4), 400);
+}
+
+class profiler_test : public mockvp_test
+{
+protected:
+    size_t reads;
+
+    profiler_test(): mockvp_test(mockvp::DEFAULT_CAPS, false), reads(0) {
+        server.set_instant_runs(true);
+
+        // three quarters of all samples hit 0x1000, the rest 0x2000
+        server.handle("getr", [this](const response&) {
+            u64 pc = (reads++ % 4) ? 0x1000 : 0x2000;
+            string resp = "OK";
+            for (int i = 0; i < 8; i++)
+                resp += mkstr(",%02x", (unsigned)(pc >> (8 * i)) & 0xff);
+            return resp;
+        });
+
+        sess.connect(server.host(), server.port());
+    }
+};
+
+TEST_F(profiler_test, sim_time) {
+    profiler prof(sess);
+    ASSERT_EQ(prof.targets().size(), 1);
+
+    u64 time = sess.get_time_ns();
+    EXPECT_EQ(prof.run(PROFILE_SIM_TIME, 100, 40), 40);
+    EXPECT_EQ(sess.get_time_ns(), time + 40 * 100);
+
+    const pc_histogram* hist = prof.find_histogram(*prof.targets()[0]);
+    ASSERT_NE(hist, nullptr);
+    EXPECT_EQ(hist->total(), 40);
+    EXPECT_EQ(hist->count(0x1000), 30);
+    EXPECT_EQ(hist->count(0x2000), 10);
+
+    stringstream flat;
+    prof.export_flat(flat);
+    EXPECT_THAT(flat.str(), HasSubstr("target system.cpu: 40 samples"));
+    EXPECT_THAT(flat.str(), ContainsRegex("30 +75.00%  0x1000"));
+    EXPECT_THAT(flat.str(), ContainsRegex("10 +25.00%  0x2000"));
+
+    stringstream collapsed;
+    prof.export_collapsed(collapsed, [](const target&, u64 pc) {
+        return pc == 0x1000 ? string("main") : string();
+    });
+    EXPECT_EQ(collapsed.str(), "system.cpu;main 30\nsystem.cpu;0x2000 10\n");
+}
+
+TEST_F(profiler_test, wall_clock) {
+    profiler prof(sess);
+    EXPECT_EQ(prof.run(PROFILE_WALL_CLOCK, 1000, 5), 5);
+    EXPECT_EQ(prof.histogram(0).total(), 5);
+    EXPECT_EQ(server.count("stop"), 5);
+    EXPECT_FALSE(sess.check_running());
+
+    prof.clear();
+    EXPECT_EQ(prof.histogram(0).total(), 0);
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+
+using namespace testing;
+using namespace vsp;
+
+TEST(response, empty) {
+    response resp;
+    EXPECT_TRUE(resp.empty());
+    EXPECT_FALSE(resp.ok());
+    EXPECT_THROW(resp.at(0), mwr::report);
+}
+
+TEST(response, fields) {
+    response resp("OK,a,,bc,");
+    ASSERT_EQ(resp.size(), 5);
+    EXPECT_TRUE(resp.ok());
+    EXPECT_EQ(resp[0], "OK");
+    EXPECT_EQ(resp[1], "a");
+    EXPECT_EQ(resp[2], "");
+    EXPECT_EQ(resp[3], "bc");
+    EXPECT_EQ(resp[4], "");
+    EXPECT_THAT(resp.to_vector(), ElementsAre("OK", "a", "", "bc", ""));
+}
+
+TEST(response, unescape) {
+    response resp("OK,a\\,b,c\\\\,d\\");
+    ASSERT_EQ(resp.size(), 4);
+    EXPECT_EQ(resp[1], "a,b");
+    EXPECT_EQ(resp[2], "c\\");
+    EXPECT_EQ(resp[3], "d\\");
+}
+
+TEST(response, error) {
+    response resp("E,simulation running");
+    EXPECT_FALSE(resp.ok());
+    EXPECT_EQ(resp.error(), "simulation running");
+
+    response unknown("E");
+    EXPECT_FALSE(unknown.ok());
+    EXPECT_EQ(unknown.error(), "unknown error");
+}
+
+TEST(response, numbers) {
+    response resp("OK,42,ff,0x10,nope,");
+    EXPECT_EQ(resp.to_u64(1), 42);
+    EXPECT_EQ(resp.to_u64(2, 16), 0xff);
+    EXPECT_EQ(resp.to_u64(3, 16), 0x10);
+    EXPECT_THROW(resp.to_u64(4), mwr::report);
+    EXPECT_THROW(resp.to_u64(5), mwr::report);
+    EXPECT_THROW(resp.to_u64(6), mwr::report);
+}
+
+TEST(response, move) {
+    response a("OK,x");
+    response b(std::move(a));
+    EXPECT_EQ(b[1], "x");
+
+    response c;
+    c = b;
+    b.assign("OK,y,z");
+    EXPECT_EQ(c[1], "x");
+    EXPECT_EQ(b[2], "z");
+}
+
+TEST(response, max_fields) {
+    response resp("OK,a\\,b,c,d", 3);
+    ASSERT_EQ(resp.size(), 3);
+    EXPECT_EQ(resp[0], "OK");
+    EXPECT_EQ(resp[1], "a,b");
+    EXPECT_EQ(resp[2], "c,d");
+
+    response one("OK,x\\,y", 1);
+    ASSERT_EQ(one.size(), 1);
+    EXPECT_EQ(one[0], "OK,x\\,y");
+
+    response short_resp("OK", 2);
+    ASSERT_EQ(short_resp.size(), 1);
+    EXPECT_EQ(short_resp[0], "OK");
+}
@@ -0,0 +1,106 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "testing.h"
+
+#include <random>
+
+using namespace testing;
+using namespace vsp;
+
+static const pattern_matcher MATCHERS[] = {
+    PATTERN_MATCHER_AUTO,
+    PATTERN_MATCHER_SCALAR,
+    PATTERN_MATCHER_SSE2,
+    PATTERN_MATCHER_AVX2,
+};
+
+static vector<u64> reference(const vector<u8>& data, const vector<u8>& pat,
+                             const vector<u8>& mask, u64 base) {
+    vector<u64> result;
+    for (size_t i = 0; i + pat.size() <= data.size(); i++) {
+        bool match = true;
+        for (size_t j = 0; j < pat.size() && match; j++) {
+            u8 m = mask.empty() ? 0xff : mask[j];
+            match = (data[i + j] & m) == (pat[j] & m);
+        }
+
+        if (match)
+            result.push_back(base + i);
+    }
+
+    return result;
+}
+
+TEST(search, random) {
+    std::mt19937 rng(1);
+    for (pattern_matcher impl : MATCHERS) {
+        if (!pattern_matcher_supported(impl))
+            continue;
+
+        for (size_t size = 0; size < 200; size++) {
+            // a small alphabet makes partial matches frequent
+            vector<u8> data(size);
+            for (u8& b : data)
+                b = rng() % 3;
+
+            for (size_t len : { 1, 2, 3, 7, 40 }) {
+                vector<u8> pat(len);
+                for (u8& b : pat)
+                    b = rng() % 3;
+
+                byte_pattern bp(pat, {}, impl);
+                vector<u64> found;
+                bp.find(data.data(), data.size(), 0x100, found);
+                EXPECT_EQ(found, reference(data, pat, {}, 0x100))
+                    << "matcher " << impl << " size " << size << " len "
+                    << len;
+            }
+        }
+    }
+}
+
+TEST(search, masked) {
+    vector<u8> data(300, 0x55);
+    data[17] = 0x12;
+    data[18] = 0x99;
+    data[19] = 0x34;
+    data[250] = 0x1f;
+    data[251] = 0x00;
+    data[252] = 0x3f;
+
+    // high nibbles of the first and last byte, anything in between
+    vector<u8> pat{ 0x10, 0x00, 0x30 };
+    vector<u8> mask{ 0xf0, 0x00, 0xf0 };
+
+    for (pattern_matcher impl : MATCHERS) {
+        if (!pattern_matcher_supported(impl))
+            continue;
+
+        byte_pattern bp(pat, mask, impl);
+        vector<u64> found;
+        bp.find(data.data(), data.size(), 0, found);
+        EXPECT_THAT(found, ElementsAre(17, 250)) << "matcher " << impl;
+        EXPECT_EQ(found, reference(data, pat, mask, 0));
+    }
+
+    // wildcards only match everywhere
+    byte_pattern any({ 1, 2 }, { 0, 0 });
+    vector<u64> found;
+    any.find(data.data(), 10, 0, found);
+    EXPECT_EQ(found.size(), 9);
+}
+
+TEST(search, invalid) {
+    EXPECT_THROW(byte_pattern(vector<u8>()), mwr::report);
+    EXPECT_THROW(byte_pattern({ 1, 2 }, { 0xff }), mwr::report);
+    EXPECT_THROW(byte_pattern({ 1 }, {}, (pattern_matcher)42), mwr::report);
+}
@@ -0,0 +1,181 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+class symbols_test : public Test
+{
+protected:
+    string path;
+
+    symbols_test(): path() {
+        path = (fs::temp_directory_path() / "vsp_symbols_test.elf").string();
+    }
+
+    virtual ~symbols_test() { fs::remove(path); }
+};
+
+TEST_F(symbols_test, lookup) {
+    write_test_elf(path, {
+                             { "helper", 0x1040, 0x20, 2, false },
+                             { "main", 0x1000, 0x40, 2, true },
+                             { "loop", 0x1010, 0, 0, false },
+                             { "main_alias", 0x1000, 0, 0, false },
+                             { "$x", 0x1000, 0, 0, false },
+                             { "buffer", 0x2000, 0x100, 1, true },
+                         });
+
+    symbol_index syms(path);
+    EXPECT_TRUE(syms.elf().is_64bit());
+    EXPECT_FALSE(syms.elf().is_big_endian());
+    EXPECT_EQ(syms.size(), 5);
+
+    auto sym = syms.lookup(0x1014);
+    ASSERT_TRUE(sym);
+    EXPECT_EQ(sym->name, "main");
+    EXPECT_EQ(sym->addr, 0x1000);
+    EXPECT_EQ(sym->size, 0x40);
+
+    EXPECT_EQ(syms.describe(0x1000), "main");
+    EXPECT_EQ(syms.describe(0x1014), "main+0x14");
+    EXPECT_EQ(syms.describe(0x1010), "loop");
+    EXPECT_EQ(syms.describe(0x1044), "helper+0x4");
+    EXPECT_EQ(syms.describe(0x20ff), "buffer+0xff");
+    EXPECT_EQ(syms.describe(0x2100), "");
+    EXPECT_EQ(syms.describe(0xfff), "");
+
+    sym = syms.find("helper");
+    ASSERT_TRUE(sym);
+    EXPECT_EQ(sym->addr, 0x1040);
+    EXPECT_TRUE(syms.find("main_alias"));
+    EXPECT_FALSE(syms.find("$x"));
+    EXPECT_FALSE(syms.find("missing"));
+}
+
+TEST_F(symbols_test, elf32_big_endian) {
+    write_test_elf(path,
+                   {
+                       { "reset", 0x80000000, 0x10, 2, true },
+                       { "vectors", 0x80000010, 0x40, 1, true },
+                   },
+                   {}, false, true);
+
+    symbol_index syms(path);
+    EXPECT_FALSE(syms.elf().is_64bit());
+    EXPECT_TRUE(syms.elf().is_big_endian());
+    EXPECT_EQ(syms.size(), 2);
+    EXPECT_EQ(syms.describe(0x80000004), "reset+0x4");
+    EXPECT_EQ(syms.describe(0x80000020), "vectors+0x10");
+    EXPECT_EQ(syms.find("vectors")->addr, 0x80000010);
+}
+
+TEST_F(symbols_test, many) {
+    const size_t n = 200000;
+    vector<test_elf_symbol> list;
+    for (size_t i = 0; i < n; i++) {
+        u64 addr = 0x10000 + (n - 1 - i) * 0x10;
+        list.push_back({ mkstr("fn%zu", n - 1 - i), addr, 0x10, 2, true });
+    }
+
+    write_test_elf(path, list);
+
+    symbol_index syms(path);
+    ASSERT_EQ(syms.size(), n);
+    for (size_t i = 0; i < syms.size(); i++)
+        ASSERT_EQ(syms.at(i).addr, 0x10000 + i * 0x10);
+
+    for (size_t i = 0; i < n; i += 997) {
+        string name = mkstr("fn%zu", i);
+        EXPECT_EQ(syms.describe(0x10000 + i * 0x10 + 8), name + "+0x8");
+        auto sym = syms.find(name);
+        ASSERT_TRUE(sym);
+        EXPECT_EQ(sym->addr, 0x10000 + i * 0x10);
+    }
+}
+
+TEST_F(symbols_test, invalid) {
+    std::ofstream(path) << "not an elf file";
+    EXPECT_THROW(symbol_index syms(path), mwr::report);
+    EXPECT_THROW(symbol_index syms(path + ".missing"), mwr::report);
+}
+
+TEST_F(symbols_test, corrupt) {
+    write_test_elf(path, { { "main", 0x1000, 0x10, 2, true } });
+    vector<u8> image;
+    {
+        std::ifstream file(path, std::ios::binary);
+        image.assign(std::istreambuf_iterator<char>(file), {});
+    }
+
+    auto patch = [&image](size_t off, u64 val) {
+        for (size_t i = 0; i < 8; i++)
+            image[off + i] = (u8)(val >> (8 * i));
+    };
+
+    auto save = [&image, this]() {
+        std::ofstream(path, std::ios::binary | std::ios::trunc)
+            .write((const char*)image.data(), image.size());
+    };
+
+    // a section name table whose end wraps around is ignored
+    u64 shoff = 0;
+    for (size_t i = 0; i < 8; i++)
+        shoff |= (u64)image[0x28 + i] << (8 * i);
+    patch(shoff + 3 * 64 + 0x18, ~0ull - 0xff);
+    patch(shoff + 3 * 64 + 0x20, 0x200);
+    save();
+
+    elf_file elf(path);
+    ASSERT_EQ(elf.sections().size(), 4);
+    EXPECT_TRUE(elf.sections()[1].name.empty());
+    EXPECT_TRUE(symbol_index(path).find("main"));
+
+    // header tables must lie within the file as a whole
+    patch(0x28, image.size() - 64);
+    save();
+    EXPECT_THROW(elf_file truncated(path), mwr::report);
+}
+
+TEST_F(symbols_test, breakpoint) {
+    write_test_elf(path, {
+                             { "reset", 0x0, 0x10, 2, true },
+                             { "main", 0x1000, 0x40, 2, true },
+                         });
+
+    mockvp server;
+    session sess;
+    sess.connect(server.host(), server.port());
+    target* targ = sess.find_target(mockvp::TARGET);
+    ASSERT_NE(targ, nullptr);
+
+    EXPECT_THROW(targ->insert_breakpoint("main"), mwr::report);
+
+    targ->set_symbols(std::make_shared<symbol_index>(path));
+    breakpoint bp = targ->insert_breakpoint("main");
+    EXPECT_EQ(bp.addr, 0x1000);
+    EXPECT_EQ(server.count("mkbp"), 1);
+    EXPECT_THROW(targ->insert_breakpoint("missing"), mwr::report);
+    EXPECT_EQ(server.count("mkbp"), 1);
+    targ->remove_breakpoint(bp);
+    EXPECT_EQ(server.count("rmbp"), 1);
+
+    // samples are reported relative to the symbols of their target
+    profiler prof(sess);
+    prof.sample();
+    std::stringstream ss;
+    prof.export_collapsed(ss);
+    EXPECT_EQ(ss.str(), mkstr("%s;reset 1\n", mockvp::TARGET));
+
+    sess.disconnect();
+}
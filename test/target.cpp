@@ -602,8 +602,8 @@ TEST_F(target_test, stepping) {
         "system.cpu0.wait_per_inst");
     ASSERT_NE(wait_per_inst, nullptr);
     wait_per_inst->set(500'000ull);
-    targ->step(3);
-    EXPECT_TRUE(sess.check_running());
+    const stop_reason& reason = targ->step(3);
+    EXPECT_EQ(reason.reason, VSP_STOP_REASON_TARGET_STEP_COMPLETE);
     ASSERT_TRUE(wait_for_target());
     EXPECT_FALSE(sess.check_running());
     EXPECT_EQ(targ->get_pc(), 0x0);
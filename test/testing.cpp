@@ -10,6 +10,183 @@
 
 #include "testing.h"
 
+using mwr::u8;
+using mwr::u32;
+using mwr::u64;
+
+namespace {
+
+struct elf_buffer {
+    std::vector<u8> data;
+    bool big_endian;
+
+    void put(u64 val, size_t size) {
+        for (size_t i = 0; i < size; i++) {
+            size_t shift = 8 * (big_endian ? size - 1 - i : i);
+            data.push_back((u8)(val >> shift));
+        }
+    }
+
+    void align(size_t n) {
+        while (data.size() % n)
+            data.push_back(0);
+    }
+};
+
+} // namespace
+
+static std::string make_test_cpus(size_t cpus, const std::string& kind) {
+    std::string xml;
+    for (size_t i = 0; i < cpus; i++) {
+        xml += mwr::mkstr("<object name=\"cpu%zu\" kind=\"%s\">", i,
+                          kind.c_str());
+        xml += "<attribute name=\"arch\" type=\"string\" count=\"1\" />";
+        xml += "<attribute name=\"freq\" type=\"u64\" count=\"1\" />";
+        xml += "<command name=\"reset\" argc=\"0\" desc=\"resets\" />";
+        xml += "</object>";
+    }
+
+    return xml;
+}
+
+std::string make_test_hierarchy(size_t clusters, size_t cpus,
+                                const std::string& kind, bool target) {
+    std::string xml = "<hierarchy><attribute name=\"version\" "
+                      "type=\"string\" count=\"1\" /><object "
+                      "name=\"system\" kind=\"soc\" version=\"2.0\">";
+    if (clusters == 0)
+        xml += make_test_cpus(cpus, kind);
+
+    for (size_t i = 0; i < clusters; i++) {
+        xml += mwr::mkstr("<object name=\"cluster%zu\" kind=\"cluster\">",
+                          i);
+        xml += make_test_cpus(cpus, kind);
+        xml += "</object>";
+    }
+
+    xml += "</object>";
+    if (target) {
+        xml += mwr::mkstr("<target arch=\"arm\" group=\"cpus\">%s</target>",
+                          vsp::mockvp::TARGET);
+    }
+
+    return xml + "</hierarchy>";
+}
+
+void write_test_elf(const std::string& path,
+                    const std::vector<test_elf_symbol>& syms,
+                    const std::vector<test_elf_segment>& segs, bool is64,
+                    bool big_endian) {
+    const size_t word = is64 ? 8 : 4;
+    const size_t ehsize = is64 ? 64 : 52;
+    const size_t phentsize = is64 ? 56 : 32;
+    const size_t shentsize = is64 ? 64 : 40;
+    const size_t symsize = is64 ? 24 : 16;
+
+    elf_buffer strtab{ { 0 }, big_endian };
+    elf_buffer symtab{ std::vector<u8>(symsize), big_endian };
+    for (const auto& sym : syms) {
+        u32 name = (u32)strtab.data.size();
+        strtab.data.insert(strtab.data.end(), sym.name.begin(),
+                           sym.name.end());
+        strtab.data.push_back(0);
+
+        u8 info = (sym.global ? 1 : 0) << 4 | sym.type;
+        symtab.put(name, 4);
+        if (is64) {
+            symtab.put(info, 1);
+            symtab.put(0, 1);
+            symtab.put(1, 2);
+            symtab.put(sym.addr, 8);
+            symtab.put(sym.size, 8);
+        } else {
+            symtab.put(sym.addr, 4);
+            symtab.put(sym.size, 4);
+            symtab.put(info, 1);
+            symtab.put(0, 1);
+            symtab.put(1, 2);
+        }
+    }
+
+    const std::string shstrtab("\0.symtab\0.strtab\0.shstrtab\0", 27);
+
+    elf_buffer out{ {}, big_endian };
+    out.data = { 0x7f, 'E', 'L', 'F', (u8)(is64 ? 2 : 1),
+                 (u8)(big_endian ? 2 : 1), 1 };
+    out.data.resize(16);
+    out.data.resize(ehsize + segs.size() * phentsize);
+
+    elf_buffer phdrs{ {}, big_endian };
+    for (const auto& seg : segs) {
+        out.align(8);
+        u64 offset = out.data.size();
+        out.data.insert(out.data.end(), seg.data.begin(), seg.data.end());
+
+        phdrs.put(1, 4); // loadable
+        if (is64)
+            phdrs.put(5, 4); // flags
+        phdrs.put(offset, word);
+        phdrs.put(seg.paddr, word);
+        phdrs.put(seg.paddr, word);
+        phdrs.put(seg.data.size(), word);
+        phdrs.put(std::max<u64>(seg.memsz, seg.data.size()), word);
+        if (!is64)
+            phdrs.put(5, 4);
+        phdrs.put(8, word);
+    }
+
+    std::copy(phdrs.data.begin(), phdrs.data.end(),
+              out.data.begin() + ehsize);
+
+    size_t symtab_off = out.data.size();
+    out.data.insert(out.data.end(), symtab.data.begin(), symtab.data.end());
+    size_t strtab_off = out.data.size();
+    out.data.insert(out.data.end(), strtab.data.begin(), strtab.data.end());
+    size_t shstrtab_off = out.data.size();
+    out.data.insert(out.data.end(), shstrtab.begin(), shstrtab.end());
+    out.align(8);
+    size_t shoff = out.data.size();
+
+    auto section = [&](u32 name, u32 type, u64 off, u64 size, u32 link,
+                       u64 entsize) {
+        out.put(name, 4);
+        out.put(type, 4);
+        out.put(0, word); // flags
+        out.put(0, word); // addr
+        out.put(off, word);
+        out.put(size, word);
+        out.put(link, 4);
+        out.put(0, 4); // info
+        out.put(1, word);
+        out.put(entsize, word);
+    };
+
+    section(0, 0, 0, 0, 0, 0);
+    section(1, 2, symtab_off, symtab.data.size(), 2, symsize);
+    section(9, 3, strtab_off, strtab.data.size(), 0, 0);
+    section(17, 3, shstrtab_off, shstrtab.size(), 0, 0);
+
+    // the header goes last, now that all offsets are known
+    elf_buffer hdr{ {}, big_endian };
+    hdr.put(2, 2);   // executable
+    hdr.put(243, 2); // riscv
+    hdr.put(1, 4);
+    hdr.put(segs.empty() ? 0 : segs[0].paddr, word); // entry
+    hdr.put(segs.empty() ? 0 : ehsize, word);
+    hdr.put(shoff, word);
+    hdr.put(0, 4);
+    hdr.put(ehsize, 2);
+    hdr.put(phentsize, 2);
+    hdr.put(segs.size(), 2);
+    hdr.put(shentsize, 2);
+    hdr.put(4, 2);
+    hdr.put(3, 2);
+    std::copy(hdr.data.begin(), hdr.data.end(), out.data.begin() + 16);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write((const char*)out.data.data(), out.data.size());
+}
+
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
@@ -15,6 +15,7 @@
 #include <gmock/gmock.h>
 
 #include "vsp.h"
+#include "mockvp.h"
 
 template <typename T>
 static bool try_connect(T& session, const std::string& host, mwr::u16 port) {
@@ -41,4 +42,51 @@ static bool try_connect(T& session, const std::string& host, mwr::u16 port,
     return false;
 }
 
+// Gives each test a mockvp of its own and a session, which is connected
+// right away unless the test still has to set up the server first.
+class mockvp_test : public testing::Test
+{
+protected:
+    vsp::mockvp server;
+    vsp::session sess;
+
+    explicit mockvp_test(mwr::u32 caps = vsp::mockvp::DEFAULT_CAPS,
+                         bool connect = true):
+        server(caps), sess() {
+        if (connect)
+            sess.connect(server.host(), server.port());
+    }
+
+    virtual ~mockvp_test() { sess.disconnect(); }
+};
+
+// returns the xml listing of a soc with the given number of clusters of
+// cpus, the cpus sit right below the soc if there are no clusters; every
+// cpu has an arch and a freq attribute and a reset command, the mockvp
+// target gets listed in group cpus if asked for
+std::string make_test_hierarchy(size_t clusters, size_t cpus,
+                                const std::string& kind = "cpu",
+                                bool target = false);
+
+struct test_elf_symbol {
+    std::string name;
+    mwr::u64 addr;
+    mwr::u64 size;
+    mwr::u8 type; // 0: none, 1: object, 2: function
+    bool global;
+};
+
+struct test_elf_segment {
+    mwr::u64 paddr;
+    std::vector<mwr::u8> data;
+    mwr::u64 memsz; // zero filled beyond data
+};
+
+// writes a minimal ELF file with a symbol table and loadable segments, the
+// entry point is the address of the first segment
+void write_test_elf(const std::string& path,
+                    const std::vector<test_elf_symbol>& syms,
+                    const std::vector<test_elf_segment>& segs = {},
+                    bool is64 = true, bool big_endian = false);
+
 #endif
@@ -0,0 +1,140 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+#include "testing.h"
+#include "mockvp.h"
+
+using namespace testing;
+using namespace vsp;
+
+class tracer_test : public mockvp_test
+{
+protected:
+    target* targ;
+    string path;
+
+    tracer_test(): mockvp_test(), targ(), path() {
+        path = (fs::temp_directory_path() / "vsp_tracer_test.trace").string();
+    }
+
+    virtual ~tracer_test() { fs::remove(path); }
+
+    virtual void SetUp() override {
+        targ = sess.find_target(mockvp::TARGET);
+        ASSERT_NE(targ, nullptr);
+    }
+
+    static u64 le(const u8* data, size_t size) {
+        u64 val = 0;
+        for (size_t i = size; i > 0; i--)
+            val = (val << 8) | data[i - 1];
+        return val;
+    }
+};
+
+TEST_F(tracer_test, trace) {
+    u64 pc = targ->get_pc();
+    size_t statuses = server.count("status");
+
+    tracer tr(*targ, { "sp", "r0" });
+    tr.set_index_interval(256);
+    EXPECT_EQ(tr.trace(path, 5000), 5000);
+
+    // one batched round trip per step
+    EXPECT_EQ(server.count("step"), 5000);
+    EXPECT_EQ(server.count("status") - statuses, 5000);
+
+    // pc delta, target index and mask take a byte each, plus r0
+    EXPECT_LT(fs::file_size(path), 5000 * 8);
+
+    trace_reader rd(path);
+    ASSERT_EQ(rd.size(), 5000);
+    ASSERT_EQ(rd.targets().size(), 1);
+    EXPECT_EQ(rd.targets()[0].name, mockvp::TARGET);
+    EXPECT_THAT(rd.targets()[0].regs, ElementsAre("sp", "r0"));
+    EXPECT_THAT(rd.targets()[0].offsets, ElementsAre(0, 8, 12));
+
+    trace_record rec;
+    for (size_t i = 0; i < 5000; i++) {
+        ASSERT_TRUE(rd.next(rec));
+        EXPECT_EQ(rec.target, 0);
+        EXPECT_EQ(rec.pc, pc + 4 * (i + 1));
+        ASSERT_EQ(rec.regs.size(), 12);
+        EXPECT_EQ(le(rec.regs.data(), 8), 0);
+        EXPECT_EQ(le(rec.regs.data() + 8, 4), i + 1);
+    }
+
+    EXPECT_FALSE(rd.next(rec));
+}
+
+TEST_F(tracer_test, trace_slow_steps) {
+    // steps that are still running when the registers are read in the
+    // same batch need all registers read again once they have completed
+    server.set_async_steps(true);
+    u64 pc = targ->get_pc();
+    size_t reads = server.count("getr");
+
+    tracer tr(*targ, { "sp", "r0" });
+    EXPECT_EQ(tr.trace(path, 100), 100);
+    EXPECT_EQ(server.count("step"), 100);
+    EXPECT_EQ(server.count("getr") - reads, 100 * 2 * 3);
+
+    trace_reader rd(path);
+    trace_record rec;
+    for (size_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(rd.next(rec));
+        EXPECT_EQ(rec.pc, pc + 4 * (i + 1));
+        EXPECT_EQ(le(rec.regs.data() + 8, 4), i + 1);
+    }
+}
+
+TEST_F(tracer_test, seek) {
+    tracer tr(*targ, { "r0" });
+    tr.set_index_interval(100);
+    ASSERT_EQ(tr.trace(path, 1000), 1000);
+
+    trace_reader rd(path);
+    trace_record rec;
+    for (size_t pos : { 777, 0, 999, 250, 251, 100 }) {
+        rd.seek(pos);
+        EXPECT_EQ(rd.position(), pos);
+        ASSERT_TRUE(rd.next(rec));
+        EXPECT_EQ(le(rec.regs.data(), 4), pos + 1);
+    }
+
+    rd.seek(1000);
+    EXPECT_FALSE(rd.next(rec));
+    EXPECT_THROW(rd.seek(1001), mwr::report);
+}
+
+TEST_F(tracer_test, trace_range) {
+    cpureg* pc = targ->find_reg("pc");
+    ASSERT_NE(pc, nullptr);
+    pc->set_value({ 0x00, 0x01, 0, 0, 0, 0, 0, 0 });
+
+    tracer tr(*targ);
+    EXPECT_EQ(tr.trace_range(path, 0x100, 0x120), 8);
+
+    trace_reader rd(path);
+    ASSERT_EQ(rd.size(), 8);
+    rd.seek(7);
+
+    trace_record rec;
+    ASSERT_TRUE(rd.next(rec));
+    EXPECT_EQ(rec.pc, 0x120);
+    EXPECT_TRUE(rec.regs.empty());
+}
+
+TEST_F(tracer_test, errors) {
+    EXPECT_THROW(tracer(*targ, { "nope" }), mwr::report);
+    EXPECT_THROW(trace_reader("/nonexistent/trace"), mwr::report);
+
+    tracer tr(*targ);
+    EXPECT_THROW(tr.set_index_interval(0), mwr::report);
+}
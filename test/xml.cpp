@@ -0,0 +1,132 @@
+/******************************************************************************
+ *                                                                            *
+ * Copyright (C) 2025 MachineWare GmbH                                        *
+ * All Rights Reserved                                                        *
+ *                                                                            *
+ * This work is licensed under the terms described in the LICENSE file found  *
+ * in the root directory of this source tree.                                 *
+ *                                                                            *
+ ******************************************************************************/
+
+
+#include "testing.h"
+
+using namespace testing;
+using namespace vsp;
+
+// logs all events in a compact form
+class recorder : public xml_reader
+{
+protected:
+    virtual void begin_element(string_view name,
+                               const xml_attrs& attrs) override {
+        log += "<" + string(name);
+        for (size_t i = 0; i < attrs.size(); i++)
+            log += mkstr(" #%zu", i);
+        log += ">";
+    }
+
+    virtual void end_element(string_view name) override {
+        log += "</" + string(name) + ">";
+    }
+
+    virtual void text(string_view text) override {
+        log += "[" + string(text) + "]";
+    }
+
+    virtual void end_document() override { log += "."; }
+
+public:
+    string log;
+};
+
+static string parse(const string& doc, size_t chunk) {
+    recorder rec;
+    for (size_t off = 0; off < doc.size(); off += chunk)
+        rec.feed(doc.data() + off, std::min(chunk, doc.size() - off));
+    rec.finish();
+    return rec.log;
+}
+
+TEST(xml, elements) {
+    const string doc = "<?xml version=\"1.0\"?>\n"
+                       "<a x=\"1\" y='2'>\n"
+                       "  <b/>\n"
+                       "  <c z = \"3\" >text</c >\n"
+                       "</a>\n";
+    const string log = "<a #0 #1><b></b><c #0>[text]</c></a>.";
+
+    EXPECT_EQ(parse(doc, doc.size()), log);
+    for (size_t chunk = 1; chunk < 8; chunk++)
+        EXPECT_EQ(parse(doc, chunk), log) << "chunk size " << chunk;
+}
+
+TEST(xml, attributes) {
+    struct checker : xml_reader {
+        vector<string> values;
+        u64 count = 0;
+
+        virtual void begin_element(string_view,
+                                   const xml_attrs& attrs) override {
+            values.emplace_back(attrs.get("a"));
+            values.emplace_back(attrs.get("b"));
+            values.emplace_back(attrs.get("missing"));
+            count = attrs.get_u64("n") + attrs.get_u64("h");
+        }
+    };
+
+    checker chk;
+    chk.feed("<e a=\"x &lt;&amp;&gt; &quot;y&apos;\" "
+             "b='&#65;&#x263a;&bogus; & &#xzz;' n=\"40\" h=\"0x2\" />");
+    chk.finish();
+
+    ASSERT_EQ(chk.values.size(), 3);
+    EXPECT_EQ(chk.values[0], "x <&> \"y'");
+    EXPECT_EQ(chk.values[1], "A\xe2\x98\xba&bogus; & &#xzz;");
+    EXPECT_EQ(chk.values[2], "");
+    EXPECT_EQ(chk.count, 42);
+}
+
+TEST(xml, markup) {
+    const string doc = "<!DOCTYPE a>"
+                       "<a v=\"x>y\"><!-- a > 'b' <c> --><!---->"
+                       "<![CDATA[<not> a tag]]><?pi > ?>"
+                       "<b w='\"'/>t&amp;t</a><!-- after -->";
+    const string log = "<a #0>[<not> a tag]<b #0></b>[t&t]</a>.";
+
+    // splitting the input anywhere must not make a difference
+    for (size_t split = 0; split <= doc.size(); split++) {
+        recorder rec;
+        rec.feed(doc.data(), split);
+        rec.feed(doc.data() + split, doc.size() - split);
+        rec.finish();
+        EXPECT_EQ(rec.log, log) << "split at " << split;
+    }
+}
+
+TEST(xml, errors) {
+    const char* docs[] = {
+        "",
+        "  <!-- only a comment -->",
+        "<a>",
+        "<a></b>",
+        "<a></a></a>",
+        "<a x></a>",
+        "<a x=1></a>",
+        "<a x=\"1></a>",
+        "<!-- open",
+        "< />",
+    };
+
+    recorder rec;
+    for (const char* doc : docs) {
+        rec.feed(doc);
+        EXPECT_THROW(rec.finish(), mwr::report) << doc;
+    }
+
+    // finish leaves the reader ready for the next document
+    rec.log.clear();
+    rec.feed("<ok/>");
+    rec.finish();
+    EXPECT_EQ(rec.log, "<ok></ok>.");
+}